@@ -47,6 +47,9 @@ uint8 *VPageG[8];
 uint8 *MMC5SPRVPage[8];
 uint8 *MMC5BGVPage[8];
 
+int32 PRGPageOffset[32];
+int32 CHRPageOffset[8];
+
 static uint8 PRGIsRAM[32];  /* This page is/is not PRG RAM. */
 
 /* 16 are (sort of) reserved for UNIF/iNES and 16 to map other stuff. */
@@ -81,6 +84,49 @@ uint32 genieaddr[3];
 
 CartInfo *currCartInfo;
 
+static void UpdatePRGPageOffset(int x) {
+	int chip = 0;
+	int32 base = 0;
+
+	if (GameInfo && GameInfo->type == GIT_FDS) {
+		if (x < (0xE000 >> 11))
+			chip = 1;
+		else
+			base = PRGsize[1];
+	}
+
+	PRGPageOffset[x] = -1;
+	if (Page[x] && PRGptr[chip]) {
+		ptrdiff_t offset = &Page[x][x << 11] - PRGptr[chip];
+		if (offset >= 0 && offset + 0x800 <= (ptrdiff_t)PRGsize[chip])
+			PRGPageOffset[x] = base + (int32)offset;
+	}
+}
+
+static void UpdateCHRPageOffset(int x) {
+	CHRPageOffset[x] = -1;
+	if (VPage[x] && CHRptr[0]) {
+		ptrdiff_t offset = &VPage[x][x << 10] - CHRptr[0];
+		if (offset >= 0 && offset + 0x400 <= (ptrdiff_t)CHRsize[0])
+			CHRPageOffset[x] = (int32)offset;
+	}
+}
+
+// Only VPage is rendered from; while the Game Genie holds it, setchr* lands in VPageG.
+static INLINE void UpdateCHRPageOffsets(uint32 A, int count) {
+	if (VPageR != VPage)
+		return;
+	for (int x = 0; x < count; x++)
+		UpdateCHRPageOffset((A >> 10) + x);
+}
+
+void FCEU_UpdatePageOffsets(void) {
+	for (int x = 0; x < 32; x++)
+		UpdatePRGPageOffset(x);
+	for (int x = 0; x < 8; x++)
+		UpdateCHRPageOffset(x);
+}
+
 static INLINE void setpageptr(int s, uint32 A, uint8 *p, int ram) {
 	uint32 AB = A >> 11;
 	int x;
@@ -95,6 +141,9 @@ static INLINE void setpageptr(int s, uint32 A, uint8 *p, int ram) {
 			PRGIsRAM[AB + x] = 0;
 			Page[AB + x] = 0;
 		}
+	for (x = (s >> 1) - 1; x >= 0; x--)
+		UpdatePRGPageOffset(AB + x);
+	FCEU_NoteWriteRange(A, A + (s << 10) - 1);
 }
 
 static uint8 nothing[8192];
@@ -111,6 +160,7 @@ void ResetCartMapping(void) {
 	for (x = 0; x < 8; x++) {
 		MMC5SPRVPage[x] = MMC5BGVPage[x] = VPageR[x] = nothing - 0x400 * x;
 	}
+	FCEU_UpdatePageOffsets();
 }
 
 void SetupCartPRGMapping(int chip, uint8 *p, uint32 size, int ram) {
@@ -124,6 +174,8 @@ void SetupCartPRGMapping(int chip, uint8 *p, uint32 size, int ram) {
 	PRGmask32[chip] = (size >> 15) - 1;
 
 	PRGram[chip] = ram ? 1 : 0;
+
+	FCEU_UpdatePageOffsets();
 }
 
 void SetupCartCHRMapping(int chip, uint8 *p, uint32 size, int ram) {
@@ -141,6 +193,8 @@ void SetupCartCHRMapping(int chip, uint8 *p, uint32 size, int ram) {
 	if (CHRmask8[chip] >= (unsigned int)(-1)) CHRmask8[chip] = 0;
 
 	CHRram[chip] = ram;
+
+	FCEU_UpdatePageOffsets();
 }
 
 DECLFR(CartBR) {
@@ -149,8 +203,10 @@ DECLFR(CartBR) {
 
 DECLFW(CartBW) {
 	//printf("Ok: %04x:%02x, %d\n",A,V,PRGIsRAM[A>>11]);
-	if (PRGIsRAM[A >> 11] && Page[A >> 11])
+	if (PRGIsRAM[A >> 11] && Page[A >> 11]) {
 		Page[A >> 11][A] = V;
+		FCEU_NoteWrite(A);
+	}
 }
 
 DECLFR(CartBROB) {
@@ -237,6 +293,7 @@ void setchr1r(int r, uint32 A, uint32 V) {
 	else
 		PPUCHRRAM &= ~(1 << (A >> 10));
 	VPageR[(A) >> 10] = &CHRptr[r][(V) << 10] - (A);
+	UpdateCHRPageOffsets(A, 1);
 }
 
 void setchr2r(int r, uint32 A, uint32 V) {
@@ -248,6 +305,7 @@ void setchr2r(int r, uint32 A, uint32 V) {
 		PPUCHRRAM |= (3 << (A >> 10));
 	else
 		PPUCHRRAM &= ~(3 << (A >> 10));
+	UpdateCHRPageOffsets(A, 2);
 }
 
 void setchr4r(int r, unsigned int A, unsigned int V) {
@@ -260,6 +318,7 @@ void setchr4r(int r, unsigned int A, unsigned int V) {
 		PPUCHRRAM |= (15 << (A >> 10));
 	else
 		PPUCHRRAM &= ~(15 << (A >> 10));
+	UpdateCHRPageOffsets(A, 4);
 }
 
 void setchr8r(int r, uint32 V) {
@@ -274,6 +333,7 @@ void setchr8r(int r, uint32 V) {
 		PPUCHRRAM |= (255);
 	else
 		PPUCHRRAM = 0;
+	UpdateCHRPageOffsets(0, 8);
 }
 
 void setchr1(uint32 A, uint32 V) {
@@ -507,6 +567,7 @@ void FixGenieMap(void) {
 		VPage[x] = VPageG[x];
 
 	VPageR = VPage;
+	FCEU_UpdatePageOffsets();
 	FlushGenieRW();
 	//printf("Rightyo\n");
 	for (x = 0; x < 3; x++)
@@ -536,6 +597,7 @@ void FCEU_GeniePower(void) {
 
 	for (x = 0; x < 8; x++)
 		VPage[x] = GENIEROM + 4096 - 0x400 * x;
+	FCEU_UpdatePageOffsets();
 
 	if (AllocGenieRW())
 		VPageR = VPageG;
@@ -88,6 +88,15 @@ void FCEU_ClearGameSave(CartInfo *LocalHWInfo);
 
 extern uint8 *Page[32], *VPage[8], *MMC5SPRVPage[8], *MMC5BGVPage[8];
 
+// Offset of each 2K CPU page into PRG ROM (chip 0, or the FDS BIOS and RAM as
+// the code/data logger lays them out) and of each 1K pattern page into CHR
+// chip 0, or -1 when the page is not backed by that memory.  Kept current by
+// the banking calls; code that points Page or VPage elsewhere must call
+// FCEU_UpdatePageOffsets().
+extern int32 PRGPageOffset[32];
+extern int32 CHRPageOffset[8];
+void FCEU_UpdatePageOffsets(void);
+
 void ResetCartMapping(void);
 void SetupCartPRGMapping(int chip, uint8 *p, uint32 size, int ram);
 void SetupCartCHRMapping(int chip, uint8 *p, uint32 size, int ram);
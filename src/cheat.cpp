@@ -25,6 +25,7 @@
 #include "fceu.h"
 #include "file.h"
 #include "cart.h"
+#include "memsearch.h"
 #include "driver.h"
 #include "utils/memory.h"
 
@@ -59,8 +60,10 @@ void FCEU_CheatAddRAM(int s, uint32 A, uint8 *p)
 }
 
 
-CHEATF_SUBFAST SubCheats[256];
+std::vector<CHEATF_SUBFAST> SubCheats;
 uint32 numsubcheats = 0;
+static uint16 SubCheatIndex[0x10000];	// SubCheats entry for each address using SubCheatsRead
+static std::vector<CHEATF_PERIODIC> PeriodicCheats;	// Enabled replace cheats, poked once per frame
 int globalCheatDisabled = 0;
 int disableAutoLSCheats = 0;
 bool disableShowGG = 0;
@@ -68,34 +71,28 @@ static _8BYTECHEATMAP* cheatMap = NULL;
 struct CHEATF *cheats = 0, *cheatsl = 0;
 
 
-#define CHEATC_NONE     0x8000
-#define CHEATC_EXCLUDED 0x4000
-#define CHEATC_NOSHOW   0xC000
-
-static uint16 *CheatComp = 0;
+static FCEU::MemSearch *CheatSearch = 0;
+static uint64 CheatSearchPages = 0;	// 1K pages that were mapped when the search began
 int savecheats = 0;
 
 static DECLFR(SubCheatsRead)
 {
-	CHEATF_SUBFAST *s = SubCheats;
-	int x=numsubcheats;
+	uint32 x=SubCheatIndex[A];
 
-	do
+	if(x<numsubcheats && SubCheats[x].addr==A)
 	{
-		if(s->addr==A)
+		CHEATF_SUBFAST *s = &SubCheats[x];
+
+		if(s->compare>=0)
 		{
-			if(s->compare>=0)
-			{
-				uint8 pv=s->PrevRead(A);
+			uint8 pv=s->PrevRead(A);
 
-				if(pv==s->compare)
-					return(s->val);
-				else return(pv);
-			}
-			else return(s->val);
+			if(pv==s->compare)
+				return(s->val);
+			else return(pv);
 		}
-		s++;
-	} while(--x);
+		else return(s->val);
+	}
 	return(0);	/* We should never get here. */
 }
 
@@ -111,24 +108,35 @@ void RebuildSubCheats(void)
 	}
 
 	numsubcheats = 0;
+	SubCheats.clear();
+	PeriodicCheats.clear();
 
-	if (!globalCheatDisabled)
+	while(c)
 	{
-		while(c)
+		if(c->type == 1 && c->status && !globalCheatDisabled && GetReadHandler(c->addr) != SubCheatsRead)
 		{
-			if(c->type == 1 && c->status && GetReadHandler(c->addr) != SubCheatsRead)
-			{
-				SubCheats[numsubcheats].PrevRead = GetReadHandler(c->addr);
-				SubCheats[numsubcheats].addr = c->addr;
-				SubCheats[numsubcheats].val = c->val;
-				SubCheats[numsubcheats].compare = c->compare;
-				SetReadHandler(c->addr, c->addr, SubCheatsRead);
-				if (cheatMap)
-					FCEUI_SetCheatMapByte(SubCheats[numsubcheats].addr, true);
-				numsubcheats++;
-			}
-			c = c->next;
+			CHEATF_SUBFAST s;
+
+			s.PrevRead = GetReadHandler(c->addr);
+			s.addr = c->addr;
+			s.val = c->val;
+			s.compare = c->compare;
+			SubCheats.push_back(s);
+			SubCheatIndex[s.addr] = numsubcheats;
+			SetReadHandler(c->addr, c->addr, SubCheatsRead);
+			if (cheatMap)
+				FCEUI_SetCheatMapByte(s.addr, true);
+			numsubcheats++;
+		}
+		else if(c->type == 0 && c->status)
+		{
+			CHEATF_PERIODIC p;
+
+			p.addr = c->addr;
+			p.val = c->val;
+			PeriodicCheats.push_back(p);
 		}
+		c = c->next;
 	}
 	FrozenAddressCount = numsubcheats;		//Update the frozen address list
 
@@ -311,10 +319,10 @@ void FCEU_SaveGameCheats(FILE* fp, int release)
 
 void FCEU_FlushGameCheats(FILE *override, int nosave)
 {
-	if(CheatComp)
+	if(CheatSearch)
 	{
-		free(CheatComp);
-		CheatComp=0;
+		delete CheatSearch;
+		CheatSearch=0;
 	}
 	if((!savecheats || nosave) && !override)	/* Always save cheats if we're being overridden. */
 	{
@@ -423,18 +431,18 @@ int FCEUI_DelCheat(uint32 which)
 
 void FCEU_ApplyPeriodicCheats(void)
 {
-	struct CHEATF *cur=cheats;
-	if(!cur) return;
+	const CHEATF_PERIODIC *p = PeriodicCheats.data();
+	size_t n = PeriodicCheats.size();
 
-	for(;;)
+	for(size_t x=0;x<n;x++)
 	{
-		if(cur->status && !(cur->type))
-			if(CheatRPtrs[cur->addr>>10])
-				CheatRPtrs[cur->addr>>10][cur->addr]=cur->val;
-		if(cur->next)
-			cur=cur->next;
-		else
-			break;
+		uint8 *ram=CheatRPtrs[p[x].addr>>10];
+
+		if(ram)
+		{
+			ram[p[x].addr]=p[x].val;
+			FCEU_NoteWrite(p[x].addr);
+		}
 	}
 }
 
@@ -650,50 +658,59 @@ int FCEUI_GlobalToggleCheat(int global_enabled)
 	return _numsubcheats != numsubcheats;
 }
 
-static int InitCheatComp(void)
+static int InitCheatSearch(void)
 {
+	CheatSearch = new FCEU::MemSearch();
+	CheatSearchPages = 0;
+	CheatSearch->clearCandidates();
+
+	return(1);
+}
+
+// Copy the pages visible to cheats into the search snapshot and drop candidates on unmapped pages
+static void CheatSearchSnapshot(void)
+{
+	uint8 *cur = CheatSearch->current();
 	uint32 x;
 
-	CheatComp=(uint16*)FCEU_dmalloc(65536*sizeof(uint16));
-	if(!CheatComp)
+	for(x=0;x<64;x++)
 	{
-		CheatMemErr();
-		return(0);
+		if(CheatRPtrs[x])
+			memcpy(cur+(x<<10), CheatRPtrs[x]+(x<<10), 1024);
+		else
+			CheatSearch->removeCandidates(x<<10, (x+1)<<10);
 	}
-	for(x=0;x<65536;x++)
-		CheatComp[x]=CHEATC_NONE;
-
-	return(1);
 }
 
 void FCEUI_CheatSearchSetCurrentAsOriginal(void)
 {
 	uint32 x;
 
-	if(!CheatComp)
+	if(!CheatSearch)
 	{
-		if(InitCheatComp())
+		if(InitCheatSearch())
 		{
 			CheatMemErr();
 			return;
 		}
 	}
-	for(x=0x000;x<0x10000;x++)
-		if(!(CheatComp[x]&CHEATC_NOSHOW))
-		{
-			if(CheatRPtrs[x>>10])
-				CheatComp[x]=CheatRPtrs[x>>10][x];
-			else
-				CheatComp[x]|=CHEATC_NONE;
-		}
+	for(x=0;x<64;x++)
+		if(!CheatRPtrs[x])
+			CheatSearchPages&=~(1ULL<<x);
+	CheatSearchSnapshot();
+	CheatSearch->commitPrevious();
 }
 
 void FCEUI_CheatSearchShowExcluded(void)
 {
 	uint32 x;
 
-	for(x=0x000;x<0x10000;x++)
-		CheatComp[x]&=~CHEATC_EXCLUDED;
+	if(!CheatSearch)
+		return;
+	CheatSearch->clearCandidates();
+	for(x=0;x<64;x++)
+		if(CheatSearchPages&(1ULL<<x))
+			CheatSearch->addCandidates(x<<10, (x+1)<<10, 1);
 }
 
 
@@ -701,11 +718,11 @@ int32 FCEUI_CheatSearchGetCount(void)
 {
 	uint32 x,c=0;
 
-	if(CheatComp)
+	if(CheatSearch)
 	{
-		for(x=0x0000;x<0x10000;x++)
-			if(!(CheatComp[x]&CHEATC_NOSHOW) && CheatRPtrs[x>>10])
-				c++;
+		for(x=0;x<64;x++)
+			if(CheatRPtrs[x])
+				c+=CheatSearch->count(x<<10, (x+1)<<10);
 	}
 
 	return c;
@@ -714,38 +731,42 @@ int32 FCEUI_CheatSearchGetCount(void)
 
 void FCEUI_CheatSearchGet(int (*callb)(uint32 a, uint8 last, uint8 current, void *data),void *data)
 {
-	uint32 x;
+	const uint8 *orig;
+	int x;
 
-	if(!CheatComp)
+	if(!CheatSearch)
 	{
-		if(!InitCheatComp())
+		if(!InitCheatSearch())
 			CheatMemErr();
 		return;
 	}
 
-	for(x=0;x<0x10000;x++)
-		if(!(CheatComp[x]&CHEATC_NOSHOW) && CheatRPtrs[x>>10])
-			if(!callb(x,CheatComp[x],CheatRPtrs[x>>10][x],data))
+	orig=CheatSearch->previous();
+	for(x=CheatSearch->next(0);x>=0;x=CheatSearch->next(x+1))
+		if(CheatRPtrs[x>>10])
+			if(!callb(x,orig[x],CheatRPtrs[x>>10][x],data))
 				break;
 }
 
 void FCEUI_CheatSearchGetRange(uint32 first, uint32 last, int (*callb)(uint32 a, uint8 last, uint8 current))
 {
-	uint32 x;
+	const uint8 *orig;
 	uint32 in = 0;
+	int x;
 
-	if(!CheatComp)
+	if(!CheatSearch)
 	{
-		if(!InitCheatComp())
+		if(!InitCheatSearch())
 			CheatMemErr();
 		return;
 	}
 
-	for(x = 0; x < 0x10000; x++)
-		if(!(CheatComp[x] & CHEATC_NOSHOW) && CheatRPtrs[x >> 10])
+	orig = CheatSearch->previous();
+	for(x = CheatSearch->next(0); x >= 0; x = CheatSearch->next(x + 1))
+		if(CheatRPtrs[x >> 10])
 		{
 			if(in >= first)
-				if(!callb(x, CheatComp[x], CheatRPtrs[x >> 10][x]))
+				if(!callb(x, orig[x], CheatRPtrs[x >> 10][x]))
 					break;
 			in++;
 			if(in > last)
@@ -757,91 +778,76 @@ void FCEUI_CheatSearchBegin(void)
 {
 	uint32 x;
 
-	if(!CheatComp)
+	if(!CheatSearch)
 	{
-		if(!InitCheatComp())
+		if(!InitCheatSearch())
 		{
 			CheatMemErr();
 			return;
 		}
 	}
-	for(x=0;x<0x10000;x++)
+	CheatSearchPages=0;
+	CheatSearch->clearCandidates();
+	for(x=0;x<64;x++)
 	{
-		if(CheatRPtrs[x>>10])
-			CheatComp[x]=CheatRPtrs[x>>10][x];
-		else
-			CheatComp[x]=CHEATC_NONE;
+		if(CheatRPtrs[x])
+		{
+			CheatSearchPages|=1ULL<<x;
+			CheatSearch->addCandidates(x<<10, (x+1)<<10, 1);
+		}
 	}
+	CheatSearchSnapshot();
+	CheatSearch->reset();
 }
 
 
-static int INLINE CAbs(int x)
-{
-	if(x<0)
-		return(0-x);
-	return x;
-}
-
 void FCEUI_CheatSearchEnd(int type, uint8 v1, uint8 v2)
 {
-	uint32 x;
+	typedef FCEU::MemSearch S;
 
-	if(!CheatComp)
+	if(!CheatSearch)
 	{
-		if(!InitCheatComp())
+		if(!InitCheatSearch())
 		{
 			CheatMemErr();
 			return;
 		}
 	}
 
+	// The original values are the search's previous snapshot
+	CheatSearchSnapshot();
+
 	switch (type)
 	{
 		default:
 		case FCEU_SEARCH_SPECIFIC_CHANGE: // Change to a specific value
-			for (x = 0; x < 0x10000; ++x)
-				if (!(CheatComp[x] & CHEATC_NOSHOW) && (CheatComp[x] != v1 || CheatRPtrs[x >> 10][x] != v2))
-					CheatComp[x] |= CHEATC_EXCLUDED;
+			CheatSearch->filter(S::OP_EQ, S::PREVIOUS, S::VALUE, v1);
+			CheatSearch->filter(S::OP_EQ, S::CURRENT, S::VALUE, v2);
 			break;
 		case FCEU_SEARCH_RELATIVE_CHANGE: // Search for relative change (between values).
-			for (x = 0; x < 0x10000; x++)
-				if (!(CheatComp[x] & CHEATC_NOSHOW) && (CheatComp[x] != v1 || CAbs(CheatComp[x] - CheatRPtrs[x >> 10][x]) != v2))
-					CheatComp[x] |= CHEATC_EXCLUDED;
+			CheatSearch->filter(S::OP_EQ, S::PREVIOUS, S::VALUE, v1);
+			CheatSearch->filter(S::OP_DIFFBY, S::CURRENT, S::PREVIOUS, 0, v2);
 			break;
 		case FCEU_SEARCH_PUERLY_RELATIVE_CHANGE: // Purely relative change.
-			for (x = 0x000; x<0x10000; x++)
-				if (!(CheatComp[x] & CHEATC_NOSHOW) && CAbs(CheatComp[x] - CheatRPtrs[x >> 10][x]) != v2)
-					CheatComp[x] |= CHEATC_EXCLUDED;
+			CheatSearch->filter(S::OP_DIFFBY, S::CURRENT, S::PREVIOUS, 0, v2);
 			break;
 		case FCEU_SEARCH_ANY_CHANGE: // Any change.
-			for (x = 0x000; x < 0x10000; x++)
-				if (!(CheatComp[x] & CHEATC_NOSHOW) && CheatComp[x] == CheatRPtrs[x >> 10][x])
-					CheatComp[x] |= CHEATC_EXCLUDED;
+			CheatSearch->filter(S::OP_NE, S::CURRENT, S::PREVIOUS);
 			break;
 		case FCEU_SEARCH_NEWVAL_KNOWN: // new value = known
-			for (x = 0x000; x < 0x10000; x++)
-				if (!(CheatComp[x] & CHEATC_NOSHOW) && CheatRPtrs[x >> 10][x] != v1)
-					CheatComp[x] |= CHEATC_EXCLUDED;
+			CheatSearch->filter(S::OP_EQ, S::CURRENT, S::VALUE, v1);
 			break;
 		case FCEU_SEARCH_NEWVAL_GT: // new value greater than
-			for (x = 0x000; x < 0x10000; x++)
-				if (!(CheatComp[x] & CHEATC_NOSHOW) && CheatComp[x] >= CheatRPtrs[x >> 10][x])
-					CheatComp[x] |= CHEATC_EXCLUDED;
+			CheatSearch->filter(S::OP_GT, S::CURRENT, S::PREVIOUS);
 			break;
 		case FCEU_SEARCH_NEWVAL_LT: // new value less than
-			for (x = 0x000; x < 0x10000; x++)
-				if (!(CheatComp[x] & CHEATC_NOSHOW) && CheatComp[x] <= CheatRPtrs[x >> 10][x])
-					CheatComp[x] |= CHEATC_EXCLUDED;
+			CheatSearch->filter(S::OP_LT, S::CURRENT, S::PREVIOUS);
 			break;
 		case FCEU_SEARCH_NEWVAL_GT_KNOWN: // new value greater than by known value
-			for (x = 0x000; x < 0x10000; x++)
-				if (!(CheatComp[x] & CHEATC_NOSHOW) && CheatRPtrs[x >> 10][x] - CheatComp[x] != v2)
-					CheatComp[x] |= CHEATC_EXCLUDED;
+			CheatSearch->filter(S::OP_SUBBY, S::CURRENT, S::PREVIOUS, 0, v2);
 			break;
 		case FCEU_SEARCH_NEWVAL_LT_KNOWN: // new value less than by known value
-			for (x = 0x000; x < 0x10000; x++)
-				if (!(CheatComp[x] & CHEATC_NOSHOW) && (CheatComp[x] - CheatRPtrs[x >> 10][x]) != v2)
-					CheatComp[x] |= CHEATC_EXCLUDED;
+			CheatSearch->filter(S::OP_SUBBY, S::PREVIOUS, S::CURRENT, 0, v2);
 			break;
 	}
 
@@ -862,7 +868,10 @@ int FCEU_CheatGetByte(uint32 A)
 void FCEU_CheatSetByte(uint32 A, uint8 V)
 {
    if(CheatRPtrs[A>>10])
+   {
     CheatRPtrs[A>>10][A]=V;
+    FCEU_NoteWrite(A);
+   }
    else if(A < 0x10000)
     BWrite[A](A, V);
 }
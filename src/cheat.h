@@ -46,6 +46,13 @@ struct CHEATF_SUBFAST
 	}
 };
 
+// Replace (RAM poke) cheat, flattened out of the CHEATF list
+struct CHEATF_PERIODIC
+{
+	uint16 addr;
+	uint8 val;
+};
+
 struct CHEATF {
 	struct CHEATF *next;
 	std::string name;
@@ -511,6 +511,81 @@ static Condition* Connect(const char** str)
 	return InfixOperator(str, Compare, ConnectOperators);
 }
 
+static void emitTransform(unsigned int type, CondProgram& prog)
+{
+	CondInstr in = { 0, 0 };
+	switch (type)
+	{
+		case TYPE_ADDR: in.op = CONDOP_MEM; break;
+		case TYPE_PC_BANK: in.op = CONDOP_PC_BANK; break;
+		case TYPE_DATA_BANK: in.op = CONDOP_DATA_BANK; break;
+		case TYPE_VALUE_READ: in.op = CONDOP_VALUE_READ; break;
+		case TYPE_VALUE_WRITE: in.op = CONDOP_VALUE_WRITE; break;
+		default: return;
+	}
+	prog.code.push_back(in);
+}
+
+// Emits c in the order evaluate() in debug.cpp computes it; returns the stack depth it needs
+static int emitCondition(Condition* c, CondProgram& prog)
+{
+	CondInstr in = { 0, 0 };
+	int depth;
+
+	if (c->lhs)
+	{
+		depth = emitCondition(c->lhs, prog);
+	}
+	else
+	{
+		in.op = (c->type1 == TYPE_ADDR || c->type1 == TYPE_NUM) ? CONDOP_PUSH : CONDOP_GETVALUE;
+		in.value = c->value1;
+		prog.code.push_back(in);
+		depth = 1;
+	}
+	emitTransform(c->type1, prog);
+
+	if (c->op)
+	{
+		int depth2;
+		if (c->rhs)
+		{
+			depth2 = emitCondition(c->rhs, prog);
+		}
+		else
+		{
+			// evaluate() looks up type2 rather than value2 here
+			in.op = (c->type2 == TYPE_ADDR || c->type2 == TYPE_NUM) ? CONDOP_PUSH : CONDOP_GETVALUE;
+			in.value = in.op == CONDOP_PUSH ? c->value2 : c->type2;
+			prog.code.push_back(in);
+			depth2 = 1;
+		}
+		emitTransform(c->type2, prog);
+
+		in.op = c->op;
+		in.value = 0;
+		prog.code.push_back(in);
+
+		if (depth2 + 1 > depth)
+			depth = depth2 + 1;
+	}
+
+	return depth;
+}
+
+bool compileCondition(Condition* c, CondProgram& prog)
+{
+	prog.code.clear();
+	prog.source = c;
+
+	if (c && emitCondition(c, prog) <= CONDITION_STACK_SIZE)
+		return true;
+
+	prog.code.clear();
+	prog.source = nullptr;
+	return false;
+}
+
 /* Root of the parser generator */
 Condition* generateCondition(const char* str)
 {
@@ -21,6 +21,8 @@
 #ifndef CONDDEBUG_H
 #define CONDDEBUG_H
 
+#include <vector>
+
 #define TYPE_NO 0
 #define TYPE_REG 1
 #define TYPE_FLAG 2
@@ -85,4 +87,31 @@ struct Condition
 
 Condition* generateCondition(const char* str);
 
+// Flat form of a Condition tree: postfix code for a stack machine, run by the debugger
+// instead of walking the tree. The binary operators use the OP_ values above.
+#define CONDOP_PUSH 0x10		// push value
+#define CONDOP_GETVALUE 0x11	// push getValue(value)
+#define CONDOP_MEM 0x12			// replace the top with the memory byte it addresses
+#define CONDOP_PC_BANK 0x13		// replace the top with the bank of PC
+#define CONDOP_DATA_BANK 0x14	// replace the top with the bank of the last accessed address
+#define CONDOP_VALUE_READ 0x15	// replace the top with the value read by the instruction
+#define CONDOP_VALUE_WRITE 0x16	// replace the top with the value written by the instruction
+
+#define CONDITION_STACK_SIZE 32
+
+struct CondInstr
+{
+	unsigned int op;
+	unsigned int value;
+};
+
+struct CondProgram
+{
+	std::vector<CondInstr> code;
+	Condition* source;	// the tree this was compiled from
+};
+
+// Returns false if the condition needs more than CONDITION_STACK_SIZE stack entries.
+bool compileCondition(Condition* c, CondProgram& prog);
+
 #endif
@@ -9,6 +9,9 @@
 #include "debugsymboltable.h"
 #include "driver.h"
 #include "ppu.h"
+#ifdef _S9XLUA_H
+#include "fceulua.h"
+#endif
 
 #include "x6502abbrev.h"
 
@@ -140,6 +143,8 @@ int checkCondition(const char* condition, int num)
 {
 	const char* b = condition;
 
+	FCEUI_BreakpointsChanged();
+
 	// Check if the condition isn't just all spaces.
 
 	int onlySpaces = 1;
@@ -213,6 +218,8 @@ int checkCondition(const char* condition, int num)
 **/
 unsigned int NewBreak(const char* name, int start, int end, unsigned int type, const char* condition, unsigned int num, bool enable)
 {
+	FCEUI_BreakpointsChanged();
+
 	// Finally add breakpoint to the list
 	watchpoint[num].address = start;
 	watchpoint[num].endaddress = 0;
@@ -252,30 +259,12 @@ unsigned int NewBreak(const char* name, int start, int end, unsigned int type, c
 }
 
 int GetPRGAddress(int A){
-	int result;
-	if(A > 0xFFFF)
+	if((A < 0) || (A > 0xFFFF))
 		return -1;
-	if (GameInfo->type == GIT_FDS) {
-		if (A < 0xE000) {
-			result = &Page[A >> 11][A] - PRGptr[1];
-			if ((result > (int)PRGsize[1]) || (result < 0))
-				return -1;
-			else
-				return result;
-		} else {
-			result = &Page[A >> 11][A] - PRGptr[0];
-			if ((result > (int)PRGsize[0]) || (result < 0))
-				return -1;
-			else
-				return result + PRGsize[1];
-		}
-	} else {
-		result = &Page[A >> 11][A] - PRGptr[0];
-		if ((result > (int)PRGsize[0]) || (result < 0))
-			return -1;
-		else
-			return result;
-	}
+	int result = PRGPageOffset[A >> 11];
+	if (result < 0)
+		return -1;
+	return result + (A & 0x7FF);
 }
 
 /**
@@ -476,9 +465,66 @@ int evaluate(Condition* c)
 	return f;
 }
 
+// Runs a condition compiled by compileCondition; same result as evaluate() on its source
+static int evaluateProgram(const CondProgram& prog)
+{
+	int stack[CONDITION_STACK_SIZE];
+	int sp = -1;
+
+	for (const CondInstr* in = prog.code.data(), *end = in + prog.code.size(); in < end; in++)
+	{
+		switch (in->op)
+		{
+			case CONDOP_PUSH: stack[++sp] = in->value; break;
+			case CONDOP_GETVALUE: stack[++sp] = getValue(in->value); break;
+			case CONDOP_MEM: stack[sp] = GetMem(stack[sp]); break;
+			case CONDOP_PC_BANK: stack[sp] = getBank(_PC); break;
+			case CONDOP_DATA_BANK: stack[sp] = getBank(debugLastAddress); break;
+			case CONDOP_VALUE_READ: stack[sp] = GetMem(debugLastAddress); break;
+			case CONDOP_VALUE_WRITE: stack[sp] = evaluateWrite(debugLastOpcode, debugLastAddress); break;
+			default:
+			{
+				int value2 = stack[sp--];
+				int& f = stack[sp];
+				switch (in->op)
+				{
+					case OP_EQ: f = f == value2; break;
+					case OP_NE: f = f != value2; break;
+					case OP_GE: f = f >= value2; break;
+					case OP_LE: f = f <= value2; break;
+					case OP_G: f = f > value2; break;
+					case OP_L: f = f < value2; break;
+					case OP_MULT: f = f * value2; break;
+					case OP_DIV: f = (value2==0) ? 0 : (f / value2); break;
+					case OP_PLUS: f = f + value2; break;
+					case OP_MINUS: f = f - value2; break;
+					case OP_OR: f = f || value2; break;
+					case OP_AND: f = f && value2; break;
+				}
+				break;
+			}
+		}
+	}
+
+	return stack[0];
+}
+
+// compiled conditions of watchpoint[0..numWPs), see BuildBreakpointTables
+static CondProgram bpConditions[64];
+static bool bpTablesDirty = true;
+static int bpTablesCount = -1;
+
 int condition(watchpointinfo* wp)
 {
-	return wp->cond == 0 || evaluate(wp->cond);
+	if (wp->cond == 0)
+		return 1;
+
+	int num = (int)(wp - watchpoint);
+	// the source pointer alone can match a freshly allocated tree at a reused address
+	if (!bpTablesDirty && bpTablesCount == numWPs && num >= 0 && num < numWPs && bpConditions[num].source == wp->cond)
+		return evaluateProgram(bpConditions[num]);
+
+	return evaluate(wp->cond);
 }
 
 
@@ -520,8 +566,10 @@ void LogCDData(uint8 *opcode, uint16 A, int size)
 	uint8 memop = 0;
 	bool newCodeHit = false, newDataHit = false;
 
-	if ((j = GetPRGAddress(_PC)) != -1)
+	//PRGPageOffset is kept current by the banking calls, so each access is one lookup
+	if ((j = PRGPageOffset[_PC >> 11]) >= 0)
 	{
+		j += _PC & 0x7FF;
 		for (i = 0; i < size; i++)
 		{
 			if (cdloggerdata[j+i] & 1) continue; //this has been logged so skip
@@ -546,8 +594,9 @@ void LogCDData(uint8 *opcode, uint16 A, int size)
 		case 4: memop = 0x20; break;
 	}
 
-	if ((j = GetPRGAddress(A)) != -1)
+	if ((j = PRGPageOffset[A >> 11]) >= 0)
 	{
+		j += A & 0x7FF;
 		if (opwrite[opcode[0]] == 0)
 		{
 			if (!(cdloggerdata[j] & 2))
@@ -634,6 +683,29 @@ void IncrementInstructionsCounters()
 	delta_instructions++;
 }
 
+static int debugHookUsers = 0;
+
+void FCEUI_SetDebugHookUser(int user, bool active)
+{
+	if (active)
+		debugHookUsers |= user;
+	else
+		debugHookUsers &= ~user;
+}
+
+bool DebugCycleRequired()
+{
+	if (debugHookUsers || debug_loggingCD || numWPs || break_asap || break_on_cycles || break_on_instructions)
+		return true;
+	if (dbgstate.step || dbgstate.runline || dbgstate.stepout || dbgstate.badopbreak || watchpoint[64].flags)
+		return true;
+#ifdef _S9XLUA_H
+	if (FCEU_LuaMemHooksActive())
+		return true;
+#endif
+	return false;
+}
+
 bool CondForbidTest(int bp_num) {
 	if (bp_num >= 0 && !condition(&watchpoint[bp_num]))
 	{
@@ -674,6 +746,133 @@ void BreakHit(int bp_num)
 int StackAddrBackup;
 uint16 StackNextIgnorePC = 0xFFFF;
 
+// Breakpoint lookup tables, so that breakpoint() only walks watchpoint[] when some breakpoint can match.
+// Each map has a bit per CPU address, set for the enabled CPU breakpoints covering it:
+static uint32 bpExecMap[0x10000 / 32];		// with WP_X, tested against PC
+static uint32 bpAccessMap[0x10000 / 32];	// with WP_X and WP_R/WP_W, tested against the operand address of any opcode
+static uint32 bpReadMap[0x10000 / 32];		// with WP_R but not WP_X, tested against the operand address of reads
+static uint32 bpWriteMap[0x10000 / 32];		// with WP_W but not WP_X, tested against the operand address of writes
+static std::vector<uint32> bpRomAddresses;	// single address ROM breakpoints with WP_X, tested against the ROM offset of PC
+static bool bpPPU, bpSprite;				// any enabled PPU / sprite memory breakpoint
+// per opbrktype (indexed by (brk_type >> 1) & 3): any enabled CPU breakpoint sharing no flag with it,
+// which breakpoint() checks against stack accesses, and any of those covering the stack page
+static bool bpUntyped[4], bpStackUntyped[4];
+
+void FCEUI_BreakpointsChanged()
+{
+	bpTablesDirty = true;
+}
+
+static void SetBreakpointBits(uint32* map, uint32 start, uint32 end)
+{
+	for (uint32 a = start; a <= end; a++)
+		map[a >> 5] |= 1 << (a & 31);
+}
+
+static INLINE bool TestBreakpointBit(const uint32* map, uint32 a)
+{
+	return (map[a >> 5] >> (a & 31)) & 1;
+}
+
+static void BuildBreakpointTables()
+{
+	memset(bpExecMap, 0, sizeof(bpExecMap));
+	memset(bpAccessMap, 0, sizeof(bpAccessMap));
+	memset(bpReadMap, 0, sizeof(bpReadMap));
+	memset(bpWriteMap, 0, sizeof(bpWriteMap));
+	bpRomAddresses.clear();
+	bpPPU = bpSprite = false;
+	memset(bpUntyped, 0, sizeof(bpUntyped));
+	memset(bpStackUntyped, 0, sizeof(bpStackUntyped));
+
+	for (int i = 0; i < 64; i++)
+	{
+		if (i < numWPs && watchpoint[i].cond)
+			compileCondition(watchpoint[i].cond, bpConditions[i]);
+		else
+			compileCondition(nullptr, bpConditions[i]);
+	}
+
+	for (int i = 0; i < numWPs; i++)
+	{
+		const watchpointinfo& wp = watchpoint[i];
+		if (!(wp.flags & WP_E))
+			continue;
+		if (wp.flags & BT_P)
+		{
+			bpPPU = true;
+			continue;
+		}
+		if (wp.flags & BT_S)
+		{
+			bpSprite = true;
+			continue;
+		}
+
+		uint32 start = wp.address;
+		uint32 end = wp.endaddress ? wp.endaddress : wp.address;
+		if (end > 0xFFFF)
+			end = 0xFFFF;
+
+		if ((wp.flags & BT_R) && !wp.endaddress)
+		{
+			if (wp.flags & WP_X)
+				bpRomAddresses.push_back(wp.address);
+		} else if (start <= end)
+		{
+			if (wp.flags & WP_X)
+			{
+				SetBreakpointBits(bpExecMap, start, end);
+				if (wp.flags & (WP_R | WP_W))
+					SetBreakpointBits(bpAccessMap, start, end);
+			} else
+			{
+				if (wp.flags & WP_R)
+					SetBreakpointBits(bpReadMap, start, end);
+				if (wp.flags & WP_W)
+					SetBreakpointBits(bpWriteMap, start, end);
+			}
+		}
+
+		for (int k = 0; k < 4; k++)
+		{
+			if (wp.flags & (WP_X | (k << 1)))
+				continue;
+			bpUntyped[k] = true;
+			if ((wp.flags & (WP_R | WP_W)) && wp.address <= 0x1FF && (wp.endaddress ? wp.endaddress : wp.address) >= 0x100)
+				bpStackUntyped[k] = true;
+		}
+	}
+
+	bpTablesDirty = false;
+	bpTablesCount = numWPs;
+}
+
+// Whether any breakpoint in watchpoint[0..numWPs) can match this instruction
+static bool BreakpointCandidate(uint8 brk_type, uint16 A, uint8 stackop)
+{
+	if (TestBreakpointBit(bpExecMap, _PC) || TestBreakpointBit(bpAccessMap, A))
+		return true;
+	if ((brk_type & WP_R) && TestBreakpointBit(bpReadMap, A))
+		return true;
+	if ((brk_type & WP_W) && TestBreakpointBit(bpWriteMap, A))
+		return true;
+	if (bpPPU && (A >= 0x2000) && (A < 0x4000) && ((A&7) == 7))
+		return true;
+	if (bpSprite && (((A >= 0x2000) && (A < 0x4000) && ((A&7) == 4)) || (A == 0x4014)))
+		return true;
+	if (bpStackUntyped[(brk_type >> 1) & 3] && (stackop || X.S != StackAddrBackup))
+		return true;
+	if (!bpRomAddresses.empty())
+	{
+		uint32 romAddrPC = GetNesFileAddress(_PC);
+		for (size_t i = 0; i < bpRomAddresses.size(); i++)
+			if (bpRomAddresses[i] == romAddrPC)
+				return true;
+	}
+	return false;
+}
+
 ///fires a breakpoint
 static void breakpoint(uint8 *opcode, uint16 A, int size) {
 	int i, romAddrPC;
@@ -742,8 +941,6 @@ static void breakpoint(uint8 *opcode, uint16 A, int size) {
 		return;
 	}
 
-	romAddrPC = GetNesFileAddress(_PC);
-
 	brk_type = opbrktype[opcode[0]] | WP_X;
 
 	switch (opcode[0]) {
@@ -762,6 +959,20 @@ static void breakpoint(uint8 *opcode, uint16 A, int size) {
 		default: break;
 	}
 
+	if (bpTablesDirty || bpTablesCount != numWPs)
+		BuildBreakpointTables();
+
+	if (!BreakpointCandidate(brk_type, A, stackop))
+	{
+		// nothing can match, but keep the bookkeeping the loop below does
+		if (bpUntyped[(brk_type >> 1) & 3] && StackNextIgnorePC == _PC)
+			StackNextIgnorePC = 0xFFFF;
+		StackAddrBackup = X.S;
+		return;
+	}
+
+	romAddrPC = GetNesFileAddress(_PC);
+
 #define BREAKHIT(x) { if (CondForbidTest(x)) { breakHit = (x); goto STOPCHECKING; } }
 	int breakHit = -1;
 	for (i = 0; i < numWPs; i++)
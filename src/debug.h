@@ -99,6 +99,9 @@ extern uint32 iapoffset; //mbg merge 7/18/06 changed from int
 void DebugCycle();
 bool CondForbidTest(int bp_num);
 void BreakHit(int bp_num);
+//the debugger core keeps lookup tables of the enabled breakpoints and their compiled conditions.
+//NewBreak, checkCondition and changes of numWPs refresh them; call this after editing watchpoint[] in any other way.
+void FCEUI_BreakpointsChanged();
 
 extern bool break_asap;
 extern bool break_on_unlogged_code;
@@ -118,6 +121,15 @@ extern void ResetDebugStatisticsDeltaCounters();
 extern void IncrementInstructionsCounters();
 //-------------
 
+//--------instrumented cpu loop
+//front-end tools which need DebugCycle() to run on every instruction register themselves here
+#define DBGHOOK_DEBUGGER   0x01
+#define DBGHOOK_TRACER     0x02
+void FCEUI_SetDebugHookUser(int user, bool active);
+//true when anything (tools, breakpoints, CDL, lua memory hooks) needs X6502_RunDebug instead of the fast loop
+bool DebugCycleRequired();
+//-------------
+
 //internal variables that debuggers will want access to
 extern uint8 *vnapage[4],*VPage[8];
 extern uint8 PPU[4],PALRAM[0x20],UPALRAM[3],SPRAM[0x100],VRAMBuffer,PPUGenLatch,XOffset;
@@ -234,8 +234,23 @@ void FCEUI_CheatSearchSetCurrentAsOriginal(void);
 void FCEUI_SetDirOverride(int which, char *n);
 
 void FCEUI_MemDump(uint16 a, int32 len, void (*callb)(uint16 a, uint8 v));
-uint8 FCEUI_MemSafePeek(uint16 A);
 void FCEUI_MemPoke(uint16 a, uint8 v, int hl);
+
+//Side-effect-free CPU bus reads for tools that sample many addresses per frame.
+//FCEUI_MemPeekPtr() returns a pointer to the byte at A when its page is plain memory (RAM,
+//or PRG/WRAM read through the cart page table), NULL when only its read handler can serve it.
+//FCEUI_MemSafePeek() falls back to a debugger read, which doesn't touch PPU/APU/input state.
+//FCEUI_MemPeekBlock() copies len bytes starting at A, a page at a time.
+uint8 *FCEUI_MemPeekPtr(uint16 A);
+uint8 FCEUI_MemSafePeek(uint16 A);
+void FCEUI_MemPeekBlock(uint16 A, uint8 *dest, uint32 len);
+
+//Write generations for tool windows that mirror CPU memory. FCEUI_MemWriteGeneration()
+//ends the current generation and returns it. FCEUI_MemChangedPages() then sets changed[p]
+//for each of the 256 pages that may differ since that generation (written, bank switched,
+//or not plain memory) and returns how many there are.
+uint32 FCEUI_MemWriteGeneration(void);
+int FCEUI_MemChangedPages(uint32 gen, uint8 *changed);
 void FCEUI_NMI(void);
 void FCEUI_IRQ(void);
 uint16 FCEUI_Disassemble(void *XA, uint16 a, char *stringo);
@@ -40,11 +40,13 @@
 #include <QHeaderView>
 #include <QMessageBox>
 #include <QInputDialog>
+#include <QSemaphore>
 
 #include "fceu.h"
 #include "driver.h"
 #include "version.h"
 #include "common/os_utils.h"
+#include "common/vidblit.h"
 
 #ifdef _USE_X264
 #include "x264.h"
@@ -79,19 +81,44 @@ extern "C"
 static gwavi_t  *gwavi = NULL;
 static bool      recordEnable = false;
 static bool      recordAudio  = true;
-static int       vbufHead = 0;
-static int       vbufTail = 0;
-static int       vbufSize = 0;
 static int       abufHead = 0;
 static int       abufTail = 0;
 static int       abufSize = 0;
-static uint32_t *rawVideoBuf = NULL;
 static int16_t  *rawAudioBuf = NULL;
 static int       aviDriver = 0;
 static int       videoFormat = AVI_RGB24;
 static int       audioSampleRate = 48000;
 static FILE     *avLogFp = NULL;
 
+// Video frames are handed to the disk thread in whole-frame slots of a
+// preallocated pool.  For the plain and prescale video modes a slot holds
+// the 8-bit NES frame and its deemphasis bits, and the disk thread does the
+// palette lookup and resize; otherwise it holds the blitted RGB frame.
+#define  AVI_VIDEO_SLOTS  64
+
+struct aviVideoSlot_t
+{
+	int       indexed;   // pix/deemph are valid, else rgb
+	int       scale;     // point-resize factor for indexed frames
+	int       width;     // indexed source size, before resizing
+	int       height;
+	int       palUpdate; // pal holds a new palette
+	int       numPixels; // output frame size
+	uint32_t  pal[256+512];
+	uint8_t   pix[256*256];
+	uint8_t   deemph[256*256];
+	uint32_t *rgb;       // allocated the first time the slot takes an RGB frame
+	int       rgbSize;
+};
+
+static aviVideoSlot_t *videoSlot = NULL;
+static int        vslotHead = 0;
+static int        vslotTail = 0;
+static QSemaphore vslotFree;
+static QSemaphore vslotUsed;
+static uint32_t   vslotPalVersion = 0;
+static bool       vslotPalSent = false;
+
 //**************************************************************************************
 
 static void convertRgb_32_to_24( const unsigned char *src, unsigned char *dest, int w, int h, int nPix, bool verticalFlip )
@@ -1971,7 +1998,7 @@ static int encode_audio_frame( int16_t *audioOut, int numSamples)
 	return 0;
 }
 
-static int encode_video_frame( unsigned char *inBuf )
+static int encode_video_frame( const unsigned char *inBuf )
 {
 	int ret, y, ofs, inLineSize;
 	OutputStream *ost = &video_st;
@@ -2326,14 +2353,18 @@ int aviRecordOpenFile( const char *filepath )
 		}
 	}
 
-	vbufSize    = 1024 * 1024 * 60;
-	rawVideoBuf = (uint32_t*)malloc( vbufSize * sizeof(uint32_t) );
+	videoSlot = (aviVideoSlot_t*)calloc( AVI_VIDEO_SLOTS, sizeof(aviVideoSlot_t) );
 
 	abufSize    = 96000;
 	rawAudioBuf = (int16_t*)malloc( abufSize * sizeof(uint16_t) );
 
-	vbufHead = 0;
-	vbufTail = 0;
+	vslotFree.acquire( vslotFree.available() );
+	vslotUsed.acquire( vslotUsed.available() );
+	vslotFree.release( AVI_VIDEO_SLOTS );
+	vslotHead = 0;
+	vslotTail = 0;
+	vslotPalSent = false;
+
 	abufHead = 0;
 	abufTail = 0;
 
@@ -2341,6 +2372,66 @@ int aviRecordOpenFile( const char *filepath )
 	return 0;
 }
 //**************************************************************************************
+static aviVideoSlot_t *acquireVideoSlot(void)
+{
+	// Wait for the disk thread to free a slot, giving up if recording stops.
+	while ( !vslotFree.tryAcquire( 1, 10 ) )
+	{
+		if ( !recordEnable )
+		{
+			return NULL;
+		}
+	}
+	return &videoSlot[ vslotHead ];
+}
+//**************************************************************************************
+static void commitVideoSlot(void)
+{
+	vslotHead = (vslotHead + 1) % AVI_VIDEO_SLOTS;
+
+	vslotUsed.release();
+}
+//**************************************************************************************
+// Disk thread side of the indexed path, matches Blit8ToHigh's deemph lookup
+// followed by the prescaler's point resize.
+static void expandVideoSlot( const aviVideoSlot_t *slot, const uint32_t *pal, uint32_t *out )
+{
+	int x, y, i, w;
+	const uint8_t *src, *dmp;
+	uint32_t *line, color;
+
+	w   = slot->width * slot->scale;
+	src = slot->pix;
+	dmp = slot->deemph;
+
+	for (y=0; y<slot->height; y++)
+	{
+		line = out;
+
+		for (x=0; x<slot->width; x++)
+		{
+			if ( dmp[x] )
+			{
+				color = pal[ 256 + (src[x] & 0x3F) + (dmp[x] * 64) ];
+			}
+			else
+			{
+				color = pal[ src[x] ];
+			}
+			for (i=0; i<slot->scale; i++)
+			{
+				*out++ = color;
+			}
+		}
+		for (i=1; i<slot->scale; i++)
+		{
+			memcpy( out, line, w * sizeof(uint32_t) ); out += w;
+		}
+		src += slot->width;
+		dmp += slot->width;
+	}
+}
+//**************************************************************************************
 int aviRecordAddFrame( void )
 {
 	if ( !recordEnable )
@@ -2357,37 +2448,97 @@ int aviRecordAddFrame( void )
 		return 0;
 	}
 
-	int i, head, numPixels, availSize;
+	int numPixels;
+	aviVideoSlot_t *slot;
 
 	numPixels  = nes_shm->video.ncol * nes_shm->video.nrow;
 
-	availSize = (vbufTail - vbufHead);
-	if ( availSize <= 0 )
+	slot = acquireVideoSlot();
+
+	if ( slot == NULL )
 	{
-		availSize += vbufSize;
+		return -1;
 	}
 
-	while ( numPixels > availSize )
+	if ( slot->rgbSize < numPixels )
 	{
-		//printf("Video Unavail %i \n", availSize );
-		msleep(1);
+		free( slot->rgb );
 
-		availSize = (vbufTail - vbufHead);
-		if ( availSize <= 0 )
+		slot->rgb     = (uint32_t*)malloc( numPixels * sizeof(uint32_t) );
+		slot->rgbSize = slot->rgb ? numPixels : 0;
+
+		if ( slot->rgb == NULL )
 		{
-			availSize += vbufSize;
+			vslotFree.release();
+			return -1;
 		}
 	}
+	memcpy( slot->rgb, nes_shm->avibuf, numPixels * sizeof(uint32_t) );
+
+	slot->indexed   = 0;
+	slot->palUpdate = 0;
+	slot->numPixels = numPixels;
+
+	commitVideoSlot();
+
+	return 0;
+}
+//**************************************************************************************
+int aviRecordAddIndexedFrame( const uint8_t *pix, const uint8_t *deemph, int width, int height )
+{
+	if ( !recordEnable )
+	{
+		return -1;
+	}
+	if ( FCEUI_EmulationPaused() )
+	{
+		return 0;
+	}
+
+	int y, scale;
+	uint32_t palVersion;
+	const uint32_t *pal;
+	aviVideoSlot_t *slot;
+
+	scale = GetPaletteBlitToHigh( &pal, &palVersion );
+
+	if ( (scale == 0) || (width > 256) || (height > 256) ||
+	     (width*scale != nes_shm->video.ncol) || (height*scale != nes_shm->video.nrow) )
+	{
+		// Filtered video mode, the caller must blit and use aviRecordAddFrame.
+		return 1;
+	}
+
+	slot = acquireVideoSlot();
+
+	if ( slot == NULL )
+	{
+		return -1;
+	}
+
+	for (y=0; y<height; y++)
+	{
+		memcpy( &slot->pix[ y*width ], &pix[ y*256 ], width );
+		memcpy( &slot->deemph[ y*width ], &deemph[ y*256 ], width );
+	}
+	slot->indexed   = 1;
+	slot->scale     = scale;
+	slot->width     = width;
+	slot->height    = height;
+	slot->numPixels = nes_shm->video.ncol * nes_shm->video.nrow;
 
-	i = 0; head = vbufHead;
+	// Slots are consumed in order, so the palette only travels when it changes.
+	slot->palUpdate = !vslotPalSent || (palVersion != vslotPalVersion);
 
-	while ( i < numPixels )
+	if ( slot->palUpdate )
 	{
-		rawVideoBuf[ head ] = nes_shm->avibuf[i]; i++;
+		memcpy( slot->pal, pal, sizeof(slot->pal) );
 
-		head = (head + 1) % vbufSize;
+		vslotPalVersion = palVersion;
+		vslotPalSent    = true;
 	}
-	vbufHead = head;
+
+	commitVideoSlot();
 
 	return 0;
 }
@@ -2429,16 +2580,21 @@ int aviRecordClose(void)
 		delete gwavi; gwavi = NULL;
 	}
 
-	if ( rawVideoBuf != NULL )
+	if ( videoSlot != NULL )
 	{
-		free(rawVideoBuf); rawVideoBuf = NULL;
+		for (int i=0; i<AVI_VIDEO_SLOTS; i++)
+		{
+			free( videoSlot[i].rgb );
+		}
+		free(videoSlot); videoSlot = NULL;
 	}
 	if ( rawAudioBuf != NULL )
 	{
 		free(rawAudioBuf); rawAudioBuf = NULL;
 	}
-	vbufTail = abufTail = 0;
-	vbufSize = abufSize = 0;
+	vslotHead = vslotTail = 0;
+	abufTail = 0;
+	abufSize = 0;
 
 	return 0;
 }
@@ -2590,12 +2746,14 @@ AviRecordDiskThread_t::~AviRecordDiskThread_t(void)
 //----------------------------------------------------
 void AviRecordDiskThread_t::run(void)
 {
-	int numPixels, width, height, numPixelsReady = 0;
+	int numPixels, width, height;
 	int numSamples = 0;
 	double fps = 60.0;
 	unsigned char *rgb24;
 	int16_t *audioOut;
-	uint32_t *videoOut;
+	uint32_t *videoOut, *palette;
+	const uint32_t *frame;
+	aviVideoSlot_t *slot;
 	char writeAudio = 1;
 	char localRecordAudio = 0;
 	int  avgAudioPerFrame, audioChunkSize, audioSamplesAvail=0;
@@ -2667,20 +2825,42 @@ void AviRecordDiskThread_t::run(void)
 #endif
 
 	audioOut = (int16_t *)malloc(96000);
-	videoOut = (uint32_t*)malloc(1048576);
+	videoOut = (uint32_t*)malloc( numPixels * sizeof(uint32_t) );
+	palette  = (uint32_t*)calloc( 256+512, sizeof(uint32_t) );
 
 	// Main Disk Record Loop
 	while ( !isInterruptionRequested() )
 	{
-		
-		while ( (numPixelsReady < numPixels) && (vbufTail != vbufHead) )
+		if ( !vslotUsed.tryAcquire( 1, 10 ) )
 		{
-			videoOut[ numPixelsReady ] = rawVideoBuf[ vbufTail ]; numPixelsReady++;
-			
-			vbufTail = (vbufTail + 1) % vbufSize;
+			continue;
+		}
+		slot = &videoSlot[ vslotTail ];
+
+		// Palettes are only sent when they change, so take the update even
+		// from a frame that gets dropped below.
+		if ( slot->indexed && slot->palUpdate )
+		{
+			memcpy( palette, slot->pal, sizeof(slot->pal) );
 		}
 
-		if ( numPixelsReady >= numPixels )
+		if ( slot->numPixels != numPixels )
+		{
+			// Video size changed after the recording started, drop the frame.
+			frame = NULL;
+		}
+		else if ( slot->indexed )
+		{
+			expandVideoSlot( slot, palette, videoOut );
+
+			frame = videoOut;
+		}
+		else
+		{
+			frame = slot->rgb;
+		}
+
+		if ( frame != NULL )
 		{
 			//printf("Adding Frame:%i\n", frameCount++);
 
@@ -2688,27 +2868,27 @@ void AviRecordDiskThread_t::run(void)
 
 			if ( localVideoFormat == AVI_I420)
 			{
-				Convert_4byte_To_I420Frame<4>(videoOut,rgb24,numPixels,width);
+				Convert_4byte_To_I420Frame<4>(frame,rgb24,numPixels,width);
 				gwavi->add_frame( rgb24, (numPixels*3)/2 );
 			}
 			#ifdef _USE_X264
 			else if ( localVideoFormat == AVI_X264)
 			{
-				Convert_4byte_To_I420Frame<4>(videoOut,rgb24,numPixels,width);
+				Convert_4byte_To_I420Frame<4>(frame,rgb24,numPixels,width);
 				X264::encode_frame( rgb24, width, height );
 			}
 			#endif
 			#ifdef _USE_X265
 			else if ( localVideoFormat == AVI_X265)
 			{
-				Convert_4byte_To_I420Frame<4>(videoOut,rgb24,numPixels,width);
+				Convert_4byte_To_I420Frame<4>(frame,rgb24,numPixels,width);
 				X265::encode_frame( rgb24, width, height );
 			}
 			#endif
 			#ifdef WIN32
 			else if ( localVideoFormat == AVI_VFW)
 			{
-				convertRgb_32_to_24( (const unsigned char*)videoOut, rgb24,
+				convertRgb_32_to_24( (const unsigned char*)frame, rgb24,
 						width, height, numPixels, true );
 				VFW::encode_frame( rgb24, width, height );
 			}
@@ -2719,18 +2899,16 @@ void AviRecordDiskThread_t::run(void)
 				//Convert_4byte_To_I420Frame<4>(videoOut,rgb24,numPixels,width);
 				//convertRgb_32_to_24( (const unsigned char*)videoOut, rgb24,
 				//		width, height, numPixels, true );
-				LIBAV::encode_video_frame( (unsigned char*)videoOut );
+				LIBAV::encode_video_frame( (const unsigned char*)frame );
 			}
 			#endif
 			else
 			{
-				convertRgb_32_to_24( (const unsigned char*)videoOut, rgb24,
+				convertRgb_32_to_24( (const unsigned char*)frame, rgb24,
 						width, height, numPixels, true );
 				gwavi->add_frame( rgb24, numPixels*3 );
 			}
 
-			numPixelsReady = 0;
-
 			audioSamplesAvail = abufHead - abufTail;
 
 			if ( audioSamplesAvail < 0 )
@@ -2773,10 +2951,9 @@ void AviRecordDiskThread_t::run(void)
 				}
 			}
 		}
-		else
-		{
-			msleep(1);
-		}
+		vslotTail = (vslotTail + 1) % AVI_VIDEO_SLOTS;
+
+		vslotFree.release();
 	}
 
 	// Write Leftover Audio Samples
@@ -2849,6 +3026,7 @@ void AviRecordDiskThread_t::run(void)
 
 	free(audioOut);
 	free(videoOut);
+	free(palette);
 
 	fprintf( avLogFp, "AVI Record Disk Thread Exit\n");
 	emit finished();
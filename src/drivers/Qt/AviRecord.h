@@ -57,6 +57,8 @@ int aviRecordOpenFile( const char *filepath );
 
 int aviRecordAddFrame( void );
 
+int aviRecordAddIndexedFrame( const uint8_t *pix, const uint8_t *deemph, int width, int height );
+
 int aviRecordAddAudioFrame( int32_t *buf, int numSamples );
 
 int aviRecordClose(void);
@@ -176,6 +176,8 @@ ConsoleDebugger::ConsoleDebugger(QWidget *parent)
 
 	dbgWin = this;
 
+	FCEUI_SetDebugHookUser( DBGHOOK_DEBUGGER, true );
+
 	periodicTimer  = new QTimer( this );
 
 	connect( periodicTimer, &QTimer::timeout, this, &ConsoleDebugger::updatePeriodic );
@@ -248,6 +250,8 @@ ConsoleDebugger::~ConsoleDebugger(void)
 
 	if ( dbgWin == NULL )
 	{
+		FCEUI_SetDebugHookUser( DBGHOOK_DEBUGGER, false );
+
 		saveGameDebugBreakpoints();
 		debuggerClearAllBreakpoints();
 		debuggerClearAllBookmarks();
@@ -1811,6 +1815,7 @@ void 	ConsoleDebugger::bpItemClicked( QTreeWidgetItem *item, int column)
 			{
 				watchpoint[row].flags &= ~WP_E;
 			}
+			FCEUI_BreakpointsChanged();
 		}
 	}
 }
@@ -2661,6 +2666,7 @@ static void DeleteBreak(int sel)
 	watchpoint[numWPs].condText = 0;
 	watchpoint[numWPs].desc = 0;
 	numWPs--;
+	FCEUI_BreakpointsChanged();
 
 	FCEU_WRAPPER_UNLOCK();
 }
@@ -2699,6 +2705,7 @@ void debuggerClearAllBreakpoints(void)
 	   watchpoint[i].desc = 0;
 	}
 	numWPs = 0;
+	FCEUI_BreakpointsChanged();
 
 	FCEU_WRAPPER_UNLOCK();
 }
@@ -268,6 +268,8 @@ ConsoleSndConfDialog_t::ConsoleSndConfDialog_t(QWidget *parent)
 
 	starveLbl = new QLabel( tr("Sink Starve Count:") );
 	starveLbl->setToolTip( tr("Running count of the number of samples that the audio sink is starved of.") );
+	overrunLbl = new QLabel( tr("Overrun Count:") );
+	overrunLbl->setToolTip( tr("Running count of the number of samples dropped because the audio sink stopped draining.") );
 	resetCountBtn = new QPushButton( tr("Reset Counter") );
 	resetCountBtn->setIcon(style()->standardIcon(QStyle::SP_DialogResetButton));
 	connect(resetCountBtn, SIGNAL(clicked(void)), this, SLOT(resetCounters(void)));
@@ -275,6 +277,7 @@ ConsoleSndConfDialog_t::ConsoleSndConfDialog_t(QWidget *parent)
 	hbox = new QHBoxLayout();
 	hbox->addWidget(resetCountBtn, 1);
 	hbox->addWidget(starveLbl,1);
+	hbox->addWidget(overrunLbl,1);
 	hbox->addStretch(5);
 	hbox->addWidget( closeButton, 1 );
 
@@ -315,6 +318,7 @@ void ConsoleSndConfDialog_t::closeWindow(void)
 void ConsoleSndConfDialog_t::resetCounters(void)
 {
 	nes_shm->sndBuf.starveCounter = 0;
+	nes_shm->sndBuf.overrunCounter = 0;
 
 	periodicUpdate();
 }
@@ -332,10 +336,14 @@ void ConsoleSndConfDialog_t::periodicUpdate(void)
 
 	bufUsage->setValue( (int)(percBufUse) );
 
-	sprintf( stmp, "Sink Starve Count: %u", nes_shm->sndBuf.starveCounter );
+	sprintf( stmp, "Sink Starve Count: %u", nes_shm->sndBuf.starveCounter.load() );
 
 	starveLbl->setText( tr(stmp) );
 
+	sprintf( stmp, "Overrun Count: %u", nes_shm->sndBuf.overrunCounter.load() );
+
+	overrunLbl->setText( tr(stmp) );
+
 	if ( FCEUD_SoundIsMuted() != muteChkbox->isChecked() )
 	{
 		muteChkbox->setChecked( FCEUD_SoundIsMuted() );
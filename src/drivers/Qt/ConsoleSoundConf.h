@@ -46,6 +46,7 @@ protected:
 	QLabel *nseLbl;
 	QLabel *pcmLbl;
 	QLabel *starveLbl;
+	QLabel *overrunLbl;
 	QSlider *sqr2Slider;
 	QSlider *nseSlider;
 	QSlider *pcmSlider;
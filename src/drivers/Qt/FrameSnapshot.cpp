@@ -0,0 +1,212 @@
+/* FCE Ultra - NES/Famicom Emulator
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+// FrameSnapshot.cpp
+//
+#include <string.h>
+#include <atomic>
+
+#include "../../types.h"
+#include "../../fceu.h"
+#include "../../x6502.h"
+#include "../../cart.h"
+#include "../../ppu.h"
+#include "../../debug.h"
+#include "../../driver.h"
+
+#include "Qt/fceuWrapper.h"
+#include "Qt/FrameSnapshot.h"
+
+// Triple buffer: the emulation thread fills the back slot and swaps it with
+// the middle one, the GUI thread swaps its front slot with the middle one
+// when a newer frame is there.  Neither side ever waits on the other.
+static FrameSnapshot slots[3];
+static int backSlot  = 0;  // emulation thread
+static int frontSlot = 1;  // GUI thread
+static std::atomic<int> middleSlot(2);
+
+static const int SLOT_FRESH = 4;  // middle slot holds a frame the GUI has not taken
+
+// Open windows reading each part, indexed by the bit number of SNAPSHOT_*.
+static const int NUM_PARTS = 3;
+static std::atomic<int> readerCount[NUM_PARTS];
+//----------------------------------------------------------------------------
+// CPU pages read like GetMem would: pages read as plain memory are copied
+// straight from their backing store, anything behind a special read handler
+// (cheats, registers) goes through GetMem.  With changed[] given, only the
+// pages it flags are copied, the others still hold the bytes from last time.
+static void copyCPUPages( uint8_t *dst, unsigned int addr, unsigned int size, const uint8_t *changed )
+{
+	for (unsigned int a = addr; a < addr + size; a += 0x100)
+	{
+		uint8_t *src;
+
+		if ( changed && !changed[a >> 8] )
+		{
+			continue;
+		}
+
+		src = FCEUI_MemPeekPtr( a );
+
+		if ( src )
+		{
+			memcpy( dst + (a - addr), src, 0x100 );
+		}
+		else
+		{
+			for (unsigned int i = 0; i < 0x100; i++)
+			{
+				dst[a - addr + i] = GetMem(a + i);
+			}
+		}
+	}
+}
+//----------------------------------------------------------------------------
+// PPU address space read like the hex editor's PPU view: pattern tables,
+// name tables (and their mirror up to $3EFF) and the palette.
+static void copyPPU( uint8_t *dst )
+{
+	for (int i = 0; i < 8; i++)
+	{
+		if ( VPage[i] )
+		{
+			memcpy( dst + (i << 10), VPage[i] + (i << 10), 0x400 );
+		}
+		else
+		{
+			memset( dst + (i << 10), 0, 0x400 );
+		}
+	}
+
+	if ( GameInfo->type == GIT_NSF )
+	{
+		memset( dst + 0x2000, 0, 0x2000 );
+		return;
+	}
+
+	for (unsigned int a = 0x2000; a < 0x3F00; a += 0x400)
+	{
+		unsigned int len = (a + 0x400 > 0x3F00) ? (0x3F00 - a) : 0x400;
+
+		memcpy( dst + a, vnapage[(a >> 10) & 0x3], len );
+	}
+	for (unsigned int a = 0x3F00; a < 0x4000; a++)
+	{
+		dst[a] = READPAL_MOTHEROFALL(a & 0x1F);
+	}
+}
+//----------------------------------------------------------------------------
+void frameSnapshotPublish(void)
+{
+	FrameSnapshot *s = &slots[backSlot];
+	uint8_t changed[0x100];
+	int parts = 0;
+
+	for (int i = 0; i < NUM_PARTS; i++)
+	{
+		if ( readerCount[i].load() > 0 )
+		{
+			parts |= (1 << i);
+		}
+	}
+
+	if ( parts == 0 )
+	{
+		// Nobody reads it
+		return;
+	}
+
+	if ( GameInfo == NULL )
+	{
+		s->valid = false;
+		s->parts = 0;
+	}
+	else
+	{
+		// Pages not written since this slot was filled last still hold the
+		// same bytes; registers and mapper pages are always flagged.
+		if ( s->valid )
+		{
+			FCEUI_MemChangedPages( s->writeGen, changed );
+		}
+		s->writeGen = FCEUI_MemWriteGeneration();
+
+		if ( parts & SNAPSHOT_CPU )
+		{
+			copyCPUPages( s->cpu, 0x0000, sizeof(s->cpu), (s->valid && (s->parts & SNAPSHOT_CPU)) ? changed : NULL );
+		}
+		if ( parts & SNAPSHOT_RAM )
+		{
+			if ( parts & SNAPSHOT_CPU )
+			{
+				memcpy( s->ram , s->cpu + 0x0000, sizeof(s->ram)  );
+				memcpy( s->sram, s->cpu + 0x6000, sizeof(s->sram) );
+			}
+			else
+			{
+				const uint8_t *ramChanged = (s->valid && (s->parts & SNAPSHOT_RAM)) ? changed : NULL;
+
+				copyCPUPages( s->ram , 0x0000, sizeof(s->ram) , ramChanged );
+				copyCPUPages( s->sram, 0x6000, sizeof(s->sram), ramChanged );
+			}
+		}
+		if ( parts & SNAPSHOT_PPU )
+		{
+			copyPPU( s->ppu );
+			memcpy( s->oam, SPRAM, sizeof(s->oam) );
+		}
+		s->valid = true;
+		s->parts = parts;
+	}
+	s->instructions = total_instructions;
+
+	backSlot = middleSlot.exchange( backSlot | SLOT_FRESH ) & 3;
+}
+//----------------------------------------------------------------------------
+const FrameSnapshot *frameSnapshotAcquire(void)
+{
+	if ( middleSlot.load() & SLOT_FRESH )
+	{
+		frontSlot = middleSlot.exchange( frontSlot ) & 3;
+	}
+	return &slots[frontSlot];
+}
+//----------------------------------------------------------------------------
+void frameSnapshotAddReader( int parts )
+{
+	for (int i = 0; i < NUM_PARTS; i++)
+	{
+		if ( parts & (1 << i) )
+		{
+			readerCount[i]++;
+		}
+	}
+	FCEU_WRAPPER_LOCK();
+	frameSnapshotPublish();
+	FCEU_WRAPPER_UNLOCK();
+}
+//----------------------------------------------------------------------------
+void frameSnapshotRemoveReader( int parts )
+{
+	for (int i = 0; i < NUM_PARTS; i++)
+	{
+		if ( parts & (1 << i) )
+		{
+			readerCount[i]--;
+		}
+	}
+}
+//----------------------------------------------------------------------------
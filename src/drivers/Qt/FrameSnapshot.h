@@ -0,0 +1,70 @@
+// FrameSnapshot.h
+//
+
+#pragma once
+
+#include <stdint.h>
+
+// Parts of the snapshot, registered by the windows that read them.
+enum
+{
+	SNAPSHOT_RAM = 0x01,   // ram[] and sram[]
+	SNAPSHOT_CPU = 0x02,   // cpu[]
+	SNAPSHOT_PPU = 0x04,   // ppu[] and oam[]
+};
+
+// Copy of the memory that RAM Watch, RAM Search and the hex editor display,
+// taken by the emulation thread at the end of every frame.  Those tools read
+// it from the GUI thread without taking the emulator mutex.  Only the parts
+// some open window registered for are captured, nothing at all while no
+// such window is open.
+struct FrameSnapshot
+{
+	bool      valid;        // false when no game is loaded
+	int       parts;        // SNAPSHOT_* parts captured
+	uint64_t  instructions; // total_instructions when captured
+
+	uint8_t   ram[0x800];
+	uint8_t   sram[0x2000];        // $6000-$7FFF as currently mapped
+
+	uint8_t   cpu[0x10000];        // whole CPU address space, as GetMem reads it
+	uint8_t   ppu[0x4000];         // PPU address space, as the hex editor shows it
+	uint8_t   oam[0x100];
+
+	uint32_t  writeGen;            // write generation the CPU pages were copied at
+
+	// Value a CPU read of addr would return, for RAM and SRAM only.
+	// Returns -1 for anything else, including the RAM mirrors (a cheat on
+	// a RAM address does not apply to its mirrors).
+	int peekCPU( unsigned int addr ) const
+	{
+		if ( !(parts & SNAPSHOT_RAM) )
+		{
+			return -1;
+		}
+		if ( addr < 0x800 )
+		{
+			return ram[addr];
+		}
+		if ( (addr >= 0x6000) && (addr < 0x8000) )
+		{
+			return sram[addr - 0x6000];
+		}
+		return -1;
+	}
+};
+
+// With the emulator mutex held (normally the emulation thread at the end of
+// a frame): capture and publish.  Also call it after changing memory while
+// the emulation is paused, so that the readers see the change.
+void frameSnapshotPublish(void);
+
+// GUI thread only: the most recently published snapshot.  The pointer
+// stays valid until the next call.
+const FrameSnapshot *frameSnapshotAcquire(void);
+
+// GUI thread only: a window starts or stops reading the given parts.  Adding
+// a reader publishes a snapshot right away, so that it has data even while
+// the emulation is paused.
+void frameSnapshotAddReader( int parts );
+void frameSnapshotRemoveReader( int parts );
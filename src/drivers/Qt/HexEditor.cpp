@@ -60,13 +60,13 @@
 #include "Qt/keyscan.h"
 #include "Qt/fceuWrapper.h"
 #include "Qt/HexEditor.h"
+#include "Qt/FrameSnapshot.h"
 #include "Qt/CheatsConf.h"
 #include "Qt/SymbolicDebug.h"
 #include "Qt/ConsoleDebugger.h"
 #include "Qt/ConsoleUtilities.h"
 #include "Qt/ConsoleWindow.h"
 
-static bool memNeedsCheck = false;
 static HexBookMarkManager_t hbm;
 static std::list <HexEditorDialog_t*> winList;
 static const char *memViewNames[] = { "CPU", "PPU", "OAM", "ROM", NULL };
@@ -383,6 +383,7 @@ static int writeMem( int mode, unsigned int addr, int value )
 			else if ( (addr >= 16) && (addr < PRGsize[0]+16) )
 			{
 			  	*(uint8 *)(GetNesPRGPointer(addr-16)) = value;
+				FCEU_NoteWriteRange(0x4000, 0xFFFF);
 			}
 			else if ( (addr >= PRGsize[0]+16) && (addr < CHRsize[0]+PRGsize[0]+16) )
 			{
@@ -1863,21 +1864,23 @@ void HexEditorDialog_t::updatePeriodic(void)
 	
 	undoEditAct->setEnabled( romEditList.undoQueueSize() > 0 );
 
-	if ( fceuWrapperTryLock(0) )
-	{
-		memNeedsCheck = false;
+	editor->memModeUpdate();
 
-		editor->checkMemActivity();
+	if ( editor->getMode() == QHexEdit::MODE_NES_ROM )
+	{
+		// The ROM is not in the frame snapshot; it only changes by edits
+		if ( editor->updatePending() && fceuWrapperTryLock(0) )
+		{
+			editor->checkMemActivity();
 
-		FCEU_WRAPPER_UNLOCK();
+			FCEU_WRAPPER_UNLOCK();
+		}
 	}
 	else
 	{
-		memNeedsCheck = true;
+		editor->checkMemActivity( frameSnapshotAcquire() );
 	}
 
-	editor->memModeUpdate();
-
 	editor->update();
 
 	setWindowTitle();
@@ -2011,6 +2014,7 @@ QHexEdit::QHexEdit(QWidget *parent)
 	reverseVideo = true;
 	actvHighlightEnable = true;
 	total_instructions_lp = 0;
+	snapshotParts = 0;
 	pxLineXScroll = 0;
 	jumpToRomValue = 0;
 	ctxAddr = 0;
@@ -2078,7 +2082,10 @@ QHexEdit::QHexEdit(QWidget *parent)
 //----------------------------------------------------------------------------
 QHexEdit::~QHexEdit(void)
 {
-
+	if ( snapshotParts )
+	{
+		frameSnapshotRemoveReader( snapshotParts );
+	}
 }
 //----------------------------------------------------------------------------
 void QHexEdit::calcFontData(void)
@@ -3612,6 +3619,71 @@ int QHexEdit::checkMemActivity(void)
    return 0;
 }
 //----------------------------------------------------------------------------
+// Same as above for the RAM, PPU and OAM views, but reading the memory from
+// the frame snapshot, so that the GUI thread never waits for the emulator.
+int QHexEdit::checkMemActivity( const FrameSnapshot *snap )
+{
+	int c;
+	const uint8_t *src = NULL;
+	bool running;
+
+	if ( !snap->valid )
+	{
+		return -1;
+	}
+
+	switch ( viewMode )
+	{
+		case MODE_NES_RAM:
+			if ( snap->parts & SNAPSHOT_CPU )
+			{
+				src = snap->cpu;
+			}
+		break;
+		case MODE_NES_PPU:
+			if ( snap->parts & SNAPSHOT_PPU )
+			{
+				src = snap->ppu;
+			}
+		break;
+		case MODE_NES_OAM:
+			if ( snap->parts & SNAPSHOT_PPU )
+			{
+				src = snap->oam;
+			}
+		break;
+		default:
+		break;
+	}
+
+	if ( src == NULL )
+	{
+		return -1;
+	}
+
+	// Activity highlights only fade while the emulation runs
+	running = updateRequested || (snap->instructions != total_instructions_lp);
+
+	for (int i=0; i<mb.size(); i++)
+	{
+		c = src[i];
+
+		if ( c != mb.buf[i].data )
+		{
+			mb.buf[i].actv  = 15;
+			mb.buf[i].data  = c;
+		}
+		else if ( running && (mb.buf[i].actv > 0) )
+		{
+			mb.buf[i].actv--;
+		}
+	}
+	total_instructions_lp = snap->instructions;
+	updateRequested = false;
+
+	return 0;
+}
+//----------------------------------------------------------------------------
 int QHexEdit::getRomAddrColor( int addr, QColor &fg, QColor &bg )
 {
 	int temp_offset;
@@ -3735,7 +3807,35 @@ int QHexEdit::getRomAddrColor( int addr, QColor &fg, QColor &bg )
 //----------------------------------------------------------------------------
 void QHexEdit::memModeUpdate(void)
 {
-	int memSize;
+	int memSize, parts;
+
+	// Register for the frame snapshot parts the view mode reads
+	switch ( getMode() )
+	{
+		default:
+		case MODE_NES_RAM:
+			parts = SNAPSHOT_CPU;
+		break;
+		case MODE_NES_PPU:
+		case MODE_NES_OAM:
+			parts = SNAPSHOT_PPU;
+		break;
+		case MODE_NES_ROM:
+			parts = 0;
+		break;
+	}
+	if ( parts != snapshotParts )
+	{
+		if ( parts )
+		{
+			frameSnapshotAddReader( parts );
+		}
+		if ( snapshotParts )
+		{
+			frameSnapshotRemoveReader( snapshotParts );
+		}
+		snapshotParts = parts;
+	}
 
 	switch ( getMode() )
 	{
@@ -4237,20 +4337,14 @@ int hexEditorOpenFromDebugger( int mode, int addr )
 	return 0;
 }
 //----------------------------------------------------------------------------
-// This function must be called from within the emulation thread
+// This function must be called with the emulator mutex held.  The windows
+// refresh from the frame snapshot, which is published at the end of every
+// frame; the debugger forces a new one when it stops in the middle of a frame.
 void hexEditorUpdateMemoryValues( bool force )
 {
-	std::list <HexEditorDialog_t*>::iterator it;
-
-	if ( !memNeedsCheck && !force )
-	{
-		return;
-	}
-
-	for (it = winList.begin(); it != winList.end(); it++)
+	if ( force && !winList.empty() )
 	{
-		(*it)->editor->checkMemActivity();
+		frameSnapshotPublish();
 	}
-	memNeedsCheck = false;
 }
 //----------------------------------------------------------------------------
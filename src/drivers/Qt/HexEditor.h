@@ -112,6 +112,7 @@ class HexEditorCharTable_t
 };
 
 class HexEditorDialog_t;
+struct FrameSnapshot;
 
 class QHexEdit : public QWidget
 {
@@ -134,6 +135,8 @@ class QHexEdit : public QWidget
 		void memModeUpdate(void);
 		void openGotoAddrDialog(void);
 		int  checkMemActivity(void);
+		int  checkMemActivity( const FrameSnapshot *snap );
+		bool updatePending(void){ return updateRequested; };
 		int  getAddr(void){ return cursorAddr; };
 		int  FreezeRam( const char *name, uint32_t a, uint8_t v, int c, int s, int type );
 		void loadHighlightToClipboard(void);
@@ -194,6 +197,7 @@ class QHexEdit : public QWidget
 		HexEditorDialog_t *parent;
 
 		uint64_t total_instructions_lp;
+		int      snapshotParts;
 
 		int viewMode;
 		int lineOffset;
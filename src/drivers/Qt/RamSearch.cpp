@@ -47,6 +47,7 @@
 #include "../../cheat.h"
 #include "../../debug.h"
 #include "../../movie.h"
+#include "../../memsearch.h"
 
 #include "Qt/main.h"
 #include "Qt/dface.h"
@@ -54,6 +55,7 @@
 #include "Qt/config.h"
 #include "Qt/keyscan.h"
 #include "Qt/fceuWrapper.h"
+#include "Qt/FrameSnapshot.h"
 #include "Qt/RamWatch.h"
 #include "Qt/RamSearch.h"
 #include "Qt/HexEditor.h"
@@ -66,50 +68,8 @@ static bool ShowSRAM = false;
 static bool ShowROM  = false;
 static RamSearchDialog_t *ramSearchWin = NULL;
 
-struct memoryState_t
-{
-	union
-	{
-		int8_t i;
-		uint8_t u;
-	} v8;
-	union
-	{
-		int16_t i;
-		uint16_t u;
-	} v16;
-	union
-	{
-		int32_t i;
-		uint32_t u;
-	} v32;
-};
-
-struct memoryLocation_t
-{
-	int addr;
-
-	memoryState_t val;
-
-	std::vector<memoryState_t> hist;
-
-	uint32_t chgCount;
-	uint64_t elimMask;
-
-	memoryLocation_t(void)
-	{
-		addr = 0;
-		val.v32.u = 0;
-		chgCount = 0;
-		elimMask = 0;
-	}
-};
-static struct memoryLocation_t memLoc[0x10000];
-static uint8_t lclMemBuf[0x10000];
-
-static std::list<struct memoryLocation_t *> actvSrchList;
-static std::list<struct memoryLocation_t *> deactvSrchList;
-static std::vector<int> deactvFrameStack;
+// Snapshot, candidates, previous values and change counts of the open dialog
+static FCEU::MemSearch *memSearch = NULL;
 
 static int cmpOp = '=';
 static int dpySize = 'b';
@@ -215,6 +175,8 @@ RamSearchDialog_t::RamSearchDialog_t(QWidget *parent)
 	int useNativeMenuBar;
 	QSettings settings;
 
+	memSearch = new FCEU::MemSearch();
+
 	setWindowTitle("RAM Search");
 
 	menuBar = new QMenuBar(this);
@@ -506,6 +468,8 @@ RamSearchDialog_t::RamSearchDialog_t(QWidget *parent)
 
 	updateTimer->start(8); // ~120hz
 
+	frameSnapshotAddReader( SNAPSHOT_RAM );
+
 	restoreGeometry(settings.value("ramSearchWindow/geometry").toByteArray());
 }
 //----------------------------------------------------------------------------
@@ -514,17 +478,13 @@ RamSearchDialog_t::~RamSearchDialog_t(void)
 	QSettings settings;
 
 	updateTimer->stop();
+	frameSnapshotRemoveReader( SNAPSHOT_RAM );
 	//printf("Destroy RAM Search Window\n");
 	ramSearchWin = NULL;
 
-	actvSrchList.clear();
-	deactvSrchList.clear();
-	deactvFrameStack.clear();
+	delete memSearch;
+	memSearch = NULL;
 
-	for (unsigned int addr = 0; addr < 0x08000; addr++)
-	{
-		memLoc[addr].hist.clear();
-	}
 	settings.setValue("ramSearchWindow/geometry", saveGeometry());
 }
 //----------------------------------------------------------------------------
@@ -549,9 +509,7 @@ void RamSearchDialog_t::periodicUpdate(void)
 
 	if (currFrameCounter != frameCounterLastPass)
 	{
-		FCEU_WRAPPER_LOCK();
-		copyRamToLocalBuffer();
-		FCEU_WRAPPER_UNLOCK();
+		copySnapshotToLocalBuffer();
 
 		//if ( currFrameCounter != (frameCounterLastPass+1) )
 		//{
@@ -568,7 +526,7 @@ void RamSearchDialog_t::periodicUpdate(void)
 
 	if ((cycleCounter % 10) == 0)
 	{
-		undoButton->setEnabled(deactvFrameStack.size() > 0);
+		undoButton->setEnabled(memSearch->undoDepth() > 0);
 
 		selAddr = ramView->getSelAddr();
 
@@ -624,25 +582,46 @@ void RamSearchDialog_t::misalignedChanged(int state)
 	calcRamList();
 }
 //----------------------------------------------------------------------------
-static bool memoryAddrCompare(memoryLocation_t *loc1, memoryLocation_t *loc2)
+// Maps the comparison operator buttons onto the search engine
+static int getSearchOp(int op)
 {
-	return loc1->addr < loc2->addr;
+	switch (op)
+	{
+	case '<':
+		return FCEU::MemSearch::OP_LT;
+	case '>':
+		return FCEU::MemSearch::OP_GT;
+	case '=':
+		return FCEU::MemSearch::OP_EQ;
+	case '!':
+		return FCEU::MemSearch::OP_NE;
+	case 'l':
+		return FCEU::MemSearch::OP_LE;
+	case 'm':
+		return FCEU::MemSearch::OP_GE;
+	case 'd':
+		return FCEU::MemSearch::OP_DIFFBY;
+	case '%':
+		return FCEU::MemSearch::OP_MODIS;
+	default:
+		return -1;
+	}
 }
-static void sortActvMemList(void)
+
+static int getValueSize(void)
 {
-	actvSrchList.sort(memoryAddrCompare);
+	switch (dpySize)
+	{
+	case 'd':
+		return 4;
+	case 'w':
+		return 2;
+	default:
+	case 'b':
+		return 1;
+	}
 }
 
-// basic comparison functions:
-static bool LessCmp(int64_t x, int64_t y, int64_t i) { return x < y; }
-static bool MoreCmp(int64_t x, int64_t y, int64_t i) { return x > y; }
-static bool LessEqualCmp(int64_t x, int64_t y, int64_t i) { return x <= y; }
-static bool MoreEqualCmp(int64_t x, int64_t y, int64_t i) { return x >= y; }
-static bool EqualCmp(int64_t x, int64_t y, int64_t i) { return x == y; }
-static bool UnequalCmp(int64_t x, int64_t y, int64_t i) { return x != y; }
-static bool DiffByCmp(int64_t x, int64_t y, int64_t p) { return x - y == p || y - x == p; }
-static bool ModIsCmp(int64_t x, int64_t y, int64_t p) { return p && x % p == y; }
-
 static int64_t getLineEditValue(QLineEdit *edit, bool forceHex = false)
 {
 	int64_t val = 0;
@@ -658,455 +637,134 @@ static int64_t getLineEditValue(QLineEdit *edit, bool forceHex = false)
 }
 
 //----------------------------------------------------------------------------
-void RamSearchDialog_t::SearchRelative(void)
+int64_t RamSearchDialog_t::getCompareParam(int op)
 {
-	int elimCount = 0;
-	std::list<struct memoryLocation_t *>::iterator it;
-	memoryLocation_t *loc = NULL;
-	int64_t x = 0, y = 0, p = 0;
-	bool (*cmpFun)(int64_t x, int64_t y, int64_t p) = NULL;
-	bool storeHistory = !autoSearchCbox->isChecked();
-
-	switch (cmpOp)
+	if (op == 'd')
 	{
-	case '<':
-		cmpFun = LessCmp;
-		break;
-	case '>':
-		cmpFun = MoreCmp;
-		break;
-	case '=':
-		cmpFun = EqualCmp;
-		break;
-	case '!':
-		cmpFun = UnequalCmp;
-		break;
-	case 'l':
-		cmpFun = LessEqualCmp;
-		break;
-	case 'm':
-		cmpFun = MoreEqualCmp;
-		break;
-	case 'd':
-		cmpFun = DiffByCmp;
-		p = getLineEditValue(diffByEdit);
-		break;
-	case '%':
-		cmpFun = ModIsCmp;
-		p = getLineEditValue(moduloEdit);
-		break;
-	default:
-		cmpFun = NULL;
-		break;
+		return getLineEditValue(diffByEdit);
 	}
+	else if (op == '%')
+	{
+		return getLineEditValue(moduloEdit);
+	}
+	return 0;
+}
+//----------------------------------------------------------------------------
+void RamSearchDialog_t::SearchRelative(void)
+{
+	int op = getSearchOp(cmpOp);
+	int64_t p = getCompareParam(cmpOp);
+	bool storeHistory = !autoSearchCbox->isChecked();
 
-	if (cmpFun == NULL)
+	if (op < 0)
 	{
 		return;
 	}
-	//printf("Performing Relative Search Operation %zi: '%c'  '%lli'  '0x%llx' \n", deactvFrameStack.size()+1, cmpOp, (long long int)p, (unsigned long long int)p );
-
-	it = actvSrchList.begin();
+	//printf("Performing Relative Search Operation %zi: '%c'  '%lli'  '0x%llx' \n", memSearch->undoDepth()+1, cmpOp, (long long int)p, (unsigned long long int)p );
 
-	while (it != actvSrchList.end())
+	if (storeHistory)
 	{
-		loc = *it;
-
-		switch (dpySize)
-		{
-		default:
-		case 'b':
-		{
-			if (dpyType == 's')
-			{
-				x = loc->val.v8.i;
-				y = loc->hist.back().v8.i;
-			}
-			else
-			{
-				x = loc->val.v8.u;
-				y = loc->hist.back().v8.u;
-			}
-		}
-		break;
-		case 'w':
-		{
-			if (dpyType == 's')
-			{
-				x = loc->val.v16.i;
-				y = loc->hist.back().v16.i;
-			}
-			else
-			{
-				x = loc->val.v16.u;
-				y = loc->hist.back().v16.u;
-			}
-		}
-		break;
-		case 'd':
-		{
-			if (dpyType == 's')
-			{
-				x = loc->val.v32.i;
-				y = loc->hist.back().v32.i;
-			}
-			else
-			{
-				x = loc->val.v32.u;
-				y = loc->hist.back().v32.u;
-			}
-		}
-		break;
-		}
-
-		if (cmpFun(x, y, p) == false)
-		{
-			//printf("Eliminated Address: $%04X\n", loc->addr );
-			it = actvSrchList.erase(it);
-
-			if (storeHistory)
-			{
-				deactvSrchList.push_back(loc);
-				elimCount++;
-			}
-		}
-		else
-		{
-			if (storeHistory)
-			{
-				loc->hist.push_back(loc->val);
-			}
-			it++;
-		}
+		memSearch->pushUndo();
 	}
 
+	memSearch->filter((FCEU::MemSearch::Op)op, FCEU::MemSearch::CURRENT, FCEU::MemSearch::PREVIOUS, 0, p);
+
 	if (storeHistory)
 	{
-		deactvFrameStack.push_back(elimCount);
+		memSearch->commitPrevious();
 	}
 
-	vbar->setMaximum(actvSrchList.size());
+	vbar->setMaximum(memSearch->count());
 }
 //----------------------------------------------------------------------------
 void RamSearchDialog_t::SearchSpecificValue(void)
 {
-	int elimCount = 0;
-	std::list<struct memoryLocation_t *>::iterator it;
-	memoryLocation_t *loc = NULL;
-	int64_t x = 0, y = 0, p = 0;
-	bool (*cmpFun)(int64_t x, int64_t y, int64_t p) = NULL;
+	int op = getSearchOp(cmpOp);
+	int64_t p = getCompareParam(cmpOp), y = 0;
 	bool storeHistory = !autoSearchCbox->isChecked();
 
-	switch (cmpOp)
-	{
-	case '<':
-		cmpFun = LessCmp;
-		break;
-	case '>':
-		cmpFun = MoreCmp;
-		break;
-	case '=':
-		cmpFun = EqualCmp;
-		break;
-	case '!':
-		cmpFun = UnequalCmp;
-		break;
-	case 'l':
-		cmpFun = LessEqualCmp;
-		break;
-	case 'm':
-		cmpFun = MoreEqualCmp;
-		break;
-	case 'd':
-		cmpFun = DiffByCmp;
-		p = getLineEditValue(diffByEdit);
-		break;
-	case '%':
-		cmpFun = ModIsCmp;
-		p = getLineEditValue(moduloEdit);
-		break;
-	default:
-		cmpFun = NULL;
-		break;
-	}
-
-	if (cmpFun == NULL)
+	if (op < 0)
 	{
 		return;
 	}
 	y = getLineEditValue(specValEdit);
 
-	//printf("Performing Specific Value Search Operation %zi: 'x %c %lli' '%lli'  '0x%llx' \n", deactvFrameStack.size()+1, cmpOp,
+	//printf("Performing Specific Value Search Operation %zi: 'x %c %lli' '%lli'  '0x%llx' \n", memSearch->undoDepth()+1, cmpOp,
 	//     (long long int)y, (long long int)p, (unsigned long long int)p );
 
-	it = actvSrchList.begin();
-
-	while (it != actvSrchList.end())
+	if (storeHistory)
 	{
-		loc = *it;
-
-		switch (dpySize)
-		{
-		default:
-		case 'b':
-		{
-			if (dpyType == 's')
-			{
-				x = loc->val.v8.i;
-			}
-			else
-			{
-				x = loc->val.v8.u;
-			}
-		}
-		break;
-		case 'w':
-		{
-			if (dpyType == 's')
-			{
-				x = loc->val.v16.i;
-			}
-			else
-			{
-				x = loc->val.v16.u;
-			}
-		}
-		break;
-		case 'd':
-		{
-			if (dpyType == 's')
-			{
-				x = loc->val.v32.i;
-			}
-			else
-			{
-				x = loc->val.v32.u;
-			}
-		}
-		break;
-		}
-
-		if (cmpFun(x, y, p) == false)
-		{
-			//printf("Eliminated Address: $%04X\n", loc->addr );
-			it = actvSrchList.erase(it);
-
-			if (storeHistory)
-			{
-				deactvSrchList.push_back(loc);
-				elimCount++;
-			}
-		}
-		else
-		{
-			if (storeHistory)
-			{
-				loc->hist.push_back(loc->val);
-			}
-			it++;
-		}
+		memSearch->pushUndo();
 	}
 
+	memSearch->filter((FCEU::MemSearch::Op)op, FCEU::MemSearch::CURRENT, FCEU::MemSearch::VALUE, y, p);
+
 	if (storeHistory)
 	{
-		deactvFrameStack.push_back(elimCount);
+		memSearch->commitPrevious();
 	}
 
-	vbar->setMaximum(actvSrchList.size());
+	vbar->setMaximum(memSearch->count());
 }
 //----------------------------------------------------------------------------
 void RamSearchDialog_t::SearchSpecificAddress(void)
 {
-	int elimCount = 0;
-	std::list<struct memoryLocation_t *>::iterator it;
-	memoryLocation_t *loc = NULL;
-	int64_t x = 0, y = 0, p = 0;
-	bool (*cmpFun)(int64_t x, int64_t y, int64_t p) = NULL;
+	int op = getSearchOp(cmpOp);
+	int64_t p = getCompareParam(cmpOp), y = 0;
 	bool storeHistory = !autoSearchCbox->isChecked();
 
-	switch (cmpOp)
-	{
-	case '<':
-		cmpFun = LessCmp;
-		break;
-	case '>':
-		cmpFun = MoreCmp;
-		break;
-	case '=':
-		cmpFun = EqualCmp;
-		break;
-	case '!':
-		cmpFun = UnequalCmp;
-		break;
-	case 'l':
-		cmpFun = LessEqualCmp;
-		break;
-	case 'm':
-		cmpFun = MoreEqualCmp;
-		break;
-	case 'd':
-		cmpFun = DiffByCmp;
-		p = getLineEditValue(diffByEdit);
-		break;
-	case '%':
-		cmpFun = ModIsCmp;
-		p = getLineEditValue(moduloEdit);
-		break;
-	default:
-		cmpFun = NULL;
-		break;
-	}
-
-	if (cmpFun == NULL)
+	if (op < 0)
 	{
 		return;
 	}
 	y = getLineEditValue(specAddrEdit);
 
-	//printf("Performing Specific Address Search Operation %zi: 'x %c 0x%llx' '%lli'  '0x%llx' \n", deactvFrameStack.size()+1, cmpOp,
+	//printf("Performing Specific Address Search Operation %zi: 'x %c 0x%llx' '%lli'  '0x%llx' \n", memSearch->undoDepth()+1, cmpOp,
 	//     (unsigned long long int)y, (long long int)p, (unsigned long long int)p );
 
-	it = actvSrchList.begin();
-
-	while (it != actvSrchList.end())
+	if (storeHistory)
 	{
-		loc = *it;
-
-		x = loc->addr;
-
-		if (cmpFun(x, y, p) == false)
-		{
-			//printf("Eliminated Address: $%04X\n", loc->addr );
-			it = actvSrchList.erase(it);
-
-			if (storeHistory)
-			{
-				deactvSrchList.push_back(loc);
-				elimCount++;
-			}
-		}
-		else
-		{
-			if (storeHistory)
-			{
-				loc->hist.push_back(loc->val);
-			}
-			it++;
-		}
+		memSearch->pushUndo();
 	}
 
+	memSearch->filterAddress((FCEU::MemSearch::Op)op, y, p);
+
 	if (storeHistory)
 	{
-		deactvFrameStack.push_back(elimCount);
+		memSearch->commitPrevious();
 	}
 
-	vbar->setMaximum(actvSrchList.size());
+	vbar->setMaximum(memSearch->count());
 }
 //----------------------------------------------------------------------------
 void RamSearchDialog_t::SearchNumberChanges(void)
 {
-	int elimCount = 0;
-	std::list<struct memoryLocation_t *>::iterator it;
-	memoryLocation_t *loc = NULL;
-	int64_t x = 0, y = 0, p = 0;
-	bool (*cmpFun)(int64_t x, int64_t y, int64_t p) = NULL;
+	int op = getSearchOp(cmpOp);
+	int64_t p = getCompareParam(cmpOp), y = 0;
 	bool storeHistory = !autoSearchCbox->isChecked();
 
-	switch (cmpOp)
-	{
-	case '<':
-		cmpFun = LessCmp;
-		break;
-	case '>':
-		cmpFun = MoreCmp;
-		break;
-	case '=':
-		cmpFun = EqualCmp;
-		break;
-	case '!':
-		cmpFun = UnequalCmp;
-		break;
-	case 'l':
-		cmpFun = LessEqualCmp;
-		break;
-	case 'm':
-		cmpFun = MoreEqualCmp;
-		break;
-	case 'd':
-		cmpFun = DiffByCmp;
-		p = getLineEditValue(diffByEdit);
-		break;
-	case '%':
-		cmpFun = ModIsCmp;
-		p = getLineEditValue(moduloEdit);
-		break;
-	default:
-		cmpFun = NULL;
-		break;
-	}
-
-	if (cmpFun == NULL)
+	if (op < 0)
 	{
 		return;
 	}
 	y = getLineEditValue(numChangeEdit);
 
-	//printf("Performing Number of Changes Search Operation %zi: 'x %c 0x%llx' '%lli'  '0x%llx' \n", deactvFrameStack.size()+1, cmpOp,
+	//printf("Performing Number of Changes Search Operation %zi: 'x %c 0x%llx' '%lli'  '0x%llx' \n", memSearch->undoDepth()+1, cmpOp,
 	//     (unsigned long long int)y, (long long int)p, (unsigned long long int)p );
 
-	it = actvSrchList.begin();
-
-	while (it != actvSrchList.end())
-	{
-		loc = *it;
-
-		x = loc->chgCount;
-
-		if (cmpFun(x, y, p) == false)
-		{
-			//printf("Eliminated Address: $%04X\n", loc->addr );
-			it = actvSrchList.erase(it);
-
-			if (storeHistory)
-			{
-				deactvSrchList.push_back(loc);
-				elimCount++;
-			}
-		}
-		else
-		{
-			if (storeHistory)
-			{
-				loc->hist.push_back(loc->val);
-			}
-			it++;
-		}
-	}
-
 	if (storeHistory)
 	{
-		deactvFrameStack.push_back(elimCount);
+		memSearch->pushUndo();
 	}
 
-	vbar->setMaximum(actvSrchList.size());
-}
-//----------------------------------------------------------------------------
-static unsigned int ReadValueAtHardwareAddress(int address, unsigned int size)
-{
-	unsigned int value = 0;
-	int maxAddr = ShowROM ? 0x10000 : 0x8000;
+	memSearch->filterChanges((FCEU::MemSearch::Op)op, y, p);
 
-	// read as little endian
-	for (unsigned int i = 0; i < size; i++)
+	if (storeHistory)
 	{
-		if (address < maxAddr)
-		{
-			value <<= 8;
-			value |= lclMemBuf[address];
-			address++;
-		}
+		memSearch->commitPrevious();
 	}
-	return value;
+
+	vbar->setMaximum(memSearch->count());
 }
 //----------------------------------------------------------------------------
 void RamSearchDialog_t::runSearch(void)
@@ -1132,40 +790,51 @@ void RamSearchDialog_t::runSearch(void)
 		SearchNumberChanges();
 	}
 
-	undoButton->setEnabled(deactvFrameStack.size() > 0);
+	undoButton->setEnabled(memSearch->undoDepth() > 0);
 }
 //----------------------------------------------------------------------------
 void RamSearchDialog_t::copyRamToLocalBuffer(void)
 {
-	for (unsigned int addr = 0; addr < 0x10000; addr++)
+	uint8_t *buf = memSearch->current();
+	unsigned int addr, endAddr = ShowROM ? 0x10000 : 0x8000;
+
+	// Only the searchable regions, the registers in between are never candidates
+	for (addr = 0x0000; addr < 0x0800; addr++)
+	{
+		buf[addr] = GetMem(addr);
+	}
+	for (addr = 0x6000; addr < endAddr; addr++)
+	{
+		buf[addr] = GetMem(addr);
+	}
+}
+//----------------------------------------------------------------------------
+// Per-frame refresh: RAM and SRAM come from the frame snapshot so the search
+// never stops the emulation thread.  ROM is not in the snapshot.
+void RamSearchDialog_t::copySnapshotToLocalBuffer(void)
+{
+	const FrameSnapshot *snap = frameSnapshotAcquire();
+
+	if ( ShowROM || !snap->valid || !(snap->parts & SNAPSHOT_RAM) )
 	{
-		lclMemBuf[addr] = GetMem(addr);
+		FCEU_WRAPPER_LOCK();
+		copyRamToLocalBuffer();
+		FCEU_WRAPPER_UNLOCK();
+		return;
 	}
+	uint8_t *buf = memSearch->current();
+
+	memcpy( &buf[0x0000], snap->ram , sizeof(snap->ram ) );
+	memcpy( &buf[0x6000], snap->sram, sizeof(snap->sram) );
 }
 //----------------------------------------------------------------------------
 void RamSearchDialog_t::resetSearch(void)
 {
-	memset(lclMemBuf, 0, sizeof(lclMemBuf));
-
 	FCEU_WRAPPER_LOCK();
 	copyRamToLocalBuffer();
 	FCEU_WRAPPER_UNLOCK();
 
-	actvSrchList.clear();
-	deactvSrchList.clear();
-	deactvFrameStack.clear();
-
-	for (unsigned int addr = 0; addr < 0x10000; addr++)
-	{
-		memLoc[addr].hist.clear();
-		memLoc[addr].addr = addr;
-		memLoc[addr].val.v8.u = lclMemBuf[addr];
-		memLoc[addr].val.v16.u = ReadValueAtHardwareAddress(addr, 2);
-		memLoc[addr].val.v32.u = ReadValueAtHardwareAddress(addr, 4);
-		memLoc[addr].elimMask = 0;
-		memLoc[addr].chgCount = 0;
-		memLoc[addr].hist.push_back(memLoc[addr].val);
-	}
+	memSearch->reset();
 
 	calcRamList();
 
@@ -1174,143 +843,45 @@ void RamSearchDialog_t::resetSearch(void)
 //----------------------------------------------------------------------------
 void RamSearchDialog_t::undoSearch(void)
 {
-	int elimCount = 0;
-	memoryLocation_t *loc = NULL;
-	std::list<struct memoryLocation_t *>::iterator it;
-
-	if (deactvFrameStack.empty())
+	if (memSearch->undoDepth() == 0)
 	{
 		printf("Error: UNDO Stack is empty\n");
 		return;
 	}
-	printf("UNDO Search Operation: %zi \n", deactvFrameStack.size());
-	// To Undo a search operation:
-	// 1. Loop through all current active values and revert previous value back to what it was before the search
-	// 2. Get the number of eliminated values from the deactivate search stack and tranfer those values back into the active search list.
+	printf("UNDO Search Operation: %zi \n", memSearch->undoDepth());
 
-	it = actvSrchList.begin();
+	// Restores the candidates and previous values from before the last search
+	memSearch->undo();
 
-	while (it != actvSrchList.end())
-	{
-		loc = *it;
-
-		if (!loc->hist.empty())
-		{
-			loc->hist.pop_back();
-		}
-		it++;
-	}
+	vbar->setMaximum(memSearch->count());
 
-	elimCount = deactvFrameStack.back();
-	deactvFrameStack.pop_back();
-
-	while (elimCount > 0)
-	{
-		if (deactvSrchList.empty())
-		{
-			printf("Error: Something went wrong with UNDO operation\n");
-			break;
-		}
-		loc = deactvSrchList.back();
-		deactvSrchList.pop_back();
-		actvSrchList.push_back(loc);
-		elimCount--;
-	}
-
-	sortActvMemList();
-
-	undoButton->setEnabled(deactvFrameStack.size() > 0);
+	undoButton->setEnabled(memSearch->undoDepth() > 0);
 }
 //----------------------------------------------------------------------------
 void RamSearchDialog_t::clearChangeCounts(void)
 {
-	for (unsigned int addr = 0; addr < 0x10000; addr++)
-	{
-		memLoc[addr].chgCount = 0;
-	}
+	memSearch->clearChangeCounts();
 }
 //----------------------------------------------------------------------------
 void RamSearchDialog_t::eliminateSelAddr(void)
 {
-	int elimCount = 0, op = '!';
-	std::list<struct memoryLocation_t *>::iterator it;
-	memoryLocation_t *loc = NULL;
-	int64_t x = 0, y = 0, p = 0;
-	bool (*cmpFun)(int64_t x, int64_t y, int64_t p) = NULL;
-
-	switch (op)
-	{
-	case '<':
-		cmpFun = LessCmp;
-		break;
-	case '>':
-		cmpFun = MoreCmp;
-		break;
-	case '=':
-		cmpFun = EqualCmp;
-		break;
-	case '!':
-		cmpFun = UnequalCmp;
-		break;
-	case 'l':
-		cmpFun = LessEqualCmp;
-		break;
-	case 'm':
-		cmpFun = MoreEqualCmp;
-		break;
-	case 'd':
-		cmpFun = DiffByCmp;
-		p = getLineEditValue(diffByEdit);
-		break;
-	case '%':
-		cmpFun = ModIsCmp;
-		p = getLineEditValue(moduloEdit);
-		break;
-	default:
-		cmpFun = NULL;
-		break;
-	}
-
-	if (cmpFun == NULL)
-	{
-		return;
-	}
-	y = ramView->getSelAddr();
+	int64_t y = ramView->getSelAddr();
 
 	if (y < 0)
 	{
 		return;
 	}
 
-	printf("Performing Eliminate Address Operation %zi: 'x %c 0x%llx' '%lli'  '0x%llx' \n", deactvFrameStack.size() + 1, cmpOp,
-		   (unsigned long long int)y, (long long int)p, (unsigned long long int)p);
+	printf("Performing Eliminate Address Operation %zi: 'x != 0x%llx'\n", memSearch->undoDepth() + 1,
+		   (unsigned long long int)y);
 
-	it = actvSrchList.begin();
+	memSearch->pushUndo();
 
-	while (it != actvSrchList.end())
-	{
-		loc = *it;
-
-		x = loc->addr;
+	memSearch->filterAddress(FCEU::MemSearch::OP_NE, y);
 
-		if (cmpFun(x, y, p) == false)
-		{
-			//printf("Eliminated Address: $%04X\n", loc->addr );
-			it = actvSrchList.erase(it);
+	memSearch->commitPrevious();
 
-			deactvSrchList.push_back(loc);
-			elimCount++;
-		}
-		else
-		{
-			loc->hist.push_back(loc->val);
-			it++;
-		}
-	}
-
-	deactvFrameStack.push_back(elimCount);
-
-	vbar->setMaximum(actvSrchList.size());
+	vbar->setMaximum(memSearch->count());
 }
 //----------------------------------------------------------------------------
 void RamSearchDialog_t::addCheatClicked(void)
@@ -1483,22 +1054,25 @@ void RamSearchDialog_t::ds4Clicked(void)
 void RamSearchDialog_t::signedTypeClicked(void)
 {
 	dpyType = 's';
+	memSearch->setValueType(getValueSize(), true);
 }
 //----------------------------------------------------------------------------
 void RamSearchDialog_t::unsignedTypeClicked(void)
 {
 	dpyType = 'u';
+	memSearch->setValueType(getValueSize(), false);
 }
 //----------------------------------------------------------------------------
 void RamSearchDialog_t::hexTypeClicked(void)
 {
 	dpyType = 'h';
+	memSearch->setValueType(getValueSize(), false);
 }
 //----------------------------------------------------------------------------
 void RamSearchDialog_t::calcRamList(void)
 {
-	int i, addr, startAddr, endAddr;
-	int numRegions = 0, dataSize = 1;
+	int i, startAddr, endAddr;
+	int numRegions = 0, dataSize = 1, valSize;
 	int regionStart[5], regionEnd[5];
 
 	if ( ShowRAM )
@@ -1522,108 +1096,28 @@ void RamSearchDialog_t::calcRamList(void)
 		numRegions++;
 	}
 
-	if (chkMisAligned)
-	{
-		dataSize = 1;
-	}
-	else if (dpySize == 'd')
-	{
-		dataSize = 4;
-	}
-	else if (dpySize == 'w')
-	{
-		dataSize = 2;
-	}
-	else
-	{
-		dataSize = 1;
-	}
+	valSize = getValueSize();
+
+	dataSize = chkMisAligned ? 1 : valSize;
 
-	actvSrchList.clear();
+	memSearch->setValueType(valSize, dpyType == 's');
+
+	memSearch->clearCandidates();
 
 	for (i=0; i<numRegions; i++)
 	{
 		startAddr = regionStart[i];
 		  endAddr = regionEnd[i];
 
-		for (addr = startAddr; addr < endAddr; addr += dataSize)
-		{
-			switch (dpySize)
-			{
-			case 'd':
-				if ((addr + 3) < endAddr)
-				{
-					if ((memLoc[addr].elimMask == 0) &&
-						(memLoc[addr + 1].elimMask == 0) &&
-						(memLoc[addr + 2].elimMask == 0) &&
-						(memLoc[addr + 3].elimMask == 0))
-					{
-						actvSrchList.push_back(&memLoc[addr]);
-					}
-				}
-				break;
-			case 'w':
-				if ((addr + 1) < endAddr)
-				{
-					if ((memLoc[addr].elimMask == 0) &&
-						(memLoc[addr + 1].elimMask == 0))
-					{
-						actvSrchList.push_back(&memLoc[addr]);
-					}
-				}
-				break;
-			default:
-			case 'b':
-				if (memLoc[addr].elimMask == 0)
-				{
-					actvSrchList.push_back(&memLoc[addr]);
-				}
-				break;
-			}
-		}
+		// Values must fit entirely inside the region
+		memSearch->addCandidates(startAddr, endAddr - (valSize - 1), dataSize);
 	}
-	vbar->setMaximum(actvSrchList.size());
+	vbar->setMaximum(memSearch->count());
 }
 //----------------------------------------------------------------------------
 void RamSearchDialog_t::updateRamValues(void)
 {
-	std::list<struct memoryLocation_t *>::iterator it;
-	memoryLocation_t *loc = NULL;
-	memoryState_t val;
-
-	for (it = actvSrchList.begin(); it != actvSrchList.end(); it++)
-	{
-		loc = *it;
-
-		val.v8.u = lclMemBuf[loc->addr];
-		val.v16.u = ReadValueAtHardwareAddress(loc->addr, 2);
-		val.v32.u = ReadValueAtHardwareAddress(loc->addr, 4);
-
-		if (dpySize == 'd')
-		{
-			if (memLoc[loc->addr].val.v32.u != val.v32.u)
-			{
-				memLoc[loc->addr].val = val;
-				memLoc[loc->addr].chgCount++;
-			}
-		}
-		else if (dpySize == 'w')
-		{
-			if (memLoc[loc->addr].val.v16.u != val.v16.u)
-			{
-				memLoc[loc->addr].val = val;
-				memLoc[loc->addr].chgCount++;
-			}
-		}
-		else
-		{
-			if (memLoc[loc->addr].val.v8.u != val.v8.u)
-			{
-				memLoc[loc->addr].val = val;
-				memLoc[loc->addr].chgCount++;
-			}
-		}
-	}
+	memSearch->update();
 }
 //----------------------------------------------------------------------------
 QRamSearchView::QRamSearchView(QWidget *parent)
@@ -1778,9 +1272,9 @@ void QRamSearchView::keyPressEvent(QKeyEvent *event)
 		selAddr = -1;
 		selLine++;
 
-		if ( static_cast<size_t>(selLine) >= actvSrchList.size())
+		if ( static_cast<size_t>(selLine) >= memSearch->count())
 		{
-			selLine = actvSrchList.size() - 1;
+			selLine = memSearch->count() - 1;
 		}
 
 		if (selLine >= (lineOffset + viewLines))
@@ -1896,11 +1390,10 @@ void QRamSearchView::wheelEvent(QWheelEvent *event)
 //----------------------------------------------------------------------------
 void QRamSearchView::paintEvent(QPaintEvent *event)
 {
-	int i, x, y, row, nrow;
-	std::list<struct memoryLocation_t *>::iterator it;
+	int i, x, y, row, nrow, addr;
+	uint32_t val, prev;
 	char addrStr[32], valStr[32], prevStr[32], chgStr[32];
 	QPainter painter(this);
-	memoryLocation_t *loc = NULL;
 	int fieldWidth, fieldPad[4], fieldLen[4], fieldStart[4];
 	const char *fieldText[4];
 
@@ -1921,7 +1414,7 @@ void QRamSearchView::paintEvent(QPaintEvent *event)
 
 	viewLines = nrow;
 
-	maxLineOffset = actvSrchList.size() - nrow;
+	maxLineOffset = memSearch->count() - nrow;
 
 	if (maxLineOffset < 1)
 		maxLineOffset = 1;
@@ -1941,17 +1434,7 @@ void QRamSearchView::paintEvent(QPaintEvent *event)
 		vbar->setValue(0);
 	}
 
-	i = 0;
-	it = actvSrchList.begin();
-	while (it != actvSrchList.end())
-	{
-		if (i == lineOffset)
-		{
-			break;
-		}
-		i++;
-		it++;
-	}
+	addr = memSearch->nth(lineOffset);
 
 	painter.fillRect(0, 0, viewWidth, viewHeight, this->palette().color(QPalette::Window));
 
@@ -1985,16 +1468,7 @@ void QRamSearchView::paintEvent(QPaintEvent *event)
 
 	for (row = 0; row < nrow; row++)
 	{
-		if (it != actvSrchList.end())
-		{
-			loc = *it;
-		}
-		else
-		{
-			loc = NULL;
-		}
-
-		if (loc == NULL)
+		if (addr < 0)
 		{
 			continue;
 		}
@@ -2002,73 +1476,77 @@ void QRamSearchView::paintEvent(QPaintEvent *event)
 		{
 			if (selLine == (lineOffset + row))
 			{
-				selAddr = loc->addr;
+				selAddr = addr;
 			}
 		}
-		it++;
 
-		if (selAddr == loc->addr)
+		if (selAddr == addr)
 		{
 			painter.fillRect(0, y - pxLineSpacing + pxLineLead, viewWidth, pxLineSpacing, QColor("light blue"));
 		}
 
-		sprintf(addrStr, "$%04X", loc->addr);
+		sprintf(addrStr, "$%04X", addr);
+
+		val  = memSearch->currentValue(addr);
+		prev = memSearch->previousValue(addr);
 
 		if (dpySize == 'd')
 		{
 			if (dpyType == 'h')
 			{
-				sprintf(valStr, "0x%08X", loc->val.v32.u);
-				sprintf(prevStr, "0x%08X", loc->hist.back().v32.u);
+				sprintf(valStr, "0x%08X", val);
+				sprintf(prevStr, "0x%08X", prev);
 			}
 			else if (dpyType == 'u')
 			{
-				sprintf(valStr, "%u", loc->val.v32.u);
-				sprintf(prevStr, "%u", loc->hist.back().v32.u);
+				sprintf(valStr, "%u", val);
+				sprintf(prevStr, "%u", prev);
 			}
 			else
 			{
-				sprintf(valStr, "%i", loc->val.v32.i);
-				sprintf(prevStr, "%i", loc->hist.back().v32.i);
+				sprintf(valStr, "%i", (int32_t)val);
+				sprintf(prevStr, "%i", (int32_t)prev);
 			}
 		}
 		else if (dpySize == 'w')
 		{
 			if (dpyType == 'h')
 			{
-				sprintf(valStr, "0x%04X", loc->val.v16.u);
-				sprintf(prevStr, "0x%04X", loc->hist.back().v16.u);
+				sprintf(valStr, "0x%04X", val);
+				sprintf(prevStr, "0x%04X", prev);
 			}
 			else if (dpyType == 'u')
 			{
-				sprintf(valStr, "%u", loc->val.v16.u);
-				sprintf(prevStr, "%u", loc->hist.back().v16.u);
+				sprintf(valStr, "%u", val);
+				sprintf(prevStr, "%u", prev);
 			}
 			else
 			{
-				sprintf(valStr, "%i", loc->val.v16.i);
-				sprintf(prevStr, "%i", loc->hist.back().v16.i);
+				sprintf(valStr, "%i", (int16_t)val);
+				sprintf(prevStr, "%i", (int16_t)prev);
 			}
 		}
 		else
 		{
 			if (dpyType == 'h')
 			{
-				sprintf(valStr, "0x%02X", loc->val.v8.u);
-				sprintf(prevStr, "0x%02X", loc->hist.back().v8.u);
+				sprintf(valStr, "0x%02X", val);
+				sprintf(prevStr, "0x%02X", prev);
 			}
 			else if (dpyType == 'u')
 			{
-				sprintf(valStr, "%u", loc->val.v8.u);
-				sprintf(prevStr, "%u", loc->hist.back().v8.u);
+				sprintf(valStr, "%u", val);
+				sprintf(prevStr, "%u", prev);
 			}
 			else
 			{
-				sprintf(valStr, "%i", loc->val.v8.i);
-				sprintf(prevStr, "%i", loc->hist.back().v8.i);
+				sprintf(valStr, "%i", (int8_t)val);
+				sprintf(prevStr, "%i", (int8_t)prev);
 			}
 		}
-		sprintf(chgStr, "%u", loc->chgCount);
+		sprintf(chgStr, "%u", memSearch->changeCount(addr));
+
+		addr = memSearch->next(addr + 1);
 
 		for (i = 0; i < 4; i++)
 		{
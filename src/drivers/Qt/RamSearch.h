@@ -135,6 +135,8 @@ class RamSearchDialog_t : public QDialog
 		void SearchSpecificAddress(void);
 		void SearchNumberChanges(void);
 		void copyRamToLocalBuffer(void);
+		void copySnapshotToLocalBuffer(void);
+		int64_t getCompareParam(int op);
 
 	public slots:
 		void closeWindow(void);
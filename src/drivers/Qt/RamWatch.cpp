@@ -48,6 +48,7 @@
 #include "Qt/config.h"
 #include "Qt/keyscan.h"
 #include "Qt/fceuWrapper.h"
+#include "Qt/FrameSnapshot.h"
 #include "Qt/RamWatch.h"
 #include "Qt/CheatsConf.h"
 #include "Qt/ConsoleUtilities.h"
@@ -306,6 +307,8 @@ RamWatchDialog_t::RamWatchDialog_t(QWidget *parent)
 
 	updateTimer->start( 100 ); // 10hz
 
+	frameSnapshotAddReader( SNAPSHOT_RAM );
+
 	restoreGeometry(settings.value("ramWatch/geometry").toByteArray());
 }
 //----------------------------------------------------------------------------
@@ -315,6 +318,8 @@ RamWatchDialog_t::~RamWatchDialog_t(void)
 
 	updateTimer->stop();
 
+	frameSnapshotRemoveReader( SNAPSHOT_RAM );
+
 	if ( ramWatchMainWin == this )
 	{
 	   ramWatchMainWin = NULL;
@@ -377,6 +382,10 @@ void RamWatchDialog_t::updateRamWatchDisplay(void)
 	std::list < ramWatch_t * >::iterator it;
 	char addrStr[32], valStr1[16], valStr2[16];
 	ramWatch_t *rw;
+	const FrameSnapshot *snap;
+
+	// One snapshot for the whole list, so every row shows the same frame.
+	snap = frameSnapshotAcquire();
 
 	for (it = ramWatchList.ls.begin (); it != ramWatchList.ls.end (); it++)
 	{
@@ -411,7 +420,7 @@ void RamWatchDialog_t::updateRamWatchDisplay(void)
 			}
 		}
 
-		rw->updateMem ();
+		rw->updateMem (snap);
 
 		if ( rw->isSep || (rw->addr < 0) )
 		{
@@ -721,26 +730,36 @@ void RamWatchDialog_t::saveListAs(void)
 	saveWatchFile( filename.toStdString().c_str() );
 }
 //----------------------------------------------------------------------------
-void ramWatch_t::updateMem (void)
+// RAM and SRAM come from the last published frame snapshot, so the
+// watch list never touches the core while the emulation thread runs.
+static int readWatchByte( const FrameSnapshot *snap, int addr )
+{
+	int v = snap->valid ? snap->peekCPU(addr) : -1;
+
+	return (v >= 0) ? v : GetMem(addr);
+}
+//----------------------------------------------------------------------------
+void ramWatch_t::updateMem (const FrameSnapshot *snap)
 {
 	if ( addr < 0 )
 	{
 		return;
 	}
+
 	if (size == 1)
 	{
-		val.u8 = GetMem (addr);
+		val.u8 = readWatchByte (snap, addr);
 	}
 	else if (size == 2)
 	{
-		val.u16 = (GetMem (addr) << 8) | GetMem (addr + 1);
+		val.u16 = (readWatchByte (snap, addr) << 8) | readWatchByte (snap, addr + 1);
 	}
 	else if (size == 4)
 	{
-		val.u32  = GetMem (addr + 3);
-		val.u32 |= GetMem (addr + 2) << 8;
-		val.u32 |= GetMem (addr + 1) << 16;
-		val.u32 |= GetMem (addr    ) << 24;
+		val.u32  = readWatchByte (snap, addr + 3);
+		val.u32 |= readWatchByte (snap, addr + 2) << 8;
+		val.u32 |= readWatchByte (snap, addr + 1) << 16;
+		val.u32 |= readWatchByte (snap, addr    ) << 24;
 	}
 }
 //------------------------------------------------------------------------.----
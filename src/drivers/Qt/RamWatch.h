@@ -19,6 +19,8 @@
 
 #include "Qt/main.h"
 
+struct FrameSnapshot;
+
 struct ramWatch_t
 {
 	std::string name;
@@ -46,7 +48,7 @@ struct ramWatch_t
 		val.u32 = 0;
 	};
 
-	void updateMem (void);
+	void updateMem (const FrameSnapshot *snap);
 };
 
 struct ramWatchList_t
@@ -104,7 +106,7 @@ struct ramWatchList_t
 		ls.push_back (rw);
 	}
 
-	void updateMemoryValues (void)
+	void updateMemoryValues (const FrameSnapshot *snap)
 	{
 		ramWatch_t *rw;
 		std::list < ramWatch_t * >::iterator it;
@@ -113,7 +115,7 @@ struct ramWatchList_t
 		{
 			rw = *it;
 
-			rw->updateMem ();
+			rw->updateMem (snap);
 		}
 	}
 
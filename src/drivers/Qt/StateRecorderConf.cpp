@@ -629,7 +629,7 @@ void StateRecorderDialog_t::recalcMemoryUsage(void)
 		for (int i=0; i<numIterations; i++)
 		{
 			em.set_len(0);
-			FCEUSS_SaveMS( &em, compressionLevel );
+			FCEUSS_SaveMS( &em, compressionLevel, false );
 		}
 		ts_end   = getHighPrecTimeStamp();
 
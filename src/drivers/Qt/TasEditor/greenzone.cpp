@@ -11,6 +11,7 @@ Greenzone - Access zone
 [Single instance]
 
 * stores array of savestates, used for faster movie navigation by Playback cursor
+* savestates are grouped into keyframes and XOR/RLE deltas against them; compression runs on worker threads and results are picked up in update()
 * also stores LagLog of current movie Input
 * saves and loads the data from a project file. On error: truncates Greenzone to last successfully read savestate
 * regularly checks if there's a savestate of current emulation state, if there's no such savestate in array then creates one and updates lag info for previous frame
@@ -22,9 +23,13 @@ Greenzone - Access zone
 
 #include <zlib.h>
 
+#include <QThreadPool>
+#include <QRunnable>
+
 #include "fceu.h"
 #include "state.h"
 #include "driver.h"
+#include "utils/endian.h"
 #include "Qt/TasEditor/taseditor_project.h"
 #include "Qt/TasEditor/TasEditorWindow.h"
 
@@ -33,9 +38,176 @@ extern char lagFlag;
 static char greenzone_save_id[GREENZONE_ID_LEN] = "GREENZONE";
 static char greenzone_skipsave_id[GREENZONE_ID_LEN] = "GREENZONX";
 
+// savestate header as written by FCEUSS_SaveMS: "FCSX", size, version, compressed size (~0 = uncompressed)
+#define SAVESTATE_HEADER_SIZE 16
+
+// turns an uncompressed savestate into a compressed one, other savestates are copied as is
+static void compressSavestate(const std::vector<uint8_t>& raw, std::vector<uint8_t>& out)
+{
+	if (raw.size() <= SAVESTATE_HEADER_SIZE || FCEU_de32lsb((uint8*)&raw[12]) != ~0u)
+	{
+		out = raw;
+		return;
+	}
+	uLong len = raw.size() - SAVESTATE_HEADER_SIZE;
+	uLongf comprlen = compressBound(len);
+	out.resize(SAVESTATE_HEADER_SIZE + comprlen);
+	if (compress2(&out[SAVESTATE_HEADER_SIZE], &comprlen, &raw[SAVESTATE_HEADER_SIZE], len, Z_DEFAULT_COMPRESSION) != Z_OK)
+	{
+		out = raw;
+		return;
+	}
+	memcpy(&out[0], &raw[0], SAVESTATE_HEADER_SIZE);
+	FCEU_en32lsb(&out[12], comprlen);
+	out.resize(SAVESTATE_HEADER_SIZE + comprlen);
+}
+// turns any savestate into an uncompressed one
+static bool decompressSavestate(const std::vector<uint8_t>& in, std::vector<uint8_t>& raw)
+{
+	if (in.size() < SAVESTATE_HEADER_SIZE)
+		return false;
+	uint32 comprlen = FCEU_de32lsb((uint8*)&in[12]);
+	if (comprlen == ~0u)
+	{
+		raw = in;
+		return true;
+	}
+	uLongf len = FCEU_de32lsb((uint8*)&in[4]);
+	raw.resize(SAVESTATE_HEADER_SIZE + len);
+	if (uncompress(&raw[SAVESTATE_HEADER_SIZE], &len, &in[SAVESTATE_HEADER_SIZE], in.size() - SAVESTATE_HEADER_SIZE) != Z_OK)
+		return false;
+	memcpy(&raw[0], &in[0], SAVESTATE_HEADER_SIZE);
+	FCEU_en32lsb(&raw[12], ~0u);
+	raw.resize(SAVESTATE_HEADER_SIZE + len);
+	return true;
+}
+
+static void writeVarLen(std::vector<uint8_t>& out, uint32 value)
+{
+	while (value >= 0x80)
+	{
+		out.push_back((value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+	out.push_back(value);
+}
+static bool readVarLen(const uint8_t*& pos, const uint8_t* end, uint32& value)
+{
+	value = 0;
+	for (int shift = 0; pos < end && shift < 32; shift += 7)
+	{
+		uint8_t b = *pos++;
+		value |= (uint32)(b & 0x7F) << shift;
+		if (!(b & 0x80))
+			return true;
+	}
+	return false;
+}
+
+// delta = zlib(RLE(state XOR keyframe)), RLE is a list of (unchanged bytes count, changed bytes count, changed bytes)
+// both savestates must be uncompressed and of the same size
+static void encodeDelta(const std::vector<uint8_t>& raw, const std::vector<uint8_t>& keyRaw, std::vector<uint8_t>& out)
+{
+	std::vector<uint8_t> rle;
+	size_t size = raw.size(), i = 0;
+	while (i < size)
+	{
+		size_t start = i;
+		while (i < size && raw[i] == keyRaw[i]) i++;
+		writeVarLen(rle, i - start);
+		start = i;
+		// a short run of equal bytes is cheaper to store as part of the changed bytes
+		while (i < size && (raw[i] != keyRaw[i] || (i + 2 < size && (raw[i + 1] != keyRaw[i + 1] || raw[i + 2] != keyRaw[i + 2])))) i++;
+		writeVarLen(rle, i - start);
+		for (; start < i; start++)
+			rle.push_back(raw[start] ^ keyRaw[start]);
+	}
+	uLongf comprlen = compressBound(rle.size());
+	out.resize(4 + comprlen);
+	FCEU_en32lsb(&out[0], rle.size());
+	if (compress2(&out[4], &comprlen, rle.data(), rle.size(), Z_BEST_SPEED) != Z_OK)
+		comprlen = 0;
+	out.resize(4 + comprlen);
+}
+static bool decodeDelta(const std::vector<uint8_t>& delta, const std::vector<uint8_t>& keyRaw, std::vector<uint8_t>& out)
+{
+	if (delta.size() < 4)
+		return false;
+	uLongf len = FCEU_de32lsb((uint8*)&delta[0]);
+	std::vector<uint8_t> rle(len);
+	if (len && uncompress(rle.data(), &len, &delta[4], delta.size() - 4) != Z_OK)
+		return false;
+	out = keyRaw;
+	const uint8_t* pos = rle.data();
+	const uint8_t* end = pos + len;
+	size_t i = 0;
+	uint32 same, changed;
+	while (pos < end)
+	{
+		if (!readVarLen(pos, end, same) || !readVarLen(pos, end, changed))
+			return false;
+		i += same;
+		if (i + changed > out.size() || changed > (size_t)(end - pos))
+			return false;
+		for (; changed; changed--)
+			out[i++] ^= *pos++;
+	}
+	return true;
+}
+
+// compresses a new keyframe or makes a delta against its keyframe, runs on the Greenzone worker pool
+class GreenzoneCompressJob : public QRunnable
+{
+public:
+	GreenzoneCompressJob(GREENZONE* greenzone, unsigned int job, int frame, std::shared_ptr<GREENZONE_KEYFRAME> keyframe,
+			std::shared_ptr<std::vector<uint8_t>> raw, std::shared_ptr<std::vector<uint8_t>> keyRaw)
+		: greenzone(greenzone), job(job), frame(frame), keyframe(keyframe), raw(raw), keyRaw(keyRaw) {}
+
+	void run() override
+	{
+		GREENZONE_JOB_RESULT* result = new GREENZONE_JOB_RESULT;
+		result->job = job;
+		result->frame = frame;
+		if (keyRaw)
+			encodeDelta(*raw, *keyRaw, result->data);
+		else
+		{
+			result->keyframe = keyframe;
+			compressSavestate(*raw, result->data);
+		}
+		// drop the buffers before reporting, so that the emulation thread can reuse them right away
+		keyframe.reset();
+		raw.reset();
+		keyRaw.reset();
+		greenzone->postJobResult(result);
+	}
+
+private:
+	GREENZONE* greenzone;
+	unsigned int job;
+	int frame;
+	std::shared_ptr<GREENZONE_KEYFRAME> keyframe;
+	std::shared_ptr<std::vector<uint8_t>> raw;
+	std::shared_ptr<std::vector<uint8_t>> keyRaw;
+};
+
 GREENZONE::GREENZONE()
 {
 	nextCleaningTime = 0;
+	greenzoneSize = 0;
+	currentKeyframeFrame = -1;
+	lastJobId = 0;
+	workerPool = new QThreadPool();
+	workerPool->setMaxThreadCount(GREENZONE_COMPRESSION_THREADS);
+}
+
+GREENZONE::~GREENZONE()
+{
+	workerPool->waitForDone();
+	delete workerPool;
+	for (std::list<GREENZONE_JOB_RESULT*>::iterator it = jobResults.begin(); it != jobResults.end(); it++)
+		delete *it;
+	jobResults.clear();
 }
 
 void GREENZONE::init()
@@ -45,7 +217,12 @@ void GREENZONE::init()
 }
 void GREENZONE::free()
 {
+	// results of jobs still in flight won't match any frame anymore and will be dropped
 	savestates.resize(0);
+	currentKeyframe.reset();
+	currentKeyframeFrame = -1;
+	decodedKeyframe.reset();
+	decodedKeyframeRaw.clear();
 	greenzoneSize = 0;
 	lagLog.reset();
 }
@@ -55,6 +232,7 @@ void GREENZONE::reset()
 }
 void GREENZONE::update()
 {
+	installJobResults();
 	// keep collecting savestates, this code must be executed at the end of every frame
 	if (taseditorConfig->enableGreenzoning)
 	{
@@ -109,11 +287,42 @@ void GREENZONE::collectCurrentState()
 	if ((int)savestates.size() <= currFrameCounter)
 		savestates.resize(currFrameCounter + 1);
 	// if frame is not saved - log savestate
-	if (!savestates[currFrameCounter].size())
+	GREENZONE_FRAME& entry = savestates[currFrameCounter];
+	if (entry.empty())
 	{
-		EMUFILE_MEMORY ms(&savestates[currFrameCounter]);
-		FCEUSS_SaveMS(&ms, Z_DEFAULT_COMPRESSION);
+		// only the uncompressed savestate is taken here, the rest is up to the workers
+		std::shared_ptr<std::vector<uint8_t>> raw = allocRawBuffer();
+		EMUFILE_MEMORY ms(raw.get());
+		FCEUSS_SaveMS(&ms, Z_NO_COMPRESSION);
 		ms.trim();
+
+		std::shared_ptr<std::vector<uint8_t>> keyRaw;
+		if (currentKeyframe && currentKeyframe->raw
+			&& currFrameCounter > currentKeyframeFrame
+			&& (currFrameCounter & GREENZONE_KEYFRAME_MASK) == (currentKeyframeFrame & GREENZONE_KEYFRAME_MASK)
+			&& currentKeyframe->rawSize == raw->size())
+		{
+			// store as a delta against current keyframe
+			keyRaw = currentKeyframe->raw;
+			entry.keyframe = currentKeyframe;
+			entry.raw = raw;
+			entry.isKeyframe = false;
+		} else
+		{
+			// start new keyframe, the old one is not needed uncompressed anymore once it's compressed
+			if (currentKeyframe && !currentKeyframe->savestate.empty())
+				releaseRawBuffer(currentKeyframe->raw);
+			currentKeyframe = std::make_shared<GREENZONE_KEYFRAME>();
+			currentKeyframe->raw = raw;
+			currentKeyframe->rawSize = raw->size();
+			currentKeyframeFrame = currFrameCounter;
+			entry.keyframe = currentKeyframe;
+			entry.isKeyframe = true;
+		}
+		if (!++lastJobId)
+			lastJobId = 1;
+		entry.job = lastJobId;
+		workerPool->start(new GreenzoneCompressJob(this, entry.job, currFrameCounter, entry.keyframe, raw, keyRaw));
 	}
 	if (greenzoneSize <= currFrameCounter)
 		greenzoneSize = currFrameCounter + 1;
@@ -121,12 +330,114 @@ void GREENZONE::collectCurrentState()
 
 bool GREENZONE::loadSavestateOfFrame(unsigned int frame)
 {
-	if (frame >= savestates.size() || !savestates[frame].size())
+	installJobResults();
+	if (frame >= savestates.size() || savestates[frame].empty())
+		return false;
+	GREENZONE_FRAME& entry = savestates[frame];
+	// while the savestate is still uncompressed it can be loaded as is
+	std::vector<uint8_t>* direct = entry.raw.get();
+	if (entry.isKeyframe)
+		direct = entry.keyframe->raw ? entry.keyframe->raw.get() : &entry.keyframe->savestate;
+	if (direct)
+	{
+		EMUFILE_MEMORY ms(direct);
+		return FCEUSS_LoadFP(&ms, SSLOADPARAM_NOBACKUP);
+	}
+	std::vector<uint8_t> raw;
+	if (!rebuildRawSavestate(frame, raw))
 		return false;
-	EMUFILE_MEMORY ms(&savestates[frame]);
+	EMUFILE_MEMORY ms(&raw);
 	return FCEUSS_LoadFP(&ms, SSLOADPARAM_NOBACKUP);
 }
 
+// picks up the work done by the compression workers, must be called from the emulation thread
+void GREENZONE::installJobResults()
+{
+	std::list<GREENZONE_JOB_RESULT*> results;
+	{
+		FCEU::autoScopedLock lock(jobResultsMutex);
+		results.swap(jobResults);
+	}
+	for (std::list<GREENZONE_JOB_RESULT*>::iterator it = results.begin(); it != results.end(); it++)
+	{
+		GREENZONE_JOB_RESULT* result = *it;
+		if (result->keyframe)
+		{
+			// deltas may still be using the keyframe even if its own frame was cleared meanwhile
+			result->keyframe->savestate.swap(result->data);
+			if (result->keyframe != currentKeyframe)
+				releaseRawBuffer(result->keyframe->raw);
+			if (result->frame < (int)savestates.size() && savestates[result->frame].job == result->job)
+				savestates[result->frame].job = 0;
+		} else if (result->frame < (int)savestates.size() && savestates[result->frame].job == result->job)
+		{
+			GREENZONE_FRAME& entry = savestates[result->frame];
+			entry.delta.swap(result->data);
+			entry.job = 0;
+			releaseRawBuffer(entry.raw);
+		}
+		delete result;
+	}
+}
+void GREENZONE::postJobResult(GREENZONE_JOB_RESULT* result)
+{
+	FCEU::autoScopedLock lock(jobResultsMutex);
+	jobResults.push_back(result);
+}
+void GREENZONE::waitForPendingJobs()
+{
+	workerPool->waitForDone();
+	installJobResults();
+}
+
+bool GREENZONE::rebuildRawSavestate(unsigned int frame, std::vector<uint8_t>& out)
+{
+	GREENZONE_FRAME& entry = savestates[frame];
+	if (entry.empty())
+		return false;
+	// delta is not made yet
+	if (entry.raw)
+	{
+		out = *entry.raw;
+		return true;
+	}
+	const std::vector<uint8_t>* keyRaw = entry.keyframe->raw.get();
+	if (!keyRaw)
+	{
+		if (decodedKeyframe != entry.keyframe)
+		{
+			decodedKeyframe.reset();
+			if (!decompressSavestate(entry.keyframe->savestate, decodedKeyframeRaw))
+				return false;
+			decodedKeyframe = entry.keyframe;
+		}
+		keyRaw = &decodedKeyframeRaw;
+	}
+	if (entry.isKeyframe)
+	{
+		out = *keyRaw;
+		return true;
+	}
+	return decodeDelta(entry.delta, *keyRaw, out);
+}
+
+std::shared_ptr<std::vector<uint8_t>> GREENZONE::allocRawBuffer()
+{
+	if (rawBufferPool.empty())
+		return std::make_shared<std::vector<uint8_t>>();
+	std::shared_ptr<std::vector<uint8_t>> buf = rawBufferPool.back();
+	rawBufferPool.pop_back();
+	buf->clear();
+	return buf;
+}
+void GREENZONE::releaseRawBuffer(std::shared_ptr<std::vector<uint8_t>>& buf)
+{
+	// a buffer still referenced by a worker is simply dropped
+	if (buf && buf.use_count() == 1 && rawBufferPool.size() < GREENZONE_RAW_BUFFER_POOL_SIZE)
+		rawBufferPool.push_back(buf);
+	buf.reset();
+}
+
 void GREENZONE::runGreenzoneCleaning()
 {
 	bool changed = false;
@@ -186,9 +497,9 @@ finish:
 // returns true if actually cleared savestate data
 bool GREENZONE::clearSavestateOfFrame(unsigned int frame)
 {
-	if (frame < savestates.size() && savestates[frame].size())
+	if (frame < savestates.size() && !savestates[frame].empty())
 	{
-	    savestates[frame].resize(0);
+		savestates[frame].clear();
 		return true;
 	}
 	else
@@ -198,11 +509,9 @@ bool GREENZONE::clearSavestateOfFrame(unsigned int frame)
 }
 bool GREENZONE::clearSavestateAndFreeMemory(unsigned int frame)
 {
-	if (frame < savestates.size() && savestates[frame].size())
+	if (frame < savestates.size() && !savestates[frame].empty())
 	{
-		//savestates[frame].swap(std::vector<uint8_t>()); //FIXME
 		savestates[frame].clear();
-		savestates[frame].shrink_to_fit();
 		return true;
 	}
 	else
@@ -238,6 +547,7 @@ void GREENZONE::save(EMUFILE *os, int save_type)
 	{
 		setTasProjectProgressBarText("Saving Greenzone...");
 		collectCurrentState();		// in case the project is being saved before the greenzone.update() was called within current frame
+		waitForPendingJobs();
 		runGreenzoneCleaning();
 		if (greenzoneSize > (int)savestates.size())
 			greenzoneSize = savestates.size();
@@ -252,7 +562,7 @@ void GREENZONE::save(EMUFILE *os, int save_type)
 
 		setTasProjectProgressBar( 0, greenzoneSize );
 	}
-	int frame, size;
+	int frame;
 	int last_tick = -1;
 
 	switch (save_type)
@@ -269,12 +579,10 @@ void GREENZONE::save(EMUFILE *os, int save_type)
 					playback->setProgressbar(frame, greenzoneSize);
 					last_tick = frame / PROGRESSBAR_UPDATE_RATE;
 				}
-				if (!savestates[frame].size()) continue;
+				if (savestates[frame].empty()) continue;
 				write32le(frame, os);
 				// write savestate
-				size = savestates[frame].size();
-				write32le(size, os);
-				os->fwrite(&savestates[frame][0], size);
+				writeSavestateOfFrame(os, frame);
 			}
 			// write -1 as eof for greenzone
 			write32le(-1, os);
@@ -294,12 +602,10 @@ void GREENZONE::save(EMUFILE *os, int save_type)
 						playback->setProgressbar(frame, greenzoneSize);
 						last_tick = frame / PROGRESSBAR_UPDATE_RATE;
 					}
-					if (!savestates[frame].size()) continue;
+					if (savestates[frame].empty()) continue;
 					write32le(frame, os);
 					// write savestate
-					size = savestates[frame].size();
-					write32le(size, os);
-					os->fwrite(&savestates[frame][0], size);
+					writeSavestateOfFrame(os, frame);
 				}
 			}
 			// write -1 as eof for greenzone
@@ -320,12 +626,10 @@ void GREENZONE::save(EMUFILE *os, int save_type)
 						playback->setProgressbar(frame, greenzoneSize);
 						last_tick = frame / PROGRESSBAR_UPDATE_RATE;
 					}
-					if (!savestates[frame].size()) continue;
+					if (savestates[frame].empty()) continue;
 					write32le(frame, os);
 					// write savestate
-					size = savestates[frame].size();
-					write32le(size, os);
-					os->fwrite(&savestates[frame][0], size);
+					writeSavestateOfFrame(os, frame);
 				}
 			}
 			// write -1 as eof for greenzone
@@ -344,9 +648,7 @@ void GREENZONE::save(EMUFILE *os, int save_type)
 			{
 				// write ONE savestate for currFrameCounter
 				collectCurrentState();
-				int size = savestates[currFrameCounter].size();
-				write32le(size, os);
-				os->fwrite(&savestates[currFrameCounter][0], size);
+				writeSavestateOfFrame(os, currFrameCounter);
 			}
 			break;
 		}
@@ -356,11 +658,20 @@ void GREENZONE::save(EMUFILE *os, int save_type)
 		setTasProjectProgressBar( greenzoneSize, greenzoneSize );
 	}
 }
+// writes size and data of the frame's savestate in the usual compressed form
+void GREENZONE::writeSavestateOfFrame(EMUFILE *os, int frame)
+{
+	std::vector<uint8_t> savestate = getSavestateOfFrame(frame);
+	write32le((int)savestate.size(), os);
+	if (savestate.size())
+		os->fwrite(&savestate[0], savestate.size());
+}
 // returns true if couldn't load
 bool GREENZONE::load(EMUFILE *is, unsigned int offset)
 {
 	int frame = 0, prev_frame = -1;
-       	unsigned int size = 0;
+	unsigned int size = 0;
+	std::vector<uint8_t> savestate;
 	int last_tick = -1;
 	char save_id[GREENZONE_ID_LEN];
 
@@ -393,9 +704,10 @@ bool GREENZONE::load(EMUFILE *is, unsigned int offset)
 				// there must be one savestate in the file
 				if (read32le(&size, is) && size >= 0)
 				{
-					savestates[frame].resize(size);
-					if (is->fread(&savestates[frame][0], size) == size)
+					savestate.resize(size);
+					if (is->fread(size ? &savestate[0] : NULL, size) == size)
 					{
+						writeSavestateForFrame(frame, savestate);
 						if (loadSavestateOfFrame(currFrameCounter))
 						{
 							FCEU_printf("No Greenzone in the file\n");
@@ -461,8 +773,9 @@ bool GREENZONE::load(EMUFILE *is, unsigned int offset)
 					// load this savestate
 					if ((int)savestates.size() <= frame)
 						savestates.resize(frame + 1);
-					savestates[frame].resize(size);
-					if (is->fread(&savestates[frame][0], size) < size) break;
+					savestate.resize(size);
+					if (is->fread(size ? &savestate[0] : NULL, size) < size) break;
+					writeSavestateForFrame(frame, savestate);
 					prev_frame = frame;			// successfully read one Greenzone frame info
 				}
 			}
@@ -655,7 +968,7 @@ void GREENZONE::invalidateAndUpdatePlayback(int after)
 int GREENZONE::findFirstGreenzonedFrame(int starting_index)
 {
 	for (int i = starting_index; i < greenzoneSize; ++i)
-		if (savestates[i].size()) return i;
+		if (!savestates[i].empty()) return i;
 	return -1;	// error
 }
 
@@ -665,24 +978,41 @@ int GREENZONE::getSize()
 	return greenzoneSize;
 }
 
-// this should only be used by Bookmark Set procedure
-std::vector<uint8>& GREENZONE::getSavestateOfFrame(int frame)
+// this should only be used by Bookmark Set procedure and when saving the project
+std::vector<uint8_t> GREENZONE::getSavestateOfFrame(int frame)
 {
-	return savestates[frame];
+	installJobResults();
+	std::vector<uint8_t> savestate;
+	if (frame < 0 || frame >= (int)savestates.size() || savestates[frame].empty())
+		return savestate;
+	GREENZONE_FRAME& entry = savestates[frame];
+	if (entry.isKeyframe && !entry.keyframe->savestate.empty())
+		return entry.keyframe->savestate;
+	std::vector<uint8_t> raw;
+	if (rebuildRawSavestate(frame, raw))
+		compressSavestate(raw, savestate);
+	return savestate;
 }
-// this function should only be used by Bookmark Deploy procedure
+// this function should only be used by Bookmark Deploy procedure and when loading the project
 void GREENZONE::writeSavestateForFrame(int frame, std::vector<uint8>& savestate)
 {
 	if ((int)savestates.size() <= frame)
 		savestates.resize(frame + 1);
-	savestates[frame] = savestate;
+	// a savestate from outside becomes a keyframe of its own, new deltas are never made against it
+	GREENZONE_FRAME& entry = savestates[frame];
+	entry.clear();
+	if (savestate.empty())
+		return;
+	entry.keyframe = std::make_shared<GREENZONE_KEYFRAME>();
+	entry.keyframe->savestate = savestate;
+	entry.isKeyframe = true;
 	if (greenzoneSize <= frame)
 		greenzoneSize = frame + 1;
 }
 
 bool GREENZONE::isSavestateEmpty(unsigned int frame)
 {
-	if ((int)frame < greenzoneSize && frame < savestates.size() && savestates[frame].size())
+	if ((int)frame < greenzoneSize && frame < savestates.size() && !savestates[frame].empty())
 		return false;
 	else
 		return true;
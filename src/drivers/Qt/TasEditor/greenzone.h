@@ -2,8 +2,13 @@
 #pragma once
 #include <stdint.h>
 #include <vector>
+#include <list>
+#include <memory>
 
 #include "Qt/TasEditor/laglog.h"
+#include "utils/mutex.h"
+
+class QThreadPool;
 
 #define GREENZONE_ID_LEN 10
 
@@ -17,10 +22,54 @@
 
 #define PROGRESSBAR_UPDATE_RATE 1000	// progressbar is updated after every 1000 savestates loaded from FM3 file
 
+// every 16th frame survives Greenzone cleaning the longest, so a keyframe is started at most that often
+#define GREENZONE_KEYFRAME_MASK EVERY16TH
+#define GREENZONE_COMPRESSION_THREADS 2
+#define GREENZONE_RAW_BUFFER_POOL_SIZE 32
+
+// a complete savestate that other frames are stored as deltas against
+struct GREENZONE_KEYFRAME
+{
+	std::vector<uint8_t> savestate;					// compressed savestate, empty until the worker has finished it
+	std::shared_ptr<std::vector<uint8_t>> raw;		// uncompressed savestate, kept while compressing or while new deltas are made against it
+	unsigned int rawSize = 0;
+};
+
+// what the Greenzone keeps for one frame
+struct GREENZONE_FRAME
+{
+	std::shared_ptr<GREENZONE_KEYFRAME> keyframe;	// shared by the keyframe itself and every delta made against it
+	std::vector<uint8_t> delta;						// XOR/RLE delta against the keyframe (unused by the keyframe itself)
+	std::shared_ptr<std::vector<uint8_t>> raw;		// uncompressed savestate while the worker is still making the delta
+	unsigned int job = 0;							// id of the pending delta job, 0 = none
+	bool isKeyframe = false;
+
+	bool empty() const { return !keyframe; }
+	void clear()
+	{
+		keyframe.reset();
+		raw.reset();
+		delta.clear();
+		delta.shrink_to_fit();
+		job = 0;
+		isKeyframe = false;
+	}
+};
+
+// result of a compression job, handed back to the emulation thread
+struct GREENZONE_JOB_RESULT
+{
+	unsigned int job;
+	int frame;
+	std::shared_ptr<GREENZONE_KEYFRAME> keyframe;	// set when the job compressed a keyframe
+	std::vector<uint8_t> data;
+};
+
 class GREENZONE
 {
 public:
 	GREENZONE();
+	~GREENZONE();
 	void init();
 	void reset();
 	void free();
@@ -41,10 +90,13 @@ public:
 	int findFirstGreenzonedFrame(int startingFrame = 0);
 
 	int getSize();
-	std::vector<uint8_t>& getSavestateOfFrame(int frame);
+	std::vector<uint8_t> getSavestateOfFrame(int frame);
 	void writeSavestateForFrame(int frame, std::vector<uint8>& savestate);
 	bool isSavestateEmpty(unsigned int frame);
 
+	// called from the compression workers
+	void postJobResult(GREENZONE_JOB_RESULT* result);
+
 	// saved data
 	LAGLOG lagLog;
 
@@ -56,11 +108,31 @@ private:
 	void adjustUp();
 	void adjustDown();
 
+	void installJobResults();
+	void waitForPendingJobs();
+	bool rebuildRawSavestate(unsigned int frame, std::vector<uint8_t>& out);
+	void writeSavestateOfFrame(EMUFILE *os, int frame);
+
+	std::shared_ptr<std::vector<uint8_t>> allocRawBuffer();
+	void releaseRawBuffer(std::shared_ptr<std::vector<uint8_t>>& buf);
+
 	// saved data
 	int greenzoneSize;
-	std::vector<std::vector<uint8_t>> savestates;
+	std::vector<GREENZONE_FRAME> savestates;
 
 	// not saved data
 	uint64_t nextCleaningTime;
-	
+
+	// keyframe new deltas are made against
+	int currentKeyframeFrame;
+	std::shared_ptr<GREENZONE_KEYFRAME> currentKeyframe;
+	// last keyframe decompressed for rebuilding a delta frame
+	std::shared_ptr<GREENZONE_KEYFRAME> decodedKeyframe;
+	std::vector<uint8_t> decodedKeyframeRaw;
+
+	QThreadPool *workerPool;
+	unsigned int lastJobId;
+	FCEU::mutex jobResultsMutex;
+	std::list<GREENZONE_JOB_RESULT*> jobResults;
+	std::vector<std::shared_ptr<std::vector<uint8_t>>> rawBufferPool;
 };
@@ -438,6 +438,9 @@ void HISTORY::addItemToHistoryLog(SNAPSHOT &snap, int currentBranch)
 	}
 	// write data
 	int real_pos = (historyStartPos + historyCursorPos) % historySize;
+	if (historyCursorPos > 0)
+		// keep one copy of Input that didn't change since previous snapshot
+		snap.inputlog.shareChunks(snapshots[(historyStartPos + historyCursorPos - 1) % historySize].inputlog);
 	snapshots[real_pos] = snap;
 	bookmarkBackups[real_pos].free();
 	currentBranchNumberBackups[real_pos] = currentBranch;
@@ -461,6 +464,9 @@ void HISTORY::addItemToHistoryLog(SNAPSHOT &snap, int cur_branch, BOOKMARK &book
 	}
 	// write data
 	int real_pos = (historyStartPos + historyCursorPos) % historySize;
+	if (historyCursorPos > 0)
+		// keep one copy of Input that didn't change since previous snapshot
+		snap.inputlog.shareChunks(snapshots[(historyStartPos + historyCursorPos - 1) % historySize].inputlog);
 	snapshots[real_pos] = snap;
 	bookmarkBackups[real_pos] = bookm;
 	currentBranchNumberBackups[real_pos] = cur_branch;
@@ -561,6 +567,7 @@ int HISTORY::registerChanges(int mod_type, int start, int end, int size, const c
 				snap.inputlog.fillHotChanges(snapshots[real_pos].inputlog, first_changes, end);
 			}
 			// replace current snapshot with this cloned snapshot and truncate history here
+			snap.inputlog.shareChunks(snapshots[real_pos].inputlog);
 			snapshots[real_pos] = snap;
 			historyTotalItems = historyCursorPos+1;
 			updateList();
@@ -659,6 +666,7 @@ int HISTORY::registerAdjustLag(int start, int size)
 				snap.inputlog.inheritHotChanges_InsertNum(&snapshots[real_pos].inputlog, start, 1, false);
 		}
 		// replace current snapshot with this cloned snapshot and don't truncate history
+		snap.inputlog.shareChunks(current_snap.inputlog);
 		snapshots[real_pos] = snap;
 		updateList();
 		redrawList();
@@ -1088,6 +1096,8 @@ bool HISTORY::load(EMUFILE *is, unsigned int offset)
 	for (i = 0; i < historyTotalItems; ++i)
 	{
 		if (snapshots[i].load(is)) goto error;
+		if (i > 0)
+			snapshots[i].inputlog.shareChunks(snapshots[i - 1].inputlog);
 		if (bookmarkBackups[i].load(is)) goto error;
 		if (is->fread(&currentBranchNumberBackups[i], 1) != 1) goto error;
 		setTasProjectProgressBar( i, historyTotalItems );
@@ -2,6 +2,7 @@
 #pragma once
 #include <stdint.h>
 #include <vector>
+#include <memory>
 
 #include "fceu.h"
 #include "movie.h"
@@ -29,6 +30,58 @@ enum INPUT_TYPES
 #define BYTE_VALUE_CONTAINING_MAX_HOTCHANGE_LO HOTCHANGE_MAX_VALUE														// "0x0F"
 #define HOTCHANGE_BYTES_PER_JOY (BYTES_PER_JOYSTICK * HOTCHANGE_BITS_PER_VALUE)	// 4 bytes per 8 buttons
 
+#define INPUTLOG_CHUNK_SHIFT 14
+#define INPUTLOG_CHUNK_SIZE (1 << INPUTLOG_CHUNK_SHIFT)	// 16 KB per chunk
+#define INPUTLOG_CHUNK_MASK (INPUTLOG_CHUNK_SIZE - 1)
+
+// a piece of InputLog data of up to INPUTLOG_CHUNK_SIZE bytes, shared by all Snapshots that contain the same bytes
+struct INPUTLOG_CHUNK
+{
+	INPUTLOG_CHUNK();
+	int length;							// bytes in use
+	uint8_t data[INPUTLOG_CHUNK_SIZE];
+	std::vector<uint8_t> deflated;		// raw deflate blocks of data[], ending on a byte boundary, empty until compressed
+};
+
+// byte array stored as reference-counted chunks of variable length: copying it is cheap, writing only copies the chunk being written,
+// and inserting or erasing only rebuilds the chunk at that position, the following chunks move along and stay shared
+class INPUTLOG_BUFFER
+{
+public:
+	INPUTLOG_BUFFER();
+
+	int size() const { return length; }
+	uint8_t get(int pos) const { int ofs; int index = locate(pos, ofs); return chunks[index]->data[ofs]; }
+	void set(int pos, uint8_t value);
+
+	void resize(int newSize, uint8_t value = 0);
+	void fill(int pos, uint8_t value, int count);
+	void copy(int pos, const INPUTLOG_BUFFER& source, int sourcePos, int count);
+	void insert(int pos, int count, uint8_t value);
+	void erase(int pos, int count);
+
+	int findFirstDifference(const INPUTLOG_BUFFER& theirBuffer, int start, int end) const;
+	void shareChunks(const INPUTLOG_BUFFER& theirBuffer);
+
+	void compressData(void);
+	void save(EMUFILE *os);
+	bool load(EMUFILE *is, int expectedSize);
+
+private:
+	int locate(int pos, int& ofs) const;
+	INPUTLOG_CHUNK* getWritable(int index);
+	void updateIndex(int first);
+	void replaceChunks(int first, int last, std::vector<uint8_t>& bytes);
+	int findCommonTail(const INPUTLOG_BUFFER& theirBuffer, int limit) const;
+	void read(int pos, uint8_t* dest, int count) const;
+	void write(int pos, const uint8_t* source, int count);
+
+	int length;
+	std::vector<std::shared_ptr<INPUTLOG_CHUNK>> chunks;
+	std::vector<int> chunkStart;			// position of the first byte of every chunk
+	mutable int lastIndex;				// chunk found by the last locate()
+};
+
 class INPUTLOG
 {
 public:
@@ -71,6 +124,8 @@ public:
 
 	int getHotChangesInfo(int frame, int absoluteButtonNumber);
 
+	void shareChunks(INPUTLOG& theirLog);
+
 	// saved data
 	int size;						// in frames
 	int inputType;						// theoretically TAS Editor can support any other Input types
@@ -78,15 +133,12 @@ public:
 
 private:
 	
-	// also saved data
-	std::vector<uint8_t> compressedJoysticks;
-	std::vector<uint8_t> compressedCommands;
-	std::vector<uint8_t> compressedHotChanges;
+	// also saved data (compressed chunk by chunk, see INPUTLOG_BUFFER)
+	INPUTLOG_BUFFER hotChanges;		// Format: buttons01joy0-for-frame0, buttons23joy0-for-frame0, buttons45joy0-for-frame0, buttons67joy0-for-frame0, buttons01joy1-for-frame0, ...
+	INPUTLOG_BUFFER joysticks;		// Format: joy0-for-frame0, joy1-for-frame0, joy2-for-frame0, joy3-for-frame0, joy0-for-frame1, joy1-for-frame1, ...
+	INPUTLOG_BUFFER commands;		// Format: commands-for-frame0, commands-for-frame1, ...
 
 	// not saved data
-	std::vector<uint8_t> hotChanges;		// Format: buttons01joy0-for-frame0, buttons23joy0-for-frame0, buttons45joy0-for-frame0, buttons67joy0-for-frame0, buttons01joy1-for-frame0, ...
-	std::vector<uint8_t> joysticks;		// Format: joy0-for-frame0, joy1-for-frame0, joy2-for-frame0, joy3-for-frame0, joy0-for-frame1, joy1-for-frame1, ...
-	std::vector<uint8_t> commands;		// Format: commands-for-frame0, commands-for-frame1, ...
 	bool alreadyCompressed;			// to compress only once
 };
 
@@ -22,6 +22,8 @@
 //
 #include <stdio.h>
 #include <math.h>
+#include <atomic>
+#include <functional>
 
 #ifdef WIN32
 #include <windows.h>
@@ -43,6 +45,8 @@
 #include <QShortcut>
 #include <QPainter>
 #include <QGuiApplication>
+#include <QProgressDialog>
+#include <QFileInfo>
 
 #include "../../types.h"
 #include "../../fceu.h"
@@ -111,14 +115,22 @@ static traceRecord_t *recBuf = NULL;
 static int recBufMax = 0;
 static int recBufHead = 0;
 static int recBufNum = 0;
-static traceRecord_t *logBuf = NULL;
 static int logBufMax = 3000000;
-// logBufHead and logBufTail are volatile because they are shared use by both the emulation and disk logger threads.
-// Ensure that the compiler doesn't do any thread caching optimizations on them so that changes to these
-// variables are immediately visible by the other thread.
-static volatile int logBufHead = 0;
-static volatile int logBufTail = 0;
+// Single producer (emulation thread), single consumer (disk thread) ring.
+// The indices are on separate cache lines so the two threads do not
+// false-share.  The producer never waits: when the ring is full the record
+// is dropped and counted in the next record's skippedLines.
+struct traceLogRing_t
+{
+	traceRecord_t *buf = NULL;
+	std::atomic<bool> active{false};
+	alignas(64) std::atomic<int> head{0};
+	alignas(64) std::atomic<int> tail{0};
+	alignas(64) int dropped = 0;
+};
+static traceLogRing_t logRing;
 static bool overrunWarningArmed = true;
+static bool logBinaryFormat = false;
 static TraceLoggerDialog_t *traceLogWindow = NULL;
 static void pushMsgToLogBuffer(const char *msg);
 #ifdef WIN32
@@ -180,6 +192,14 @@ TraceLoggerDialog_t::TraceLoggerDialog_t(QWidget *parent)
 	// File
 	fileMenu = menuBar->addMenu(tr("&File"));
 
+	// File -> Convert Binary Log
+	act = new QAction(tr("Convert &Binary Log to Text..."), this);
+	act->setStatusTip(tr("Render a binary trace log file as text"));
+	connect(act, SIGNAL(triggered()), this, SLOT(convertBinaryLog(void)) );
+
+	fileMenu->addAction(act);
+	fileMenu->addSeparator();
+
 	// File -> Close
 	act = new QAction(tr("&Close"), this);
 	act->setShortcut(QKeySequence::Close);
@@ -251,6 +271,7 @@ TraceLoggerDialog_t::TraceLoggerDialog_t(QWidget *parent)
 	connect(logMaxLinesComboBox, SIGNAL(activated(int)), this, SLOT(logMaxLinesChanged(int)));
 
 	logFileCbox = new QCheckBox(tr("Log to File"));
+	logBinaryCbox = new QCheckBox(tr("Binary Format"));
 	selLogFileButton = new QPushButton(tr("Browse..."));
 	startStopButton = new QPushButton(tr("Start Logging"));
 	autoUpdateCbox = new QCheckBox(tr("Automatically update this window while logging"));
@@ -262,6 +283,12 @@ TraceLoggerDialog_t::TraceLoggerDialog_t(QWidget *parent)
 	logFileCbox->setChecked( opt );
 	connect(logFileCbox, SIGNAL(stateChanged(int)), this, SLOT(logToFileStateChanged(int)));
 
+	g_config->getOption("SDL.TraceLogBinaryFormat", &opt );
+	logBinaryFormat = opt ? true : false;
+	logBinaryCbox->setChecked( logBinaryFormat );
+	logBinaryCbox->setToolTip( tr("Write compact binary records instead of text. Use File -> Convert Binary Log to Text to read them.") );
+	connect(logBinaryCbox, SIGNAL(stateChanged(int)), this, SLOT(logBinaryStateChanged(int)));
+
 	g_config->getOption("SDL.TraceLogPeriodicWindowUpdate", &opt );
 	autoUpdateCbox->setChecked( opt );
 	connect(autoUpdateCbox, SIGNAL(stateChanged(int)), this, SLOT(autoUpdateStateChanged(int)));
@@ -292,6 +319,7 @@ TraceLoggerDialog_t::TraceLoggerDialog_t(QWidget *parent)
 
 	hbox = new QHBoxLayout();
 	hbox->addWidget(logFileCbox);
+	hbox->addWidget(logBinaryCbox);
 	hbox->addWidget(selLogFileButton);
 
 	grid->addLayout(hbox, 1, 0, Qt::AlignLeft);
@@ -396,6 +424,8 @@ TraceLoggerDialog_t::TraceLoggerDialog_t(QWidget *parent)
 
 	diskThread = new TraceLogDiskThread_t(this);
 
+	FCEUI_SetDebugHookUser(DBGHOOK_TRACER, true);
+
 	restoreGeometry(settings.value("traceLogger/geometry").toByteArray());
 }
 //----------------------------------------------------
@@ -411,6 +441,9 @@ TraceLoggerDialog_t::~TraceLoggerDialog_t(void)
 
 	traceLogWindow = NULL;
 
+	// Logging may carry on without the window, keep the instrumented CPU loop only if so.
+	FCEUI_SetDebugHookUser(DBGHOOK_TRACER, logging != 0);
+
 	//printf("Trace Logger Window Deleted\n");
 }
 //----------------------------------------------------
@@ -546,8 +579,9 @@ void TraceLoggerDialog_t::showBufferWarning(void)
 	const char *msg = "\
 Error: Trace Logger Circular Buffer Overrun has been detected!\n\n\
 This means that some instructions have not been written to the log\
- file and resulting log of instructions is incomplete.\n\n\
-Recommend increasing buffer size (max lines) to at least 1,000,000 lines.\n\n\
+ file and resulting log of instructions is incomplete. Dropped\
+ instructions are reported as skipped lines in the log.\n\n\
+Logging in binary format reduces the load on the disk writer.\n\n\
 This message won't show again until logging is stopped and started again.";
 
 	if ( consoleWindow )
@@ -567,7 +601,7 @@ void TraceLoggerDialog_t::openLogFile(void)
 
 	dialog.setFileMode(QFileDialog::AnyFile);
 
-	dialog.setNameFilter(tr("LOG files (*.log *.LOG) ;; All files (*)"));
+	dialog.setNameFilter(tr("LOG files (*.log *.LOG) ;; Binary trace files (*.ftrace) ;; All files (*)"));
 
 	dialog.setViewMode(QFileDialog::List);
 	dialog.setFilter(QDir::AllEntries | QDir::AllDirs | QDir::Hidden);
@@ -712,6 +746,80 @@ void TraceLoggerDialog_t::logToFileStateChanged(int state)
 	g_config->setOption("SDL.TraceLogSaveToFile", state != Qt::Unchecked );
 }
 //----------------------------------------------------
+void TraceLoggerDialog_t::logBinaryStateChanged(int state)
+{
+	// Takes effect the next time logging to file is started
+	logBinaryFormat = state != Qt::Unchecked;
+
+	g_config->setOption("SDL.TraceLogBinaryFormat", logBinaryFormat );
+}
+//----------------------------------------------------
+void TraceLoggerDialog_t::convertBinaryLog(void)
+{
+	int useNativeFileDialogVal;
+	QString inFile, outFile, dir;
+	QFileDialog::Options options;
+
+	g_config->getOption("SDL.UseNativeFileDialog", &useNativeFileDialogVal);
+
+	if (!useNativeFileDialogVal)
+	{
+		options |= QFileDialog::DontUseNativeDialog;
+	}
+
+	if ( logFilePath.size() != 0 )
+	{
+		std::string d;
+		getDirFromFile(logFilePath.c_str(), d);
+		dir = QString::fromStdString(d);
+	}
+
+	inFile = QFileDialog::getOpenFileName( this, tr("Open Binary Trace Log"), dir,
+			tr("Binary trace files (*.ftrace) ;; All files (*)"), nullptr, options );
+
+	if (inFile.isEmpty())
+	{
+		return;
+	}
+
+	outFile = QFileDialog::getSaveFileName( this, tr("Save Text Trace Log"),
+			QFileInfo(inFile).path() + "/" + QFileInfo(inFile).completeBaseName() + ".log",
+			tr("LOG files (*.log *.LOG) ;; All files (*)"), nullptr, options );
+
+	if (outFile.isEmpty())
+	{
+		return;
+	}
+
+	QProgressDialog progressDialog( tr("Converting Trace Log"), tr("Cancel"), 0, 1000, this );
+	qint64 inSize = QFileInfo(inFile).size();
+
+	progressDialog.setWindowModality(Qt::WindowModal);
+
+	int ret = convertBinaryTraceLog( inFile.toLocal8Bit().constData(), outFile.toLocal8Bit().constData(),
+		[&](long pos)
+		{
+			if (inSize > 0)
+			{
+				progressDialog.setValue( (int)((pos * 1000) / inSize) );
+			}
+			QCoreApplication::processEvents();
+
+			return !progressDialog.wasCanceled();
+		});
+
+	progressDialog.reset();
+
+	if (ret == -2)
+	{
+		QMessageBox::critical( this, tr("Trace Logger"), tr("Not a binary trace log file:\n") + inFile );
+	}
+	else if (ret < 0)
+	{
+		QMessageBox::critical( this, tr("Trace Logger"), tr("Failed to convert trace log file.") );
+	}
+}
+//----------------------------------------------------
 void TraceLoggerDialog_t::autoUpdateStateChanged(int state)
 {
 	g_config->setOption("SDL.TraceLogPeriodicWindowUpdate", state != Qt::Unchecked );
@@ -943,6 +1051,11 @@ static int convToXchar(int i)
 }
 //----------------------------------------------------
 int traceRecord_t::convToText(char *txt, int *len)
+{
+	return convToText(txt, len, logging_options);
+}
+//----------------------------------------------------
+int traceRecord_t::convToText(char *txt, int *len, int options)
 {
 	int i = 0, j = 0;
 	char stmp[128];
@@ -963,6 +1076,10 @@ int traceRecord_t::convToText(char *txt, int *len)
 		}
 		txt[i] = 0;
 
+		if (len)
+		{
+			*len = i;
+		}
 		return -1;
 	}
 
@@ -980,7 +1097,7 @@ int traceRecord_t::convToText(char *txt, int *len)
 	}
 
 	// Start filling the str_temp line: Frame count, Cycles count, Instructions count, AXYS state, Processor status, Tabs, Address, Data, Disassembly
-	if (logging_options & LOG_FRAMES_COUNT)
+	if (options & LOG_FRAMES_COUNT)
 	{
 		sprintf(stmp, "f%-6llu ", (long long unsigned int)frameCount);
 
@@ -993,7 +1110,7 @@ int traceRecord_t::convToText(char *txt, int *len)
 		}
 	}
 
-	if (logging_options & LOG_CYCLES_COUNT)
+	if (options & LOG_CYCLES_COUNT)
 	{
 		sprintf(stmp, "c%-11llu ", (long long unsigned int)cycleCount);
 
@@ -1006,7 +1123,7 @@ int traceRecord_t::convToText(char *txt, int *len)
 		}
 	}
 
-	if (logging_options & LOG_INSTRUCTIONS_COUNT)
+	if (options & LOG_INSTRUCTIONS_COUNT)
 	{
 		sprintf(stmp, "i%-11llu ", (long long unsigned int)instrCount);
 
@@ -1019,12 +1136,12 @@ int traceRecord_t::convToText(char *txt, int *len)
 		}
 	}
 
-	if (logging_options & LOG_REGISTERS)
+	if (options & LOG_REGISTERS)
 	{
 		sprintf(str_axystate, "A:%02X X:%02X Y:%02X S:%02X ", (cpu.A), (cpu.X), (cpu.Y), (cpu.S));
 	}
 
-	if (logging_options & LOG_PROCESSOR_STATUS)
+	if (options & LOG_PROCESSOR_STATUS)
 	{
 		int tmp = cpu.P ^ 0xFF;
 		sprintf(str_procstatus, "P:%c%c%c%c%c%c%c%c ",
@@ -1038,9 +1155,9 @@ int traceRecord_t::convToText(char *txt, int *len)
 				'C' | (tmp & 0x01) << 5);
 	}
 
-	if (logging_options & LOG_TO_THE_LEFT)
+	if (options & LOG_TO_THE_LEFT)
 	{
-		if (logging_options & LOG_REGISTERS)
+		if (options & LOG_REGISTERS)
 		{
 			j = 0;
 			while (str_axystate[j] != 0)
@@ -1050,7 +1167,7 @@ int traceRecord_t::convToText(char *txt, int *len)
 				j++;
 			}
 		}
-		if (logging_options & LOG_PROCESSOR_STATUS)
+		if (options & LOG_PROCESSOR_STATUS)
 		{
 			j = 0;
 			while (str_procstatus[j] != 0)
@@ -1062,7 +1179,7 @@ int traceRecord_t::convToText(char *txt, int *len)
 		}
 	}
 
-	if (logging_options & LOG_CODE_TABBING)
+	if (options & LOG_CODE_TABBING)
 	{
 		// add spaces at the beginning of the line according to stack pointer
 		int spaces = (0xFF - cpu.S) & LOG_TABS_MASK;
@@ -1074,13 +1191,13 @@ int traceRecord_t::convToText(char *txt, int *len)
 			spaces--;
 		}
 	}
-	else if (logging_options & LOG_TO_THE_LEFT)
+	else if (options & LOG_TO_THE_LEFT)
 	{
 		txt[i] = ' ';
 		i++;
 	}
 
-	if (logging_options & LOG_BANK_NUMBER)
+	if (options & LOG_BANK_NUMBER)
 	{
 		if (cpu.PC >= 0x8000)
 		{
@@ -1142,9 +1259,9 @@ int traceRecord_t::convToText(char *txt, int *len)
 		}
 	}
 
-	if (!(logging_options & LOG_TO_THE_LEFT))
+	if (!(options & LOG_TO_THE_LEFT))
 	{
-		if (logging_options & LOG_REGISTERS)
+		if (options & LOG_REGISTERS)
 		{
 			j = 0;
 			while (str_axystate[j] != 0)
@@ -1154,7 +1271,7 @@ int traceRecord_t::convToText(char *txt, int *len)
 				j++;
 			}
 		}
-		if (logging_options & LOG_PROCESSOR_STATUS)
+		if (options & LOG_PROCESSOR_STATUS)
 		{
 			j = 0;
 			while (str_procstatus[j] != 0)
@@ -1176,6 +1293,291 @@ int traceRecord_t::convToText(char *txt, int *len)
 	return 0;
 }
 //----------------------------------------------------
+//---  Binary Trace Log File
+//----------------------------------------------------
+// Layout: 8 byte magic, u32 version and u32 logging options (little endian),
+// then one entry per record.  An entry starts with the opcode size, 0 marks
+// a message (u8 length + text).  Instruction entries hold PC, A, X, Y, S, P,
+// the opcode bytes, the pre-write value and the disassembly text, followed by
+// LEB128 varints: frame, cycle and instruction counts as zigzag deltas from
+// the previous entry, the flags, then callAddr, romAddr, bank, skippedLines
+// and writeAddr zigzag encoded (mostly -1, so one byte each).
+static const char traceLogMagic[8] = { 'F', 'C', 'E', 'U', 'T', 'R', 'C', 0 };
+static const uint32_t traceLogVersion = 1;
+
+struct traceLogCodec_t
+{
+	uint64_t frameCount = 0;
+	uint64_t cycleCount = 0;
+	uint64_t instrCount = 0;
+};
+
+static int putVarint(uint8_t *out, uint64_t v)
+{
+	int n = 0;
+
+	while (v >= 0x80)
+	{
+		out[n++] = (uint8_t)(v | 0x80);
+		v >>= 7;
+	}
+	out[n++] = (uint8_t)v;
+
+	return n;
+}
+
+static inline uint64_t zigzag(int64_t v)
+{
+	return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static inline int64_t unzigzag(uint64_t v)
+{
+	return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+static int putU32(uint8_t *out, uint32_t v)
+{
+	out[0] = v & 0xff;
+	out[1] = (v >> 8) & 0xff;
+	out[2] = (v >> 16) & 0xff;
+	out[3] = (v >> 24) & 0xff;
+	return 4;
+}
+
+static int writeTraceLogHeader(uint8_t *out, int options)
+{
+	int n = 0;
+
+	memcpy(out, traceLogMagic, sizeof(traceLogMagic));
+	n += sizeof(traceLogMagic);
+	n += putU32(&out[n], traceLogVersion);
+	n += putU32(&out[n], options);
+
+	return n;
+}
+
+// Writes at most 192 bytes.
+static int encodeTraceRecord(traceLogCodec_t &prev, const traceRecord_t &rec, uint8_t *out)
+{
+	int i, n = 0, len;
+
+	if (rec.opSize == 0)
+	{
+		len = strnlen(rec.asmTxt, sizeof(rec.asmTxt) - 1);
+
+		out[n++] = 0;
+		out[n++] = len;
+		memcpy(&out[n], rec.asmTxt, len);
+		return n + len;
+	}
+	out[n++] = rec.opSize;
+	out[n++] = rec.cpu.PC & 0xff;
+	out[n++] = rec.cpu.PC >> 8;
+	out[n++] = rec.cpu.A;
+	out[n++] = rec.cpu.X;
+	out[n++] = rec.cpu.Y;
+	out[n++] = rec.cpu.S;
+	out[n++] = rec.cpu.P;
+
+	for (i = 0; i < rec.opSize; i++)
+	{
+		out[n++] = rec.opCode[i];
+	}
+	out[n++] = rec.preWriteVal;
+
+	len = strnlen(rec.asmTxt, sizeof(rec.asmTxt) - 1);
+	out[n++] = len;
+	memcpy(&out[n], rec.asmTxt, len);
+	n += len;
+
+	n += putVarint(&out[n], zigzag((int64_t)(rec.frameCount - prev.frameCount)));
+	n += putVarint(&out[n], zigzag((int64_t)(rec.cycleCount - prev.cycleCount)));
+	n += putVarint(&out[n], zigzag((int64_t)(rec.instrCount - prev.instrCount)));
+	n += putVarint(&out[n], rec.flags);
+	n += putVarint(&out[n], zigzag(rec.callAddr));
+	n += putVarint(&out[n], zigzag(rec.romAddr));
+	n += putVarint(&out[n], zigzag(rec.bank));
+	n += putVarint(&out[n], zigzag(rec.skippedLines));
+	n += putVarint(&out[n], zigzag(rec.writeAddr));
+
+	prev.frameCount = rec.frameCount;
+	prev.cycleCount = rec.cycleCount;
+	prev.instrCount = rec.instrCount;
+
+	return n;
+}
+
+static bool getVarint(FILE *fp, uint64_t &v)
+{
+	int c, shift = 0;
+
+	v = 0;
+	do
+	{
+		c = fgetc(fp);
+
+		if ((c == EOF) || (shift > 63))
+		{
+			return false;
+		}
+		v |= (uint64_t)(c & 0x7f) << shift;
+		shift += 7;
+	} while (c & 0x80);
+
+	return true;
+}
+
+static bool getBytes(FILE *fp, void *dst, size_t size)
+{
+	return fread(dst, 1, size, fp) == size;
+}
+
+static bool decodeTraceRecord(traceLogCodec_t &prev, FILE *fp, traceRecord_t &rec)
+{
+	uint8_t hdr[10];
+	uint64_t v[9];
+	int c, len;
+
+	c = fgetc(fp);
+
+	if (c == EOF)
+	{
+		return false;
+	}
+	rec = traceRecord_t();
+	rec.opSize = c;
+
+	if (rec.opSize > 3)
+	{
+		return false;
+	}
+	if (rec.opSize > 0)
+	{
+		if (!getBytes(fp, hdr, 7 + rec.opSize))
+		{
+			return false;
+		}
+		rec.cpu.PC = hdr[0] | (hdr[1] << 8);
+		rec.cpu.A = hdr[2];
+		rec.cpu.X = hdr[3];
+		rec.cpu.Y = hdr[4];
+		rec.cpu.S = hdr[5];
+		rec.cpu.P = hdr[6];
+		memcpy(rec.opCode, &hdr[7], rec.opSize);
+
+		c = fgetc(fp);
+
+		if (c == EOF)
+		{
+			return false;
+		}
+		rec.preWriteVal = c;
+	}
+
+	len = fgetc(fp);
+
+	if ((len == EOF) || (len >= (int)sizeof(rec.asmTxt)) || !getBytes(fp, rec.asmTxt, len))
+	{
+		return false;
+	}
+	rec.asmTxt[len] = 0;
+	rec.asmTxtSize = len;
+
+	if (rec.opSize == 0)
+	{
+		return true;
+	}
+
+	for (int i = 0; i < 9; i++)
+	{
+		if (!getVarint(fp, v[i]))
+		{
+			return false;
+		}
+	}
+	rec.frameCount = prev.frameCount + unzigzag(v[0]);
+	rec.cycleCount = prev.cycleCount + unzigzag(v[1]);
+	rec.instrCount = prev.instrCount + unzigzag(v[2]);
+	rec.flags = v[3];
+	rec.callAddr = unzigzag(v[4]);
+	rec.romAddr = unzigzag(v[5]);
+	rec.bank = unzigzag(v[6]);
+	rec.skippedLines = unzigzag(v[7]);
+	rec.writeAddr = unzigzag(v[8]);
+
+	prev.frameCount = rec.frameCount;
+	prev.cycleCount = rec.cycleCount;
+	prev.instrCount = rec.instrCount;
+
+	return true;
+}
+
+// Renders a binary trace log to text one record at a time, so arbitrarily
+// large traces never have to be held in memory.
+static int convertBinaryTraceLog(const char *inPath, const char *outPath,
+		const std::function<bool(long)> &progress)
+{
+	FILE *in, *out;
+	char magic[8];
+	uint8_t word[4];
+	uint32_t version, options;
+	traceLogCodec_t codec;
+	traceRecord_t rec;
+	char line[256];
+	int lineLen;
+	long count = 0;
+
+	in = fopen(inPath, "rb");
+
+	if (in == NULL)
+	{
+		return -1;
+	}
+	if (!getBytes(in, magic, sizeof(magic)) || memcmp(magic, traceLogMagic, sizeof(magic)) ||
+			!getBytes(in, word, 4))
+	{
+		fclose(in);
+		return -2;
+	}
+	version = word[0] | (word[1] << 8) | (word[2] << 16) | ((uint32_t)word[3] << 24);
+
+	if ((version != traceLogVersion) || !getBytes(in, word, 4))
+	{
+		fclose(in);
+		return -2;
+	}
+	options = word[0] | (word[1] << 8) | (word[2] << 16) | ((uint32_t)word[3] << 24);
+
+	out = fopen(outPath, "w");
+
+	if (out == NULL)
+	{
+		fclose(in);
+		return -1;
+	}
+
+	while (decodeTraceRecord(codec, in, rec))
+	{
+		rec.convToText(line, &lineLen, options);
+
+		line[lineLen++] = '\n';
+		fwrite(line, 1, lineLen, out);
+
+		if ((++count & 0xffff) == 0)
+		{
+			if (progress && !progress(ftell(in)))
+			{
+				break;
+			}
+		}
+	}
+	fclose(out);
+	fclose(in);
+
+	return 0;
+}
+//----------------------------------------------------
 int initTraceLogBuffer(int maxRecs)
 {
 	if (maxRecs != recBufMax)
@@ -1232,30 +1634,25 @@ static void pushToLogBuffer(traceRecord_t &rec)
 		recBufNum++;
 	}
 
-	if ( logBuf )
+	if ( logRing.active.load(std::memory_order_acquire) )
 	{
-		int nextHead, delayCount = 0;
-		logBuf[logBufHead] = rec;
-		nextHead = (logBufHead + 1) % logBufMax;
-
-		while (nextHead == logBufTail)
-		{
-			SDL_Delay(1);
+		int head, nextHead;
 
-			delayCount++;
+		head = logRing.head.load(std::memory_order_relaxed);
+		nextHead = head + 1;
 
-			if ( delayCount > 10000 )
-			{
-				break;
-			}
+		if (nextHead >= logBufMax)
+		{
+			nextHead = 0;
 		}
-		logBufHead = nextHead;
 
-		if ( overrunWarningArmed )
-		{	// Don't spam with buffer overrun warning messages,
-			// we will print once if this happens.
-			if (logBufHead == logBufTail)
-			{
+		if (nextHead == logRing.tail.load(std::memory_order_acquire))
+		{
+			logRing.dropped++;
+
+			if ( overrunWarningArmed )
+			{	// Don't spam with buffer overrun warning messages,
+				// we will print once if this happens.
 				if ( traceLogWindow )
 				{
 					traceLogWindow->showBufferWarning();
@@ -1263,7 +1660,16 @@ static void pushToLogBuffer(traceRecord_t &rec)
 				printf("Trace Log Overrun!!!\n");
 				overrunWarningArmed = false;
 			}
+			return;
 		}
+		logRing.buf[head] = rec;
+
+		if (logRing.dropped)
+		{
+			logRing.buf[head].skippedLines += logRing.dropped;
+			logRing.dropped = 0;
+		}
+		logRing.head.store(nextHead, std::memory_order_release);
 	}
 }
 //----------------------------------------------------
@@ -1286,6 +1692,7 @@ int FCEUD_TraceLoggerStart(void)
 		{
 			initTraceLogBuffer(1000000);
 		}
+		FCEUI_SetDebugHookUser(DBGHOOK_TRACER, true);
 		logging = 1;
 	}
 	return logging;
@@ -1306,6 +1713,7 @@ int FCEUD_TraceLoggerStop(void)
 		logging = 0;
 		msleep(1);
 		pushMsgToLogBuffer("Logging Finished");
+		FCEUI_SetDebugHookUser(DBGHOOK_TRACER, false);
 	}
 	return logging;
 }
@@ -2526,21 +2934,38 @@ TraceLogDiskThread_t::~TraceLogDiskThread_t(void)
 	}
 #endif
 
-	if ( logBuf )
+	logRing.active.store(false, std::memory_order_release);
+
+	if ( logRing.buf )
+	{
+		free(logRing.buf);
+		logRing.buf = NULL;
+	}
+}
+//----------------------------------------------------
+static void writeLogFile(const char *buf, int size)
+{
+	#ifdef WIN32
+	DWORD bytesWritten;
+	WriteFile( logFile, buf, size, &bytesWritten, NULL );
+	#else
+	if ( write( logFile, buf, size ) < 0 )
 	{
-		free(logBuf);
-		logBuf = NULL;
+		// HANDLE ERROR TODO
 	}
+	#endif
 }
 //----------------------------------------------------
 void TraceLogDiskThread_t::run(void)
 {
 	char line[256];
 	char buf[8192];
-	int i,idx=0;
+	int i,idx=0,tail;
 	int blockSize = 4 * 1024;
 	bool dataNeedsFlush = true;
 	bool isPaused = false;
+	bool binary = logBinaryFormat;
+	traceLogCodec_t codec;
 
 	//printf("Trace Log Disk Start\n");
 
@@ -2569,51 +2994,77 @@ void TraceLogDiskThread_t::run(void)
 		return;
 	}
 #endif
-	if ( logBuf == NULL )
+	if ( logRing.buf == NULL )
 	{
-		size_t size;
+		logRing.buf = (traceRecord_t *)malloc( logBufMax * sizeof(traceRecord_t) );
 
-		size = logBufMax * sizeof(traceRecord_t);
+		if ( logRing.buf == NULL )
+		{
+			consoleWindow->QueueErrorMsgWindow("Error: Failed to allocate trace log buffer");
+			return;
+		}
+	}
+	logRing.head.store(0, std::memory_order_relaxed);
+	logRing.tail.store(0, std::memory_order_relaxed);
+	logRing.dropped = 0;
+	logRing.active.store(true, std::memory_order_release);
 
-		logBufHead = logBufTail = 0;
+	idx = 0;
+	tail = 0;
 
-		logBuf = (traceRecord_t *)malloc(size);
+	if (binary)
+	{
+		idx = writeTraceLogHeader( (uint8_t*)buf, logging_options );
 	}
-	idx = 0;
 
-	while ( !isInterruptionRequested() )
+	while ( true )
 	{
-		isPaused = FCEUI_EmulationPaused() ? true : false;
+		bool exitRequested = isInterruptionRequested();
 
-		while (logBufHead != logBufTail)
+		if (exitRequested)
 		{
-			logBuf[logBufTail].convToText(line);
+			logRing.active.store(false, std::memory_order_release);
+		}
+		isPaused = FCEUI_EmulationPaused() ? true : false;
 
-			i=0;
-			while ( line[i] != 0 )
+		while (tail != logRing.head.load(std::memory_order_acquire))
+		{
+			if (binary)
 			{
-				buf[idx] = line[i]; i++; idx++;
+				idx += encodeTraceRecord( codec, logRing.buf[tail], (uint8_t*)&buf[idx] );
+			}
+			else
+			{
+				logRing.buf[tail].convToText(line);
+
+				i=0;
+				while ( line[i] != 0 )
+				{
+					buf[idx] = line[i]; i++; idx++;
+				}
+				buf[idx] = '\n'; idx++;
 			}
-			buf[idx] = '\n'; idx++;
 
-			logBufTail = (logBufTail + 1) % logBufMax;
+			tail = tail + 1;
+
+			if (tail >= logBufMax)
+			{
+				tail = 0;
+			}
+			logRing.tail.store(tail, std::memory_order_release);
 
 			if ( idx >= blockSize )
 			{
-				#ifdef WIN32
-				DWORD bytesWritten;
-				WriteFile( logFile, buf, idx, &bytesWritten, NULL ); idx = 0;
-				#else
-				if ( write( logFile, buf, idx ) < 0 )
-				{
-					// HANDLE ERROR TODO
-				}
-				idx = 0;
-				#endif
+				writeLogFile( buf, idx ); idx = 0;
 				dataNeedsFlush = true;
 			}
 		}
 
+		if (exitRequested)
+		{
+			break;
+		}
+
 		if (isPaused)
 		{
 			// If paused, the user might be at a breakpoint or doing some
@@ -2621,16 +3072,7 @@ void TraceLogDiskThread_t::run(void)
 			// Only flush data when paused, to keep write efficiency up.
 			if ( idx > 0 )
 			{
-				#ifdef WIN32
-				DWORD bytesWritten;
-				WriteFile( logFile, buf, idx, &bytesWritten, NULL ); idx = 0;
-				#else
-				if ( write( logFile, buf, idx ) < 0 )
-				{
-					// HANDLE ERROR TODO
-				}
-				idx = 0;
-				#endif
+				writeLogFile( buf, idx ); idx = 0;
 				dataNeedsFlush = true;
 			}
 			if (dataNeedsFlush)
@@ -2652,16 +3094,7 @@ void TraceLogDiskThread_t::run(void)
 	
 	if ( idx > 0 )
 	{
-		#ifdef WIN32
-		DWORD bytesWritten;
-		WriteFile( logFile, buf, idx, &bytesWritten, NULL ); idx = 0;
-		#else
-		if ( write( logFile, buf, idx ) < 0 )
-		{
-			// HANDLE ERROR TODO
-		}
-		idx = 0;
-		#endif
+		writeLogFile( buf, idx ); idx = 0;
 	}
 
 	#ifdef WIN32
@@ -59,6 +59,7 @@ struct traceRecord_t
 	int appendAsmText(const char *txt);
 
 	int convToText(char *line, int *len = 0);
+	int convToText(char *line, int *len, int options);
 };
 
 class QTraceLogView : public QWidget
@@ -167,6 +168,7 @@ protected:
 	QTimer *updateTimer;
 	QLabel    *logLastLbl;
 	QCheckBox *logFileCbox;
+	QCheckBox *logBinaryCbox;
 	QComboBox *logMaxLinesComboBox;
 
 	QCheckBox *autoUpdateCbox;
@@ -205,6 +207,7 @@ private slots:
 	void updatePeriodic(void);
 	void autoUpdateStateChanged(int state);
 	void logToFileStateChanged(int state);
+	void logBinaryStateChanged(int state);
 	void logRegStateChanged(int state);
 	void logFrameStateChanged(int state);
 	void logEmuMsgStateChanged(int state);
@@ -225,6 +228,7 @@ private slots:
 	void pageUpActivated(void);
 	void pageDnActivated(void);
 	void openLogFile(void);
+	void convertBinaryLog(void);
 	void clearLog(void);
 };
 
@@ -702,6 +702,7 @@ InitConfig()
 	// Trace Logger Options
 	config->addOption("SDL.TraceLogSaveToFile", 0);
 	config->addOption("SDL.TraceLogSaveFilePath", "");
+	config->addOption("SDL.TraceLogBinaryFormat", 0);
 	config->addOption("SDL.TraceLogPeriodicWindowUpdate", 1);
 	config->addOption("SDL.TraceLogRegisterState", 1);
 	config->addOption("SDL.TraceLogProcessorState", 1);
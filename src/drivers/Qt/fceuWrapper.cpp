@@ -39,6 +39,7 @@
 #include "Qt/unix-netplay.h"
 #include "Qt/AviRecord.h"
 #include "Qt/HexEditor.h"
+#include "Qt/FrameSnapshot.h"
 #include "Qt/CheatsConf.h"
 #include "Qt/SymbolicDebug.h"
 #include "Qt/CodeDataLogger.h"
@@ -544,6 +545,8 @@ CloseGame(void)
 	isloaded = 0;
 	GameInfo = 0;
 
+	frameSnapshotPublish();
+
 	g_config->getOption("SDL.Sound.RecordFile", &filename);
 	if(filename.size()) {
 		FCEUI_EndWaveRecord();
@@ -1478,8 +1481,8 @@ int  fceuWrapperUpdate( void )
 	if ( GameInfo )
 	{
 		DoFun(frameskip, periodic_saves);
-	
-		hexEditorUpdateMemoryValues();
+
+		frameSnapshotPublish();
 
 		if ( consoleWindow )
 		{
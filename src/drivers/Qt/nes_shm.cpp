@@ -20,6 +20,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <new>
 
 #include "Qt/nes_shm.h"
 
@@ -30,9 +31,13 @@ nes_shm_t *open_nes_shm(void)
 {
 	nes_shm_t *vaddr;
 
-	vaddr = (nes_shm_t*)malloc( sizeof(struct nes_shm_t) );
+	// Value-initialized: zero filled, and the sound ring's atomics are constructed.
+	vaddr = new (std::nothrow) nes_shm_t();
 
-	memset( vaddr, 0, sizeof(struct nes_shm_t));
+	if ( vaddr == NULL )
+	{
+		return NULL;
+	}
 
 	vaddr->video.ncol      = GL_NES_WIDTH;
 	vaddr->video.nrow      = GL_NES_HEIGHT;
@@ -49,7 +54,7 @@ void close_nes_shm(void)
 {
 	if ( nes_shm )
 	{
-		free(nes_shm); nes_shm = NULL;
+		delete nes_shm; nes_shm = NULL;
 	}
 
 }
@@ -5,6 +5,8 @@
 #define __NES_SHM_H__
 
 #include <stdint.h>
+#include <string.h>
+#include <atomic>
 
 #define  GL_WIN_PIXEL_LINEAR_FILTER  0x0001
 #define  GL_WIN_DOUBLE_BUFFER        0x0002
@@ -12,7 +14,8 @@
 #define  GL_NES_WIDTH   256
 #define  GL_NES_HEIGHT  240
 #define  NES_VIDEO_BUFLEN   5
-#define  NES_AUDIO_BUFLEN   480000
+#define  NES_AUDIO_BUFLEN   524288  // must be a power of two
+#define  NES_AUDIO_BUFMASK  (NES_AUDIO_BUFLEN-1)
 
 struct  nes_shm_t
 {
@@ -46,18 +49,95 @@ struct  nes_shm_t
 		memset( avibuf, 0, sizeof(avibuf) );
 	}
 
+	// Single producer (emulation thread) / single consumer (audio callback) ring.
+	// head and tail are free running counters, only ever masked when indexing data.
 	struct sndBuf_t
 	{
-		int  head;
-		int  tail;
+		std::atomic<uint32_t>  head;  // written by the producer only
+		std::atomic<uint32_t>  tail;  // written by the consumer only
 		int16_t  data[NES_AUDIO_BUFLEN];
-		unsigned int starveCounter;
+		std::atomic<unsigned int> starveCounter;  // samples the consumer wanted but the ring was empty
+		std::atomic<unsigned int> overrunCounter; // samples the producer had to drop because the ring stayed full
 	} sndBuf;
 
-	void  push_sound_sample( int16_t sample )
+	uint32_t  sound_sample_count(void)
 	{
-		sndBuf.data[ sndBuf.head ] = sample;
-		sndBuf.head = (sndBuf.head + 1) % NES_AUDIO_BUFLEN;
+		return sndBuf.head.load(std::memory_order_acquire) - sndBuf.tail.load(std::memory_order_acquire);
+	}
+
+	// Producer side. Queues at most 'limit' samples in total, returns false if full.
+	bool  push_sound_sample( int16_t sample, uint32_t limit = NES_AUDIO_BUFLEN )
+	{
+		uint32_t head = sndBuf.head.load(std::memory_order_relaxed);
+
+		if ( (head - sndBuf.tail.load(std::memory_order_acquire)) >= limit )
+		{
+			return false;
+		}
+		sndBuf.data[ head & NES_AUDIO_BUFMASK ] = sample;
+		sndBuf.head.store( head + 1, std::memory_order_release );
+		return true;
+	}
+
+	// Producer side. Converts and queues as much of a whole frame as fits, returns the number of samples taken.
+	int  push_samples( const int32_t *buf, int n, uint32_t limit = NES_AUDIO_BUFLEN )
+	{
+		uint32_t head  = sndBuf.head.load(std::memory_order_relaxed);
+		uint32_t used  = head - sndBuf.tail.load(std::memory_order_acquire);
+		uint32_t space = (used < limit) ? (limit - used) : 0;
+
+		if ( (uint32_t)n > space )
+		{
+			n = space;
+		}
+		uint32_t idx   = head & NES_AUDIO_BUFMASK;
+		uint32_t first = NES_AUDIO_BUFLEN - idx;
+
+		if ( first > (uint32_t)n )
+		{
+			first = n;
+		}
+		for (uint32_t i=0; i<first; i++)
+		{
+			sndBuf.data[idx+i] = (int16_t)buf[i];
+		}
+		for (uint32_t i=first; i<(uint32_t)n; i++)
+		{
+			sndBuf.data[i-first] = (int16_t)buf[i];
+		}
+		sndBuf.head.store( head + n, std::memory_order_release );
+		return n;
+	}
+
+	// Consumer side. Returns the number of samples copied out.
+	int  pop_samples( int16_t *out, int n )
+	{
+		uint32_t tail  = sndBuf.tail.load(std::memory_order_relaxed);
+		uint32_t avail = sndBuf.head.load(std::memory_order_acquire) - tail;
+
+		if ( (uint32_t)n > avail )
+		{
+			n = avail;
+		}
+		uint32_t idx   = tail & NES_AUDIO_BUFMASK;
+		uint32_t first = NES_AUDIO_BUFLEN - idx;
+
+		if ( first > (uint32_t)n )
+		{
+			first = n;
+		}
+		memcpy( out, &sndBuf.data[idx], first * sizeof(int16_t) );
+		memcpy( out + first, &sndBuf.data[0], (n - first) * sizeof(int16_t) );
+
+		sndBuf.tail.store( tail + n, std::memory_order_release );
+		return n;
+	}
+
+	// Only safe while neither side is running.
+	void  reset_sound_buffer(void)
+	{
+		sndBuf.head.store(0);
+		sndBuf.tail.store(0);
 	}
 };
 
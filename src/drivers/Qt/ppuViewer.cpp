@@ -85,6 +85,30 @@ static void initPPUViewer(void);
 static ppuPatternTable_t pattern0;
 static ppuPatternTable_t pattern1;
 static oamPatternTable_t oamPattern;
+
+// What each pattern table row was last drawn from: both bitplanes and the mask
+// shift, plus the four colours of the selected palette.  Only rows whose source
+// changed are decoded and recoloured again.
+struct patternTableCache_t
+{
+	uint8_t  row[16][16][8][3];
+	uint32_t rgb[4];
+	bool     valid;
+};
+static patternTableCache_t patternCache0;
+static patternTableCache_t patternCache1;
+
+// The same for the 64 sprites of the OAM viewer: both bitplanes of each drawn
+// row, the flips, 8x16 tile order and palette each sprite was drawn with, and
+// the colours of the four sprite palettes.
+struct spriteTableCache_t
+{
+	uint8_t  row[64][2][8][2];
+	uint8_t  attr[64];
+	uint32_t rgb[4][4];
+	bool     valid;
+};
+static spriteTableCache_t spriteCache;
 //----------------------------------------------------
 int openPPUViewWindow( QWidget *parent )
 {
@@ -1398,11 +1422,12 @@ static void initPPUViewer(void)
 
 }
 //----------------------------------------------------
-static void DrawPatternTable( ppuPatternTable_t *pattern, uint8_t *table, uint8_t *log, uint8_t pal)
+static void DrawPatternTable( ppuPatternTable_t *pattern, patternTableCache_t *cache, uint8_t *table, uint8_t *log, uint8_t pal)
 {
 	int i,j,x,y,index=0;
 	int p=0,tmp;
 	uint8_t chr0,chr1,logs,shift;
+	uint32_t rgb[4];
 
 	if (palo == NULL)
 	{
@@ -1410,6 +1435,17 @@ static void DrawPatternTable( ppuPatternTable_t *pattern, uint8_t *table, uint8_
 	}
 
 	pal <<= 2;
+	for (p = 0; p < 4; p++)
+	{
+		tmp = palcache[p | pal];
+		rgb[p] = (palo[tmp].r << 16) | (palo[tmp].g << 8) | palo[tmp].b;
+	}
+	if ( memcmp( cache->rgb, rgb, sizeof(rgb) ) != 0 )
+	{
+		memcpy( cache->rgb, rgb, sizeof(rgb) );
+		cache->valid = false;
+	}
+
 	for (i = 0; i < 16; i++)		//Columns
 	{
 		for (j = 0; j < 16; j++)	//Rows
@@ -1423,6 +1459,18 @@ static void DrawPatternTable( ppuPatternTable_t *pattern, uint8_t *table, uint8_
 				logs = log[index] & log[index + 8];
 				tmp = 7;
 				shift=(PPUView_maskUnusedGraphics && debug_loggingCD && (((logs & 3) != 0) == PPUView_invertTheMask))?3:0;
+
+				uint8_t *src = cache->row[i][j][y];
+
+				if ( cache->valid && (src[0] == chr0) && (src[1] == chr1) && (src[2] == shift) )
+				{
+					index++;
+					continue;
+				}
+				src[0] = chr0;
+				src[1] = chr1;
+				src[2] = shift;
+
 				for (x = 0; x < 8; x++)
 				{
 					p  =  (chr0 >> tmp) & 1;
@@ -1447,13 +1495,16 @@ static void DrawPatternTable( ppuPatternTable_t *pattern, uint8_t *table, uint8_
 			//------------------------------------------------
 		}
 	}
+	cache->valid = true;
 }
 //----------------------------------------------------
 static void drawSpriteTable(void)
 {
 	int j=0, y,x,yy,xx,p,tmp,idx,chr0,chr1,pal,t0,t1;
-	uint8_t *chrcache;
+	uint8_t *chrcache, attr;
 	struct oamSpriteData_t *spr;
+	spriteTableCache_t *cache = &spriteCache;
+	bool palChanged[4], redraw;
 
 	if (palo == NULL)
 	{
@@ -1461,6 +1512,23 @@ static void drawSpriteTable(void)
 	}
 	oamPattern.mode8x16 = (PPU[0] & 0x20) ? 1 : 0;
 
+	for (int i=0; i<4; i++)
+	{
+		uint32_t rgb[4];
+
+		for (p = 0; p < 4; p++)
+		{
+			tmp = palcache[((i | 0x04) * 4) | p];
+			rgb[p] = (palo[tmp].r << 16) | (palo[tmp].g << 8) | palo[tmp].b;
+		}
+		palChanged[i] = memcmp( cache->rgb[i], rgb, sizeof(rgb) ) != 0;
+
+		if ( palChanged[i] )
+		{
+			memcpy( cache->rgb[i], rgb, sizeof(rgb) );
+		}
+	}
+
 	for (int i=0; i<64; i++)
 	{
 		spr = &oamPattern.sprite[i];
@@ -1508,6 +1576,12 @@ static void drawSpriteTable(void)
 
 		pal = spr->pal * 4;
 
+		// A sprite whose flips, tile order, palette or palette colours changed
+		// is drawn again in full, otherwise only the rows whose bitplanes did.
+		attr   = spr->hFlip | (spr->vFlip << 1) | (t0 << 2) | ((spr->pal & 0x03) << 3);
+		redraw = !cache->valid || (cache->attr[i] != attr) || palChanged[spr->pal & 0x03];
+		cache->attr[i] = attr;
+
 		for (yy = 0; yy < 8; yy++)
 		{
 			if ( spr->vFlip )
@@ -1523,6 +1597,16 @@ static void drawSpriteTable(void)
 			chr1 = chrcache[idx + 8];
 			tmp = 7;
 
+			uint8_t *src = cache->row[i][0][yy];
+
+			if ( !redraw && (src[0] == chr0) && (src[1] == chr1) )
+			{
+				idx++;
+				continue;
+			}
+			src[0] = chr0;
+			src[1] = chr1;
+
 			for (xx = 0; xx < 8; xx++)
 			{
 				if ( spr->hFlip )
@@ -1568,6 +1652,16 @@ static void drawSpriteTable(void)
 			chr1 = chrcache[idx + 8];
 			tmp = 7;
 
+			uint8_t *src = cache->row[i][1][yy];
+
+			if ( !redraw && (src[0] == chr0) && (src[1] == chr1) )
+			{
+				idx++;
+				continue;
+			}
+			src[0] = chr0;
+			src[1] = chr1;
+
 			for (xx = 0; xx < 8; xx++)
 			{
 				if ( spr->hFlip )
@@ -1607,6 +1701,7 @@ static void drawSpriteTable(void)
 		//printf("OAM:%i   (X,Y)=(%3i,%3i)   Bank:%i  Tile:%i\n", i, oam[j], oam[j+3], bank, tile );
 		j += 4;
 	}
+	cache->valid = true;
 }
 //----------------------------------------------------
 void FCEUD_UpdatePPUView(int scanline, int refreshchr)
@@ -1679,8 +1774,8 @@ void FCEUD_UpdatePPUView(int scanline, int refreshchr)
 		palcache[0x0C] = palcache[0x1C] = UPALRAM[2];
 	}
 
-	DrawPatternTable( &pattern0,chrcache0,logcache0,pindex[0]);
-	DrawPatternTable( &pattern1,chrcache1,logcache1,pindex[1]);
+	DrawPatternTable( &pattern0,&patternCache0,chrcache0,logcache0,pindex[0]);
+	DrawPatternTable( &pattern1,&patternCache1,chrcache1,logcache1,pindex[1]);
 
 	if ( spriteViewWindow != NULL )
 	{
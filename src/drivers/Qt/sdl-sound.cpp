@@ -35,14 +35,11 @@
 extern Config *g_config;
 extern bool turbo;
 
-static volatile int *s_Buffer = 0;
-static unsigned int s_BufferSize;
+// Samples are queued in the nes_shm sound ring, s_BufferSize is how much of it may be used.
+static unsigned int s_BufferSize = 0;
 static unsigned int s_BufferSize25;
 static unsigned int s_BufferSize50;
 static unsigned int s_BufferSize75;
-static unsigned int s_BufferRead;
-static unsigned int s_BufferWrite;
-static volatile unsigned int s_BufferIn = 0;
 static unsigned int s_SampleRate = 44100;
 static double noiseGate = 0.0;
 static double noiseGateRate = 0.010;
@@ -57,6 +54,12 @@ extern int EmulationPaused;
 extern double frmRateAdjRatio;
 extern double g_fpsScale;
 
+static inline unsigned int
+bufferedSamples(void)
+{
+	return nes_shm->sound_sample_count();
+}
+
 /**
  * Callback from the SDL to get and play audio data.
  */
@@ -65,14 +68,12 @@ fillaudio(void *udata,
 		uint8 *stream,
 		int len)
 {
-	char bufStarveDetected = 0;
 	static int16_t sample = 0;
 	char mute;
-	//unsigned int starve_lp = nes_shm->sndBuf.starveCounter;
 	int16 *tmps = (int16*)stream;
 	len >>= 1;
 
-	if ( s_BufferIn > s_BufferSize25 )
+	if ( bufferedSamples() > s_BufferSize25 )
 	{
 		fillInit = 0;
 	}
@@ -120,7 +121,7 @@ fillaudio(void *udata,
 			}
 			else
 			{
-				if ( s_BufferIn )
+				if ( bufferedSamples() )
 				{	
 					noiseGate += noiseGateRate;
 
@@ -131,11 +132,9 @@ fillaudio(void *udata,
 					}
 				}
 			}
-			if (s_BufferIn) 
+			if ( nes_shm->pop_samples( &sample, 1 ) )
 			{
-				sample = s_Buffer[s_BufferRead] * noiseGate;
-				s_BufferRead = (s_BufferRead + 1) % s_BufferSize;
-				s_BufferIn--;
+				sample = sample * noiseGate;
 
 				*tmps = sample * noiseGate;
 			}
@@ -152,33 +151,24 @@ fillaudio(void *udata,
 	}
 	else
 	{
-		while (len) 
+		int n = nes_shm->pop_samples( tmps, len );
+
+		if ( n > 0 )
 		{
-			if (s_BufferIn) 
+			sample = tmps[n-1];
+		}
+		if ( n < len )
+		{
+			// Retain last known sample value, helps avoid clicking
+			// noise when sound system is starved of audio data.
+			nes_shm->sndBuf.starveCounter += len - n;
+
+			while ( n < len )
 			{
-				sample = s_Buffer[s_BufferRead];
-				s_BufferRead = (s_BufferRead + 1) % s_BufferSize;
-				s_BufferIn--;
-			} else {
-        	 		// Retain last known sample value, helps avoid clicking
-        	 		// noise when sound system is starved of audio data.
-				//sample = 0; 
-				bufStarveDetected = 1;
-				nes_shm->sndBuf.starveCounter++;
+				tmps[n++] = sample;
 			}
-
-			nes_shm->push_sound_sample( sample );
-
-			*tmps = sample;
-			tmps++;
-			len--;
 		}
 	}
-	if ( bufStarveDetected )
-	{
-		//s_StarveCounter = nes_shm->sndBuf.starveCounter - starve_lp;
-		//printf("Starve:%u\n", s_StarveCounter );
-	}
 }
 
 /**
@@ -277,13 +267,7 @@ InitSound()
 	noiseGateActive = true;
 	fillInit = 1;
 
-	s_Buffer = (int *)FCEU_dmalloc(sizeof(int) * s_BufferSize);
-
-	if (!s_Buffer)
-	{
-		return 0;
-	}
-	s_BufferRead = s_BufferWrite = s_BufferIn = 0;
+	nes_shm->reset_sound_buffer();
 
 	if (SDL_OpenAudio(&spec, 0) < 0)
 	{
@@ -331,7 +315,42 @@ GetMaxSound(void)
 uint32
 GetWriteSound(void)
 {
-	return(s_BufferSize - s_BufferIn);
+	unsigned int bufferIn = bufferedSamples();
+
+	return (bufferIn < s_BufferSize) ? (s_BufferSize - bufferIn) : 0;
+}
+
+/**
+ * Waits for the audio callback to make room in the sound ring.
+ * Gives up once waitCount exceeds one second over the whole WriteSound call.
+ */
+static bool
+waitForSoundSpace(int &waitCount)
+{
+	while (bufferedSamples() >= s_BufferSize) 
+	{
+		SDL_Delay(1); waitCount++;
+
+		if ( waitCount > 1000 )
+		{
+			printf("Error: Sound sink is not draining... Breaking out of audio loop to prevent lockup.\n");
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool
+pushSoundSample(int32 sample, int &waitCount)
+{
+	while ( !nes_shm->push_sound_sample( sample, s_BufferSize ) )
+	{
+		if ( !waitForSoundSpace(waitCount) )
+		{
+			return false;
+		}
+	}
+	return true;
 }
 
 /**
@@ -346,6 +365,7 @@ WriteSound(int32 *buf,
 	int ovrFlowSkip = 1;
 	int udrFlowDup  = 1;
 	static int skipCounter = 0;
+	unsigned int bufferIn = bufferedSamples();
 
 	if ( (NoWaiting & 0x01) || turbo )
 	{	// During Turbo mode, don't bother with sound as
@@ -358,7 +378,7 @@ WriteSound(int32 *buf,
 		uflowMode = 0;
 		ovrFlowSkip = (int)(g_fpsScale * 1000);
 
-		if ( s_BufferIn >= s_BufferSize50 )
+		if ( bufferIn >= s_BufferSize50 )
 		{
 			ovrFlowSkip += 1;
 		}
@@ -371,11 +391,11 @@ WriteSound(int32 *buf,
 		{
 			udrFlowDup = 1;
 		}
-		if ( s_BufferIn < s_BufferSize50 )
+		if ( bufferIn < s_BufferSize50 )
 		{
 			udrFlowDup++;
 		}
-		else if ( s_BufferIn > s_BufferSize75 )
+		else if ( bufferIn > s_BufferSize75 )
 		{
 			udrFlowDup--;
 		}
@@ -388,37 +408,19 @@ WriteSound(int32 *buf,
 
 		if ( uflowMode )
 		{	// Underflow mode
-			SDL_LockAudio();
 			while (Count)
 			{
-				if ( s_BufferIn == s_BufferSize )
+				for (int i=0; i<udrFlowDup; i++)
 				{
-					SDL_UnlockAudio();
-					while (s_BufferIn == s_BufferSize) 
+					if ( !pushSoundSample( *buf, waitCount ) )
 					{
-						SDL_Delay(1); waitCount++;
-
-						if ( waitCount > 1000 )
-						{
-							printf("Error: Sound sink is not draining... Breaking out of audio loop to prevent lockup.\n");
-							return;
-						}
+						nes_shm->sndBuf.overrunCounter += Count;
+						return;
 					}
-					SDL_LockAudio();
-				}
-
-				for (int i=0; i<udrFlowDup; i++)
-				{
-					s_Buffer[s_BufferWrite] = *buf;
-					s_BufferWrite = (s_BufferWrite + 1) % s_BufferSize;
-            
-					s_BufferIn++;
 				}
-            
 				Count--;
 				buf++;
 			}
-			SDL_UnlockAudio();
 		}
 		else
 		{
@@ -426,64 +428,33 @@ WriteSound(int32 *buf,
 			{	// Perfect one to one realtime
 				skipCounter = 0;
 
-				SDL_LockAudio();
-				while (Count)
+				while (Count > 0)
 				{
-					if (s_BufferIn == s_BufferSize) 
-					{
-						SDL_UnlockAudio();
-						while (s_BufferIn == s_BufferSize) 
-						{
-							SDL_Delay(1); waitCount++;
+					int n = nes_shm->push_samples( buf, Count, s_BufferSize );
 
-							if ( waitCount > 1000 )
-							{
-								printf("Error: Sound sink is not draining... Breaking out of audio loop to prevent lockup.\n");
-								return;
-							}
-						}
-						SDL_LockAudio();
-					}
+					Count -= n;
+					buf   += n;
 
-					s_Buffer[s_BufferWrite] = *buf;
-					Count--;
-					s_BufferWrite = (s_BufferWrite + 1) % s_BufferSize;
-            
-					s_BufferIn++;
-					buf++;
+					if ( Count && !waitForSoundSpace(waitCount) )
+					{
+						nes_shm->sndBuf.overrunCounter += Count;
+						return;
+					}
 				}
-				SDL_UnlockAudio();
 			}
 			else
 			{	// Overflow mode
-				SDL_LockAudio();
 				while (Count)
 				{
-					if (s_BufferIn == s_BufferSize) 
-					{
-						SDL_UnlockAudio();
-						while (s_BufferIn == s_BufferSize) 
-						{
-							SDL_Delay(1); waitCount++;
-
-							if ( waitCount > 1000 )
-							{
-								printf("Error: Sound sink is not draining... Breaking out of audio loop to prevent lockup.\n");
-								return;
-							}
-						}
-						SDL_LockAudio();
-					}
-
 					//printf("%i >= %i \n", skipCounter, ovrFlowSkip );
 
 					if ( skipCounter >= ovrFlowSkip )
 					{
-						s_Buffer[s_BufferWrite] = *buf;
-						s_BufferWrite = (s_BufferWrite + 1) % s_BufferSize;
-            
-						s_BufferIn++;
-
+						if ( !pushSoundSample( *buf, waitCount ) )
+						{
+							nes_shm->sndBuf.overrunCounter += Count;
+							return;
+						}
 						skipCounter -= ovrFlowSkip;
 					}
 					skipCounter = (skipCounter+1000);
@@ -491,7 +462,6 @@ WriteSound(int32 *buf,
 					Count--;
 					buf++;
 				}
-				SDL_UnlockAudio();
 			}
 
 		}
@@ -516,11 +486,10 @@ KillSound(void)
 	FCEUI_Sound(0);
 	SDL_CloseAudio();
 	SDL_QuitSubSystem(SDL_INIT_AUDIO);
-	if(s_Buffer) {
-		free((void *)s_Buffer);
-		s_Buffer = 0;
+	if (nes_shm)
+	{
+		nes_shm->reset_sound_buffer();
 	}
-	s_BufferIn = 0;
 	return 0;
 }
 
@@ -520,10 +520,20 @@ void FCEUI_AviVideoUpdate(const unsigned char* buffer)
 {	// This is not used by Qt Emulator, avi recording pulls from the post processed video buffer
 	// instead of emulation core video buffer. This allows for the video scaler effects
 	// and higher resolution to be seen in recording.
-	doBlitScreen( (uint8_t*)buffer, (uint8_t*)nes_shm->avibuf);
+	int ofs = s_srendline * 256 + NOFFSET;
 
-	aviRecordAddFrame();
+	// Refresh the palette and frame geometry without blitting.
+	doBlitScreen( (uint8_t*)buffer, NULL );
 
+	// Plain and prescaled modes hand the 8-bit frame to the disk thread,
+	// which does the palette lookup; filtered modes still blit here.
+	if ( nes_shm->video.test ||
+	     (aviRecordAddIndexedFrame( buffer + ofs, XDBuf + ofs, NWIDTH, s_tlines ) > 0) )
+	{
+		doBlitScreen( (uint8_t*)buffer, (uint8_t*)nes_shm->avibuf);
+
+		aviRecordAddFrame();
+	}
 	return;
 }
 
@@ -43,6 +43,7 @@ uint8 burst_phase = 0;
 
 static uint32 CBM[3];
 static uint32 *palettetranslate=0;
+static uint32 paletteversion=0;
 static int backBpp, backshiftr[3], backshiftl[3];
 static int silt;
 static int Bpp;	// BYTES per pixel
@@ -347,6 +348,23 @@ void SetPaletteBlitToHigh(uint8 *src)
 
 		break;
 	}
+	paletteversion++;
+}
+
+int GetPaletteBlitToHigh(const uint32 **pal, uint32 *version)
+{
+	*pal = palettetranslate;
+	*version = paletteversion;
+
+	if(Bpp != 4 || !palettetranslate)
+		return 0;
+
+	// only the bare and prescale paths are a plain deemph lookup plus a point resize
+	if(silt == 0)
+		return 1;
+	if(prescalebuf)
+		return silt - 4;
+	return 0;
 }
 
 void Blit32to24(uint32 *src, uint8 *dest, int xr, int yr, int dpitch)
@@ -20,6 +20,10 @@
 
 int InitBlitToHigh(int b, uint32 rmask, uint32 gmask, uint32 bmask, int eefx, int specfilt, int specfilteropt);
 void SetPaletteBlitToHigh(uint8 *src);
+// Palette used by Blit8ToHigh (256 legacy entries, then 512 deemph entries) and a version that
+// changes whenever it is rebuilt.  Returns the point-resize factor when the blit is a plain lookup
+// of XBuf/XDBuf that a caller can replay elsewhere, or 0 for the stateful filters.
+int GetPaletteBlitToHigh(const uint32 **pal, uint32 *version);
 void KillBlitToHigh(void);
 void Blit8ToHigh(uint8 *src, uint8 *dest, int xr, int yr, int pitch, int xscale, int yscale);
 void Blit8To8(uint8 *src, uint8 *dest, int xr, int yr, int pitch, int xscale, int yscale, int efx, int special);
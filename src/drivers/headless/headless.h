@@ -0,0 +1,17 @@
+#ifndef __FCEU_HEADLESS_H
+#define __FCEU_HEADLESS_H
+
+#include "driver.h"
+
+extern int isloaded;
+
+extern int dendy;
+extern int pal_emulation;
+extern bool swapDuty;
+
+int LoadGame(const char *path, bool silent = false);
+int CloseGame(void);
+void FCEUD_Update(uint8 *XBuf, int32 *Buffer, int Count);
+uint64 FCEUD_GetTime();
+
+#endif
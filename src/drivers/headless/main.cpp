@@ -0,0 +1,498 @@
+/* FCE Ultra - NES/Famicom Emulator
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// fceux-headless: batch runner with no video, audio or input devices.
+// Loads a ROM and optionally an FM2, runs unthrottled for a number of frames
+// and prints per-frame RAM/frame CRCs and/or writes a final savestate.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdarg>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "../../types.h"
+#include "../../fceu.h"
+#include "../../driver.h"
+#include "../../movie.h"
+#include "../../state.h"
+#include "../../file.h"
+#include "../../emufile.h"
+#include "../../filter.h"
+#include "../../utils/crc32.h"
+
+#include "headless.h"
+
+//*****************************************************************
+// Global variables shared with the core
+//*****************************************************************
+int  dendy = 0;
+int eoptions = 0;
+int isloaded = 0;
+int pal_emulation = 0;
+int closeFinishedMovie = 0;
+int KillFCEUXonFrame = 0;
+
+bool swapDuty = 0;
+bool turbo = false;
+
+static bool quiet = false;
+static unsigned int keyboardState[256];
+
+//*****************************************************************
+// File access
+//*****************************************************************
+FILE *FCEUD_UTF8fopen(const char *fn, const char *mode)
+{
+	return ::fopen(fn, mode);
+}
+
+EMUFILE_FILE* FCEUD_UTF8_fstream(const char *fn, const char *m)
+{
+	return new EMUFILE_FILE(fn, m);
+}
+
+// Archives are a frontend feature; the batch runner only takes plain files.
+ArchiveScanRecord FCEUD_ScanArchive(std::string fname)
+{
+	return ArchiveScanRecord();
+}
+
+FCEUFILE* FCEUD_OpenArchiveIndex(ArchiveScanRecord& asr, std::string& fname, int innerIndex, int* userCancel)
+{
+	return NULL;
+}
+
+FCEUFILE* FCEUD_OpenArchiveIndex(ArchiveScanRecord& asr, std::string& fname, int innerIndex)
+{
+	return NULL;
+}
+
+FCEUFILE* FCEUD_OpenArchive(ArchiveScanRecord& asr, std::string& fname, std::string* innerFilename, int* userCancel)
+{
+	return NULL;
+}
+
+FCEUFILE* FCEUD_OpenArchive(ArchiveScanRecord& asr, std::string& fname, std::string* innerFilename)
+{
+	return NULL;
+}
+
+//*****************************************************************
+// Messages
+//*****************************************************************
+const char *FCEUD_GetCompilerString(void)
+{
+#if defined(__clang__)
+	return "clang " __VERSION__;
+#elif defined(__GNUC__)
+	return "gcc " __VERSION__;
+#else
+	return "unknown";
+#endif
+}
+
+void FCEUD_Message(const char *text)
+{
+	if (!quiet)
+		fputs(text, stderr);
+}
+
+void FCEUD_PrintError(const char *errormsg)
+{
+	fprintf(stderr, "%s\n", errormsg);
+}
+
+void FCEUD_NetplayText(uint8 *text) { }
+
+int LuaPrintfToWindowConsole(const char *__restrict format, ...)
+#ifdef __linux__
+	throw()
+#endif
+{
+	va_list args;
+	int ret;
+
+	va_start(args, format);
+	ret = vfprintf(stderr, format, args);
+	va_end(args);
+
+	return ret;
+}
+
+void PrintToWindowConsole(intptr_t hDlgAsInt, const char* str)
+{
+	fputs(str, stderr);
+}
+
+// Nobody can answer a prompt in a batch run, so a runaway script is stopped.
+int LuaKillMessageBox(void)
+{
+	fprintf(stderr, "Lua script has been running a long time, killing it\n");
+	return 1;
+}
+
+void WinLuaOnStart(intptr_t hDlgAsInt) { }
+void WinLuaOnStop(intptr_t hDlgAsInt) { }
+
+//*****************************************************************
+// Video, sound and timing (all no-ops; the runner is unthrottled)
+//*****************************************************************
+static uint8 palette[256][3];
+
+void FCEUD_SetPalette(uint8 index, uint8 r, uint8 g, uint8 b)
+{
+	palette[index][0] = r;
+	palette[index][1] = g;
+	palette[index][2] = b;
+}
+
+void FCEUD_GetPalette(uint8 index, uint8 *r, uint8 *g, uint8 *b)
+{
+	*r = palette[index][0];
+	*g = palette[index][1];
+	*b = palette[index][2];
+}
+
+void FCEUD_VideoChanged(void) { }
+
+uint64 FCEUD_GetTime(void)
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint64 FCEUD_GetTimeFreq(void)
+{
+	return 1000000;
+}
+
+void FCEUD_SetEmulationSpeed(int cmd) { }
+void RefreshThrottleFPS(void) { }
+
+void FCEUD_SoundToggle(void) { }
+void FCEUD_SoundVolumeAdjust(int n) { }
+
+void FCEUD_TurboOn(void) { turbo = true; }
+void FCEUD_TurboOff(void) { turbo = false; }
+void FCEUD_TurboToggle(void) { turbo = !turbo; }
+
+void FCEUD_AviRecordTo(void) { }
+void FCEUD_AviStop(void) { }
+void FCEUI_AviVideoUpdate(const unsigned char* buffer) { }
+bool FCEUI_AviIsRecording(void) { return false; }
+bool FCEUI_AviEnableHUDrecording(void) { return false; }
+bool FCEUI_AviDisableMovieMessages(void) { return true; }
+
+//*****************************************************************
+// Frontend dialogs and toggles with no meaning here
+//*****************************************************************
+void FCEUD_MovieRecordTo(void) { }
+void FCEUD_MovieReplayFrom(void) { }
+void FCEUD_SaveStateAs(void) { }
+void FCEUD_LoadStateFrom(void) { }
+void FCEUD_HideMenuToggle(void) { }
+bool FCEUD_PauseAfterPlayback(void) { return false; }
+int FCEUD_ShowStatusIcon(void) { return 0; }
+void FCEUD_ToggleStatusIcon(void) { }
+bool FCEUD_ShouldDrawInputAids(void) { return false; }
+void FCEUI_UseInputPreset(int preset) { }
+
+void FCEUD_DebugBreakpoint(int bp_num) { }
+void FCEUD_TraceInstruction(uint8 *opcode, int size) { }
+void FCEUD_FlushTrace(void) { }
+void FCEUD_UpdateNTView(int scanline, bool drawall) { }
+void FCEUD_UpdatePPUView(int scanline, int drawall) { }
+
+int FCEUD_SendData(void *data, uint32 len) { return 0; }
+int FCEUD_RecvData(void *data, uint32 len) { return 0; }
+void FCEUD_NetworkClose(void) { }
+
+//*****************************************************************
+// Input: only movie playback drives the pads
+//*****************************************************************
+static uint32 joyData = 0;
+
+void FCEUD_SetInput(bool fourscore, bool microphone, ESI port0, ESI port1, ESIFC fcexp)
+{
+	if (fourscore)
+	{
+		port0 = port1 = SI_GAMEPAD;
+		fcexp = SIFC_NONE;
+	}
+	FCEUI_SetInput(0, port0, &joyData, 0);
+	FCEUI_SetInput(1, port1, &joyData, 0);
+	FCEUI_SetInputFC(fcexp, NULL, 0);
+	FCEUI_SetInputFourscore(fourscore);
+}
+
+unsigned int *GetKeyboard(void)
+{
+	return keyboardState;
+}
+
+void GetMouseData(uint32 (&d)[3])
+{
+	d[0] = d[1] = d[2] = 0;
+}
+
+//*****************************************************************
+// Game loading
+//*****************************************************************
+int LoadGame(const char *path, bool silent)
+{
+	if (isloaded)
+		CloseGame();
+
+	if (!FCEUI_LoadGame(path, 1, silent))
+		return 0;
+
+	isloaded = 1;
+	return 1;
+}
+
+int CloseGame(void)
+{
+	if (!isloaded)
+		return 0;
+
+	FCEUI_CloseGame();
+	isloaded = 0;
+	return 1;
+}
+
+int reloadLastGame(void)
+{
+	return 0;
+}
+
+void fceuWrapperRequestAppExit(void)
+{
+	KillFCEUXonFrame = -1;
+}
+
+void FCEUD_Update(uint8 *XBuf, int32 *Buffer, int Count) { }
+
+//*****************************************************************
+// Runner
+//*****************************************************************
+static void ShowUsage(const char *prog)
+{
+	fprintf(stderr,
+		"Usage: %s [options] <rom>\n"
+		"       %s --dump-movie <file.fm2>\n"
+		"  --movie <file.fm2>   play back a movie (read-only)\n"
+		"  --frames <n>         frames to run (default: movie length, or 600)\n"
+		"  --hash-ram           print a CRC32 of CPU RAM every frame\n"
+		"  --hash-frame         print a CRC32 of the frame buffer every frame\n"
+		"  --dump-state <file>  save a state after the last frame\n"
+		"  --time-state-load <n> time n loads of an uncompressed state taken after the last frame\n"
+		"  --pal                force PAL timing\n"
+		"  --newppu             use the new (dot-based) PPU\n"
+		"  --quiet              suppress core messages\n"
+		"  --dump-movie <file>  parse an FM2 and write it back as text, no ROM needed\n"
+		"  --check-fir          check the vector sound filter code against the scalar one\n", prog, prog);
+}
+
+// Round trip through the FM2 parser and writer, so the parser can be checked
+// against known movies without loading their ROMs.
+static int DumpMovie(const char *movieFile)
+{
+	EMUFILE_FILE fp(movieFile, "rb");
+	MovieData md;
+
+	if (fp.fail() || !LoadFM2(md, &fp, (int)fp.size(), false))
+	{
+		fprintf(stderr, "Could not load movie: %s\n", movieFile);
+		return 1;
+	}
+
+	std::vector<uint8> buf;
+	EMUFILE_MEMORY ms(&buf);
+	md.dump(&ms, false);
+	fwrite(ms.buf(), 1, ms.size(), stdout);
+	return 0;
+}
+
+// Savestate load latency for the loaded ROM's mapper: one uncompressed state
+// is taken and loaded back count times.
+static void TimeStateLoad(int count)
+{
+	std::vector<uint8> buf;
+	EMUFILE_MEMORY os(&buf);
+
+	if (!FCEUSS_SaveMS(&os, 0))
+	{
+		fprintf(stderr, "Could not save a state\n");
+		return;
+	}
+
+	uint64 start = FCEUD_GetTime();
+
+	for (int i = 0; i < count; i++)
+	{
+		EMUFILE_MEMORY is(&buf);
+		FCEUSS_LoadFP(&is, SSLOADPARAM_NOBACKUP);
+	}
+
+	double secs = (double)(FCEUD_GetTime() - start) / FCEUD_GetTimeFreq();
+
+	printf("mapper %d: %d loads of a %d byte state, %.2f us per load\n",
+		GameInfo->mappernum, count, (int)buf.size(),
+		count > 0 ? secs * 1e6 / count : 0.0);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *romFile = NULL;
+	const char *movieFile = NULL;
+	const char *stateFile = NULL;
+	int frames = -1, stateLoads = 0;
+	bool hashRam = false, hashFrame = false, pal = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+
+		if (arg == "--movie" && i + 1 < argc)
+			movieFile = argv[++i];
+		else if (arg == "--frames" && i + 1 < argc)
+			frames = atoi(argv[++i]);
+		else if (arg == "--dump-state" && i + 1 < argc)
+			stateFile = argv[++i];
+		else if (arg == "--time-state-load" && i + 1 < argc)
+			stateLoads = atoi(argv[++i]);
+		else if (arg == "--dump-movie" && i + 1 < argc)
+			return DumpMovie(argv[++i]);
+		else if (arg == "--check-fir")
+			return FCEU_FIRCheck() ? 1 : 0;
+		else if (arg == "--hash-ram")
+			hashRam = true;
+		else if (arg == "--hash-frame")
+			hashFrame = true;
+		else if (arg == "--pal")
+			pal = true;
+		else if (arg == "--newppu")
+			newppu = 1;
+		else if (arg == "--quiet")
+			quiet = true;
+		else if (arg[0] != '-' && romFile == NULL)
+			romFile = argv[i];
+		else
+		{
+			ShowUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (romFile == NULL)
+	{
+		ShowUsage(argv[0]);
+		return 1;
+	}
+
+	if (!FCEUI_Initialize())
+	{
+		fprintf(stderr, "Error initializing the emulator core.\n");
+		return 1;
+	}
+
+	FCEUI_SetBaseDirectory(".");
+	FCEUI_Sound(0);
+
+	if (!LoadGame(romFile, true))
+	{
+		fprintf(stderr, "Could not load ROM: %s\n", romFile);
+		FCEUI_Kill();
+		return 1;
+	}
+
+	// the iNES loader picks the video system from the header or file name,
+	// so the override has to come after the game is loaded
+	if (pal)
+		FCEUI_SetRegion(1, 0);
+
+	if (movieFile)
+	{
+		if (!FCEUI_LoadMovie(movieFile, true, 0))
+		{
+			fprintf(stderr, "Could not load movie: %s\n", movieFile);
+			CloseGame();
+			FCEUI_Kill();
+			return 1;
+		}
+		if (frames < 0)
+			frames = FCEUI_GetMovieLength();
+	}
+	if (frames < 0)
+		frames = 600;
+
+	// Skip rendering entirely unless the frame buffer is being hashed.
+	int skip = hashFrame ? 0 : 2;
+
+	uint64 start = FCEUD_GetTime();
+	int frame;
+
+	for (frame = 0; frame < frames; frame++)
+	{
+		uint8 *gfx = NULL;
+		int32 *sound = NULL;
+		int32 ssize = 0;
+
+		FCEUI_Emulate(&gfx, &sound, &ssize, skip);
+
+		if (hashRam || hashFrame)
+		{
+			printf("%d", frame);
+			if (hashRam)
+				printf(" ram=%08x", CalcCRC32(0, RAM, 0x800));
+			if (hashFrame && gfx)
+				printf(" frame=%08x", CalcCRC32(0, gfx, 256 * 240));
+			printf("\n");
+		}
+
+		if (KillFCEUXonFrame < 0)
+			break;
+		if (movieFile && FCEUMOV_IsFinished())
+		{
+			frame++;
+			break;
+		}
+	}
+
+	uint64 elapsed = FCEUD_GetTime() - start;
+
+	if (stateLoads > 0)
+		TimeStateLoad(stateLoads);
+
+	if (stateFile)
+		FCEUSS_Save(stateFile, false);
+
+	if (!quiet)
+	{
+		double secs = (double)elapsed / FCEUD_GetTimeFreq();
+		fprintf(stderr, "%d frames in %.3f s (%.1f fps)\n", frame, secs,
+			secs > 0 ? frame / secs : 0.0);
+	}
+
+	CloseGame();
+	FCEUI_Kill();
+
+	return 0;
+}
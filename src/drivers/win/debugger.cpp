@@ -1228,6 +1228,7 @@ void EnableBreak(int sel)
 	if(sel<0) return;
 	if(sel>=numWPs) return;
 	watchpoint[sel].flags^=WP_E;
+	FCEUI_BreakpointsChanged();
 	SendDlgItemMessage(hDebug,IDC_DEBUGGER_BP_LIST,LB_DELETESTRING,sel,0);
 	SendDlgItemMessage(hDebug,IDC_DEBUGGER_BP_LIST,LB_INSERTSTRING,sel,(LPARAM)(LPSTR)BreakToText(sel));
 	SendDlgItemMessage(hDebug,IDC_DEBUGGER_BP_LIST,LB_SETCURSEL,sel,0);
@@ -1512,6 +1513,7 @@ void DebuggerExit()
 {
 	debugger_open = 0;
 	inDebugger = false;
+	FCEUI_SetDebugHookUser(DBGHOOK_DEBUGGER, false);
 	// in case someone call it multiple times
 	if (hDebug)
 	{
@@ -1686,6 +1688,7 @@ void LoadGameDebuggerData(HWND hwndDlg = hDebug)
 		return;
 
 	numWPs = myNumWPs;
+	FCEUI_BreakpointsChanged();
 	FillDebuggerBookmarkListbox(hwndDlg);
 	FillBreakList(hwndDlg);
 }
@@ -2064,6 +2067,7 @@ INT_PTR CALLBACK DebuggerCallB(HWND hwndDlg, UINT uMsg, WPARAM wParam, LPARAM lP
 
 			debugger_open = 1;
 			inDebugger = true;
+			FCEUI_SetDebugHookUser(DBGHOOK_DEBUGGER, true);
 			break;
 		}
 		case WM_SIZE:
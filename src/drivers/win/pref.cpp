@@ -484,6 +484,7 @@ int loadPreferences(const char* romname)
 		watchpoint[i].endaddress = 0;
 		watchpoint[i].flags = 0;
 	}
+	FCEUI_BreakpointsChanged();
 
 	// Attempt to load the preferences
 	return result;
@@ -70,6 +70,7 @@ void BOOKMARK::set()
 	snapshot.keyFrame = currFrameCounter;
 	if (taseditorConfig.enableHotChanges)
 		snapshot.inputlog.copyHotChanges(&history.getCurrentSnapshot().inputlog);
+	snapshot.inputlog.shareChunks(history.getCurrentSnapshot().inputlog);
 	// copy savestate
 	savestate = greenzone.getSavestateOfFrame(currFrameCounter);
 	// save screenshot
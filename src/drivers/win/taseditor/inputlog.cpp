@@ -14,6 +14,8 @@ InputLog - Log of Input
 * implements InputLog creation: copying Input, copying Hot Changes
 * implements full/partial restoring of data from InputLog: Input, Hot Changes
 * implements compression and decompression of stored data
+* stores the data in chunks shared between InputLogs of different Snapshots, so that writing only copies the chunk being written
+  and inserting or deleting frames only copies the chunk at that frame
 * saves and loads the data from a project file. On error: sends warning to caller
 * implements searching of first mismatch comparing two InputLogs or comparing this InputLog to a movie
 * provides interface for reading specific data: reading Input of any given frame, reading value at any point of Hot Changes map
@@ -22,12 +24,424 @@ InputLog - Log of Input
 
 #include "taseditor_project.h"
 #include "zlib.h"
+#include <algorithm>
 
 extern SELECTION selection;
 extern int getInputType(MovieData& md);
 
 int joysticksPerFrame[INPUT_TYPES_TOTAL] = {1, 2, 4};
 
+INPUTLOG_CHUNK::INPUTLOG_CHUNK()
+{
+	length = 0;
+	memset(data, 0, INPUTLOG_CHUNK_SIZE);
+}
+
+INPUTLOG_BUFFER::INPUTLOG_BUFFER()
+{
+	length = 0;
+	lastIndex = 0;
+}
+
+// returns index of the chunk holding the byte at pos, and the byte's offset inside it
+int INPUTLOG_BUFFER::locate(int pos, int& ofs) const
+{
+	// most reads go through the log in order, so try the last found chunk first
+	int index = lastIndex;
+	if (index >= (int)chunks.size() || pos < chunkStart[index] || pos >= chunkStart[index] + chunks[index]->length)
+	{
+		index = std::upper_bound(chunkStart.begin(), chunkStart.end(), pos) - chunkStart.begin() - 1;
+		lastIndex = index;
+	}
+	ofs = pos - chunkStart[index];
+	return index;
+}
+
+// returns the chunk, copying it first if somebody else uses it too
+INPUTLOG_CHUNK* INPUTLOG_BUFFER::getWritable(int index)
+{
+	std::shared_ptr<INPUTLOG_CHUNK>& chunk = chunks[index];
+	if (chunk.use_count() > 1)
+		chunk = std::make_shared<INPUTLOG_CHUNK>(*chunk);
+	// data will change, so drop compressed data
+	chunk->deflated.clear();
+	return chunk.get();
+}
+
+// recalculates chunkStart[] and length after the chunks from index "first" were changed
+void INPUTLOG_BUFFER::updateIndex(int first)
+{
+	chunkStart.resize(chunks.size());
+	int pos = first ? chunkStart[first - 1] + chunks[first - 1]->length : 0;
+	for (int i = first; i < (int)chunks.size(); ++i)
+	{
+		chunkStart[i] = pos;
+		pos += chunks[i]->length;
+	}
+	length = pos;
+}
+
+// replaces chunks [first, last] with new chunks holding the given bytes, the other chunks stay shared
+void INPUTLOG_BUFFER::replaceChunks(int first, int last, std::vector<uint8>& bytes)
+{
+	// don't leave small chunks behind, merge them with a neighbour
+	if (!bytes.empty() && bytes.size() < INPUTLOG_CHUNK_SIZE / 4)
+	{
+		if (last + 1 < (int)chunks.size())
+		{
+			last++;
+			bytes.insert(bytes.end(), chunks[last]->data, chunks[last]->data + chunks[last]->length);
+		} else if (first > 0)
+		{
+			first--;
+			bytes.insert(bytes.begin(), chunks[first]->data, chunks[first]->data + chunks[first]->length);
+		}
+	}
+	// split the bytes evenly, so that the chunks have room to grow
+	int count = bytes.size();
+	int num = (count + INPUTLOG_CHUNK_MASK) >> INPUTLOG_CHUNK_SHIFT;
+	std::vector<std::shared_ptr<INPUTLOG_CHUNK>> pieces(num);
+	for (int i = 0; i < num; ++i)
+	{
+		int from = (int)((int64)count * i / num);
+		int to = (int)((int64)count * (i + 1) / num);
+		pieces[i] = std::make_shared<INPUTLOG_CHUNK>();
+		pieces[i]->length = to - from;
+		memcpy(pieces[i]->data, &bytes[from], to - from);
+	}
+	chunks.erase(chunks.begin() + first, chunks.begin() + last + 1);
+	chunks.insert(chunks.begin() + first, pieces.begin(), pieces.end());
+	updateIndex(first);
+}
+
+void INPUTLOG_BUFFER::set(int pos, uint8 value)
+{
+	// writing the same value doesn't unshare the chunk
+	int ofs;
+	int index = locate(pos, ofs);
+	if (chunks[index]->data[ofs] != value)
+		getWritable(index)->data[ofs] = value;
+}
+
+void INPUTLOG_BUFFER::resize(int newSize, uint8 value)
+{
+	if (newSize < 0) newSize = 0;
+	if (newSize > length)
+		insert(length, newSize - length, value);
+	else if (newSize < length)
+		erase(newSize, length - newSize);
+}
+
+void INPUTLOG_BUFFER::fill(int pos, uint8 value, int count)
+{
+	int ofs = 0;
+	int index = (count > 0) ? locate(pos, ofs) : 0;
+	while (count > 0)
+	{
+		int len = chunks[index]->length - ofs;
+		if (len > count) len = count;
+		// only unshare the chunk if something actually changes
+		const uint8* cur = &chunks[index]->data[ofs];
+		int i = 0;
+		while (i < len && cur[i] == value) i++;
+		if (i < len)
+			memset(&getWritable(index)->data[ofs], value, len);
+		count -= len;
+		index++;
+		ofs = 0;
+	}
+}
+
+void INPUTLOG_BUFFER::write(int pos, const uint8* source, int count)
+{
+	int ofs = 0;
+	int index = (count > 0) ? locate(pos, ofs) : 0;
+	while (count > 0)
+	{
+		int len = chunks[index]->length - ofs;
+		if (len > count) len = count;
+		if (memcmp(&chunks[index]->data[ofs], source, len))
+			memcpy(&getWritable(index)->data[ofs], source, len);
+		source += len;
+		count -= len;
+		index++;
+		ofs = 0;
+	}
+}
+
+void INPUTLOG_BUFFER::read(int pos, uint8* dest, int count) const
+{
+	int ofs = 0;
+	int index = (count > 0) ? locate(pos, ofs) : 0;
+	while (count > 0)
+	{
+		int len = chunks[index]->length - ofs;
+		if (len > count) len = count;
+		memcpy(dest, &chunks[index]->data[ofs], len);
+		dest += len;
+		count -= len;
+		index++;
+		ofs = 0;
+	}
+}
+
+void INPUTLOG_BUFFER::copy(int pos, const INPUTLOG_BUFFER& source, int sourcePos, int count)
+{
+	int ofs = 0, sourceOfs = 0, index = 0, sourceIndex = 0;
+	if (count > 0)
+	{
+		index = locate(pos, ofs);
+		sourceIndex = source.locate(sourcePos, sourceOfs);
+	}
+	while (count > 0)
+	{
+		const std::shared_ptr<INPUTLOG_CHUNK>& sourceChunk = source.chunks[sourceIndex];
+		std::shared_ptr<INPUTLOG_CHUNK>& chunk = chunks[index];
+		int len = chunk->length - ofs;
+		if (len > sourceChunk->length - sourceOfs) len = sourceChunk->length - sourceOfs;
+		if (len > count) len = count;
+		if (!ofs && !sourceOfs && len == chunk->length && len == sourceChunk->length)
+			// whole chunk, just share it
+			chunk = sourceChunk;
+		else if ((chunk != sourceChunk || ofs != sourceOfs) && memcmp(&chunk->data[ofs], &sourceChunk->data[sourceOfs], len))
+			memcpy(&getWritable(index)->data[ofs], &sourceChunk->data[sourceOfs], len);
+		ofs += len;
+		sourceOfs += len;
+		count -= len;
+		if (ofs == chunks[index]->length)
+		{
+			index++;
+			ofs = 0;
+		}
+		if (sourceOfs == sourceChunk->length)
+		{
+			sourceIndex++;
+			sourceOfs = 0;
+		}
+	}
+}
+
+void INPUTLOG_BUFFER::insert(int pos, int count, uint8 value)
+{
+	if (count <= 0) return;
+	int last = chunks.size() - 1;
+	if (pos >= length && last >= 0 && chunks[last]->length + count <= INPUTLOG_CHUNK_SIZE)
+	{
+		// appending to the last chunk, which has room for it
+		INPUTLOG_CHUNK* chunk = getWritable(last);
+		memset(&chunk->data[chunk->length], value, count);
+		chunk->length += count;
+		updateIndex(last);
+		return;
+	}
+	// rebuild only the chunk at pos, the chunks after it move along and stay shared
+	int ofs = 0;
+	int index = chunks.size();
+	if (pos < length)
+		index = locate(pos, ofs);
+	else if (last >= 0)
+	{
+		index = last;
+		ofs = chunks[last]->length;
+	}
+	std::vector<uint8> bytes;
+	if (index < (int)chunks.size())
+	{
+		const INPUTLOG_CHUNK& chunk = *chunks[index];
+		bytes.assign(chunk.data, chunk.data + ofs);
+		bytes.insert(bytes.end(), count, value);
+		bytes.insert(bytes.end(), chunk.data + ofs, chunk.data + chunk.length);
+		replaceChunks(index, index, bytes);
+	} else
+	{
+		bytes.assign(count, value);
+		replaceChunks(index, index - 1, bytes);
+	}
+}
+
+void INPUTLOG_BUFFER::erase(int pos, int count)
+{
+	if (count <= 0) return;
+	// rebuild only the chunks where the erased bytes begin and end
+	int ofs, endOfs;
+	int first = locate(pos, ofs);
+	int last = locate(pos + count - 1, endOfs);
+	endOfs++;
+	std::vector<uint8> bytes(chunks[first]->data, chunks[first]->data + ofs);
+	bytes.insert(bytes.end(), chunks[last]->data + endOfs, chunks[last]->data + chunks[last]->length);
+	replaceChunks(first, last, bytes);
+}
+
+// returns the first position in [start, end) where the buffers differ, or -1
+int INPUTLOG_BUFFER::findFirstDifference(const INPUTLOG_BUFFER& theirBuffer, int start, int end) const
+{
+	if (start >= end) return -1;
+	int ofs, theirOfs;
+	int index = locate(start, ofs);
+	int theirIndex = theirBuffer.locate(start, theirOfs);
+	int pos = start;
+	while (pos < end)
+	{
+		const std::shared_ptr<INPUTLOG_CHUNK>& chunk = chunks[index];
+		const std::shared_ptr<INPUTLOG_CHUNK>& theirChunk = theirBuffer.chunks[theirIndex];
+		int len = chunk->length - ofs;
+		if (len > theirChunk->length - theirOfs) len = theirChunk->length - theirOfs;
+		if (len > end - pos) len = end - pos;
+		// shared chunks are equal without looking at them
+		if (chunk != theirChunk || ofs != theirOfs)
+		{
+			const uint8* mine = &chunk->data[ofs];
+			const uint8* theirs = &theirChunk->data[theirOfs];
+			if (memcmp(mine, theirs, len))
+			{
+				for (int i = 0; i < len; ++i)
+					if (mine[i] != theirs[i]) return pos + i;
+			}
+		}
+		pos += len;
+		ofs += len;
+		theirOfs += len;
+		if (ofs == chunk->length)
+		{
+			index++;
+			ofs = 0;
+		}
+		if (theirOfs == theirChunk->length)
+		{
+			theirIndex++;
+			theirOfs = 0;
+		}
+	}
+	return -1;
+}
+
+// returns how many bytes at the ends of both buffers are the same, but not more than limit
+int INPUTLOG_BUFFER::findCommonTail(const INPUTLOG_BUFFER& theirBuffer, int limit) const
+{
+	int tail = 0;
+	int index = chunks.size() - 1;
+	int theirIndex = theirBuffer.chunks.size() - 1;
+	// bytes of the current chunks that aren't compared yet
+	int left = (limit > 0) ? chunks[index]->length : 0;
+	int theirLeft = (limit > 0) ? theirBuffer.chunks[theirIndex]->length : 0;
+	while (tail < limit)
+	{
+		const std::shared_ptr<INPUTLOG_CHUNK>& chunk = chunks[index];
+		const std::shared_ptr<INPUTLOG_CHUNK>& theirChunk = theirBuffer.chunks[theirIndex];
+		int len = (left < theirLeft) ? left : theirLeft;
+		if (len > limit - tail) len = limit - tail;
+		if (chunk != theirChunk || left != theirLeft)
+		{
+			const uint8* mine = &chunk->data[left - len];
+			const uint8* theirs = &theirChunk->data[theirLeft - len];
+			if (memcmp(mine, theirs, len))
+			{
+				for (int i = len - 1; i >= 0; --i)
+					if (mine[i] != theirs[i]) return tail + (len - 1 - i);
+			}
+		}
+		tail += len;
+		left -= len;
+		theirLeft -= len;
+		if (!left && index > 0)
+			left = chunks[--index]->length;
+		if (!theirLeft && theirIndex > 0)
+			theirLeft = theirBuffer.chunks[--theirIndex]->length;
+	}
+	return tail;
+}
+
+// replace own chunks with their chunks wherever the data is the same
+// the same data may be at another place, because frames were inserted or deleted, so look for the equal beginning and the equal end
+void INPUTLOG_BUFFER::shareChunks(const INPUTLOG_BUFFER& theirBuffer)
+{
+	if (!length || !theirBuffer.length) return;
+	int common = (length < theirBuffer.length) ? length : theirBuffer.length;
+	int head = findFirstDifference(theirBuffer, 0, common);
+	if (head < 0) head = common;
+	int tail = findCommonTail(theirBuffer, common - head);
+	// their chunks lying entirely in the equal beginning
+	int numHead = 0;
+	int middleStart = 0;
+	while (numHead < (int)theirBuffer.chunks.size() && middleStart + theirBuffer.chunks[numHead]->length <= head)
+		middleStart += theirBuffer.chunks[numHead++]->length;
+	// their chunks lying entirely in the equal end
+	int firstTail = theirBuffer.chunks.size();
+	while (firstTail > numHead && theirBuffer.chunkStart[firstTail - 1] >= theirBuffer.length - tail)
+		firstTail--;
+	int middleEnd = length - (theirBuffer.length - ((firstTail < (int)theirBuffer.chunks.size()) ? theirBuffer.chunkStart[firstTail] : theirBuffer.length));
+	// everything else is own data
+	std::vector<uint8> middle(middleEnd - middleStart);
+	read(middleStart, middle.data(), middle.size());
+	chunks.assign(theirBuffer.chunks.begin(), theirBuffer.chunks.begin() + numHead);
+	chunks.insert(chunks.end(), theirBuffer.chunks.begin() + firstTail, theirBuffer.chunks.end());
+	updateIndex(0);
+	replaceChunks(numHead, numHead - 1, middle);
+}
+
+void INPUTLOG_BUFFER::compressData(void)
+{
+	for (size_t i = 0; i < chunks.size(); ++i)
+	{
+		INPUTLOG_CHUNK& chunk = *chunks[i];
+		if (!chunk.deflated.empty()) continue;
+		// raw deflate closed with a sync flush, so that compressed chunks can be glued into one zlib stream when saving
+		z_stream zs;
+		memset(&zs, 0, sizeof(zs));
+		deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+		chunk.deflated.resize(chunk.length + (chunk.length >> 9) + 64);
+		zs.next_in = chunk.data;
+		zs.avail_in = chunk.length;
+		zs.next_out = &chunk.deflated[0];
+		zs.avail_out = chunk.deflated.size();
+		deflate(&zs, Z_SYNC_FLUSH);
+		chunk.deflated.resize(zs.total_out);
+		deflateEnd(&zs);
+	}
+}
+
+void INPUTLOG_BUFFER::save(EMUFILE *os)
+{
+	compressData();
+	// the same zlib stream format as compress() produces: header, deflate blocks of all chunks, final empty block, Adler-32 of the data
+	static const uint8 zlibHeader[2] = {0x78, 0x9C};
+	static const uint8 finalBlock[2] = {0x03, 0x00};
+	uLong adler = adler32(0, NULL, 0);
+	unsigned int comprlen = sizeof(zlibHeader) + sizeof(finalBlock) + 4;
+	for (size_t i = 0; i < chunks.size(); ++i)
+	{
+		comprlen += chunks[i]->deflated.size();
+		adler = adler32(adler, chunks[i]->data, chunks[i]->length);
+	}
+	write32le(comprlen, os);
+	os->fwrite(zlibHeader, sizeof(zlibHeader));
+	for (size_t i = 0; i < chunks.size(); ++i)
+		os->fwrite(&chunks[i]->deflated[0], chunks[i]->deflated.size());
+	os->fwrite(finalBlock, sizeof(finalBlock));
+	uint8 adlerBytes[4] = {(uint8)(adler >> 24), (uint8)(adler >> 16), (uint8)(adler >> 8), (uint8)adler};
+	os->fwrite(adlerBytes, sizeof(adlerBytes));
+}
+// returns true if couldn't load
+bool INPUTLOG_BUFFER::load(EMUFILE *is, int expectedSize)
+{
+	unsigned int comprlen;
+	// read size
+	if (!read32le(&comprlen, is)) return true;
+	if (comprlen == 0) return true;
+	std::vector<uint8> compressed(comprlen);
+	if (is->fread(&compressed[0], comprlen) != comprlen) return true;
+	// uncompress into new chunks
+	uLongf destlen = expectedSize;
+	std::vector<uint8> data(expectedSize + 1);
+	int e = uncompress(&data[0], &destlen, &compressed[0], comprlen);
+	if (e != Z_OK && e != Z_BUF_ERROR) return true;
+	chunks.clear();
+	data.resize(expectedSize);
+	replaceChunks(0, -1, data);
+	return false;
+}
+// --------------------------------------------------------------------------------------------
+
 INPUTLOG::INPUTLOG()
 {
 }
@@ -52,8 +466,8 @@ void INPUTLOG::init(MovieData& md, bool hotchanges, int force_input_type)
 	for (int frame = 0; frame < size; ++frame)
 	{
 		for (joy = num_joys - 1; joy >= 0; joy--)
-			joysticks[frame * num_joys * BYTES_PER_JOYSTICK + joy * BYTES_PER_JOYSTICK] = md.records[frame].joysticks[joy];
-		commands[frame] = md.records[frame].commands;
+			joysticks.set(frame * num_joys * BYTES_PER_JOYSTICK + joy * BYTES_PER_JOYSTICK, md.records[frame].joysticks[joy]);
+		commands.set(frame, md.records[frame].commands);
 	}
 	alreadyCompressed = false;
 }
@@ -90,8 +504,8 @@ void INPUTLOG::reinit(MovieData& md, bool hotchanges, int frame_of_change)
 
 	// update Input vector
 	for (joy = num_joys - 1; joy >= 0; joy--)
-		joysticks[frame_of_change * num_joys * BYTES_PER_JOYSTICK + joy * BYTES_PER_JOYSTICK] = md.records[frame_of_change].joysticks[joy];
-	commands[frame_of_change] = md.records[frame_of_change].commands;
+		joysticks.set(frame_of_change * num_joys * BYTES_PER_JOYSTICK + joy * BYTES_PER_JOYSTICK, md.records[frame_of_change].joysticks[joy]);
+	commands.set(frame_of_change, md.records[frame_of_change].commands);
 	alreadyCompressed = false;
 }
 
@@ -105,34 +519,18 @@ void INPUTLOG::toMovie(MovieData& md, int start, int end)
 	for (int frame = start; frame <= end; ++frame)
 	{
 		for (joy = num_joys - 1; joy >= 0; joy--)
-			md.records[frame].joysticks[joy] = joysticks[frame * num_joys * BYTES_PER_JOYSTICK + joy * BYTES_PER_JOYSTICK];
-		md.records[frame].commands = commands[frame];
+			md.records[frame].joysticks[joy] = joysticks.get(frame * num_joys * BYTES_PER_JOYSTICK + joy * BYTES_PER_JOYSTICK);
+		md.records[frame].commands = commands.get(frame);
 	}
 }
 
 void INPUTLOG::compressData()
 {
-	// compress joysticks
-	int len = joysticks.size();
-	uLongf comprlen = (len>>9)+12 + len;
-	compressedJoysticks.resize(comprlen);
-	compress(&compressedJoysticks[0], &comprlen, &joysticks[0], len);
-	compressedJoysticks.resize(comprlen);
-	// compress commands
-	len = commands.size();
-	comprlen = (len>>9)+12 + len;
-	compressedCommands.resize(comprlen);
-	compress(&compressedCommands[0], &comprlen, &commands[0], len);
-	compressedCommands.resize(comprlen);
+	// compress only the chunks that aren't compressed yet (by this or another InputLog sharing them)
+	joysticks.compressData();
+	commands.compressData();
 	if (hasHotChanges)
-	{
-		// compress hot_changes
-		len = hotChanges.size();
-		comprlen = (len>>9)+12 + len;
-		compressedHotChanges.resize(comprlen);
-		compress(&compressedHotChanges[0], &comprlen, &hotChanges[0], len);
-		compressedHotChanges.resize(comprlen);
-	}
+		hotChanges.compressData();
 	// don't recompress anymore
 	alreadyCompressed = true;
 }
@@ -150,17 +548,14 @@ void INPUTLOG::save(EMUFILE *os)
 	if (!alreadyCompressed)
 		compressData();
 	// save joysticks data
-	write32le(compressedJoysticks.size(), os);
-	os->fwrite(&compressedJoysticks[0], compressedJoysticks.size());
+	joysticks.save(os);
 	// save commands data
-	write32le(compressedCommands.size(), os);
-	os->fwrite(&compressedCommands[0], compressedCommands.size());
+	commands.save(os);
 	if (hasHotChanges)
 	{
 		write8le((uint8)1, os);
 		// save hot_changes data
-		write32le(compressedHotChanges.size(), os);
-		os->fwrite(&compressedHotChanges[0], compressedHotChanges.size());
+		hotChanges.save(os);
 	} else
 	{
 		write8le((uint8)0, os);
@@ -174,46 +569,20 @@ bool INPUTLOG::load(EMUFILE *is)
 	if (!read32le(&size, is)) return true;
 	if (!read8le(&tmp, is)) return true;
 	inputType = tmp;
-	// read data
-	alreadyCompressed = true;
-	int comprlen;
-	uLongf destlen;
 	// read and uncompress joysticks data
-	destlen = size * BYTES_PER_JOYSTICK * joysticksPerFrame[inputType];
-	joysticks.resize(destlen);
-	// read size
-	if (!read32le(&comprlen, is)) return true;
-	if (comprlen <= 0) return true;
-	compressedJoysticks.resize(comprlen);
-	if (is->fread(&compressedJoysticks[0], comprlen) != comprlen) return true;
-	int e = uncompress(&joysticks[0], &destlen, &compressedJoysticks[0], comprlen);
-	if (e != Z_OK && e != Z_BUF_ERROR) return true;
+	if (joysticks.load(is, size * BYTES_PER_JOYSTICK * joysticksPerFrame[inputType])) return true;
 	// read and uncompress commands data
-	destlen = size;
-	commands.resize(destlen);
-	// read size
-	if (!read32le(&comprlen, is)) return true;
-	if (comprlen <= 0) return true;
-	compressedCommands.resize(comprlen);
-	if (is->fread(&compressedCommands[0], comprlen) != comprlen) return true;
-	e = uncompress(&commands[0], &destlen, &compressedCommands[0], comprlen);
-	if (e != Z_OK && e != Z_BUF_ERROR) return true;
+	if (commands.load(is, size)) return true;
 	// read hotchanges
 	if (!read8le(&tmp, is)) return true;
 	hasHotChanges = (tmp != 0);
 	if (hasHotChanges)
 	{
 		// read and uncompress hot_changes data
-		destlen = size * joysticksPerFrame[inputType] * HOTCHANGE_BYTES_PER_JOY;
-		hotChanges.resize(destlen);
-		// read size
-		if (!read32le(&comprlen, is)) return true;
-		if (comprlen <= 0) return true;
-		compressedHotChanges.resize(comprlen);
-		if (is->fread(&compressedHotChanges[0], comprlen) != comprlen) return true;
-		e = uncompress(&hotChanges[0], &destlen, &compressedHotChanges[0], comprlen);
-		if (e != Z_OK && e != Z_BUF_ERROR) return true;
+		if (hotChanges.load(is, size * joysticksPerFrame[inputType] * HOTCHANGE_BYTES_PER_JOY)) return true;
 	}
+	// chunks get compressed again when idle
+	alreadyCompressed = false;
 	return false;
 }
 bool INPUTLOG::skipLoad(EMUFILE *is)
@@ -249,6 +618,27 @@ int INPUTLOG::findFirstChange(INPUTLOG& theirLog, int start, int end)
 
 	int joy;
 	int num_joys = joysticksPerFrame[inputType];
+	if (inputType == theirLog.inputType)
+	{
+		// frames present in both InputLogs: compare chunk by chunk, skipping the chunks they share
+		int common_end = (end < their_log_end) ? end : their_log_end - 1;
+		if (start <= common_end)
+		{
+			int bytes = BYTES_PER_JOYSTICK * num_joys;
+			int joysticks_change = joysticks.findFirstDifference(theirLog.joysticks, start * bytes, (common_end + 1) * bytes);
+			if (joysticks_change >= 0)
+			{
+				joysticks_change /= bytes;
+				common_end = joysticks_change;
+			}
+			int commands_change = commands.findFirstDifference(theirLog.commands, start, common_end + 1);
+			if (commands_change >= 0)
+				return commands_change;
+			if (joysticks_change >= 0)
+				return joysticks_change;
+			start = common_end + 1;
+		}
+	}
 	for (int frame = start; frame <= end; ++frame)
 	{
 		for (joy = num_joys - 1; joy >= 0; joy--)
@@ -294,13 +684,13 @@ int INPUTLOG::getJoystickData(int frame, int joy)
 		return 0;
 	if (joy > joysticksPerFrame[inputType])
 		return 0;
-	return joysticks[frame * BYTES_PER_JOYSTICK * joysticksPerFrame[inputType] + joy];
+	return joysticks.get(frame * BYTES_PER_JOYSTICK * joysticksPerFrame[inputType] + joy);
 }
 int INPUTLOG::getCommandsData(int frame)
 {
 	if (frame < 0 || frame >= size)
 		return 0;
-	return commands[frame];
+	return commands.get(frame);
 }
 
 void INPUTLOG::insertFrames(int at, int frames)
@@ -313,25 +703,22 @@ void INPUTLOG::insertFrames(int at, int frames)
 		joysticks.resize(BYTES_PER_JOYSTICK * joysticksPerFrame[inputType] * size);
 		if (hasHotChanges)
 		{
-			hotChanges.resize(joysticksPerFrame[inputType] * size * HOTCHANGE_BYTES_PER_JOY);
 			// fill new hotchanges with max value
-			int lower_limit = joysticksPerFrame[inputType] * (size - frames) * HOTCHANGE_BYTES_PER_JOY;
-			for (int i = hotChanges.size() - 1; i >= lower_limit; i--)
-				hotChanges[i] = BYTE_VALUE_CONTAINING_MAX_HOTCHANGES;
+			hotChanges.resize(joysticksPerFrame[inputType] * size * HOTCHANGE_BYTES_PER_JOY, BYTE_VALUE_CONTAINING_MAX_HOTCHANGES);
 		}
 	} else
 	{
 		// insert frames
 		// insert 1 byte of commands
-		commands.insert(commands.begin() + at, frames, 0);
+		commands.insert(at, frames, 0);
 		// insert X bytes of joystics
 		int bytes = BYTES_PER_JOYSTICK * joysticksPerFrame[inputType];
-		joysticks.insert(joysticks.begin() + (at * bytes), frames * bytes, 0);
+		joysticks.insert(at * bytes, frames * bytes, 0);
 		if (hasHotChanges)
 		{
 			// insert X bytes of hot_changes
 			bytes = joysticksPerFrame[inputType] * HOTCHANGE_BYTES_PER_JOY;
-			hotChanges.insert(hotChanges.begin() + (at * bytes), frames * bytes, BYTE_VALUE_CONTAINING_MAX_HOTCHANGES);
+			hotChanges.insert(at * bytes, frames * bytes, BYTE_VALUE_CONTAINING_MAX_HOTCHANGES);
 		}
 	}
 	// data was changed
@@ -340,15 +727,15 @@ void INPUTLOG::insertFrames(int at, int frames)
 void INPUTLOG::eraseFrame(int frame)
 {
 	// erase 1 byte of commands
-	commands.erase(commands.begin() + frame);
+	commands.erase(frame, 1);
 	// erase X bytes of joystics
 	int bytes = BYTES_PER_JOYSTICK * joysticksPerFrame[inputType];
-	joysticks.erase(joysticks.begin() + (frame * bytes), joysticks.begin() + ((frame + 1) * bytes));
+	joysticks.erase(frame * bytes, bytes);
 	if (hasHotChanges)
 	{
 		// erase X bytes of hot_changes
 		bytes = joysticksPerFrame[inputType] * HOTCHANGE_BYTES_PER_JOY;
-		hotChanges.erase(hotChanges.begin() + (frame * bytes), hotChanges.begin() + ((frame + 1) * bytes));
+		hotChanges.erase(frame * bytes, bytes);
 	}
 	size--;
 	// data was changed
@@ -373,7 +760,7 @@ void INPUTLOG::copyHotChanges(INPUTLOG* sourceOfHotChanges, int limiterFrameOfSo
 			frames_to_copy = limiterFrameOfSource;
 
 		int bytes_to_copy = frames_to_copy * joysticksPerFrame[inputType] * HOTCHANGE_BYTES_PER_JOY;
-		memcpy(&hotChanges[0], &sourceOfHotChanges->hotChanges[0], bytes_to_copy);
+		hotChanges.copy(0, sourceOfHotChanges->hotChanges, 0, bytes_to_copy);
 	}
 } 
 void INPUTLOG::inheritHotChanges(INPUTLOG* sourceOfHotChanges)
@@ -386,7 +773,7 @@ void INPUTLOG::inheritHotChanges(INPUTLOG* sourceOfHotChanges)
 			frames_to_copy = size;
 
 		int bytes_to_copy = frames_to_copy * joysticksPerFrame[inputType] * HOTCHANGE_BYTES_PER_JOY;
-		memcpy(&hotChanges[0], &sourceOfHotChanges->hotChanges[0], bytes_to_copy);
+		hotChanges.copy(0, sourceOfHotChanges->hotChanges, 0, bytes_to_copy);
 		fadeHotChanges();
 	}
 } 
@@ -410,7 +797,7 @@ void INPUTLOG::inheritHotChanges_DeleteSelection(INPUTLOG* sourceOfHotChanges, R
 			} else
 			{
 				// copy hotchanges of this frame
-				memcpy(&hotChanges[pos], &sourceOfHotChanges->hotChanges[source_pos], bytes);
+				hotChanges.copy(pos, sourceOfHotChanges->hotChanges, source_pos, bytes);
 				pos += bytes;
 				source_pos += bytes;
 			}
@@ -437,14 +824,14 @@ void INPUTLOG::inheritHotChanges_InsertSelection(INPUTLOG* sourceOfHotChanges, R
 				it++;
 				region_len++;
 				// set filled line to the frame
-				memset(&hotChanges[pos], BYTE_VALUE_CONTAINING_MAX_HOTCHANGES, bytes);
+				hotChanges.fill(pos, BYTE_VALUE_CONTAINING_MAX_HOTCHANGES, bytes);
 			} else if (source_pos < source_size)
 			{
 				// this frame should be copied
 				frame -= region_len;
 				region_len = 0;
 				// copy hotchanges of this frame
-				memcpy(&hotChanges[pos], &sourceOfHotChanges->hotChanges[source_pos], bytes);
+				hotChanges.copy(pos, sourceOfHotChanges->hotChanges, source_pos, bytes);
 				fadeHotChanges(pos, pos + bytes);
 				source_pos += bytes;
 			}
@@ -465,7 +852,7 @@ void INPUTLOG::inheritHotChanges_InsertSelection(INPUTLOG* sourceOfHotChanges, R
 				it++;
 				region_len++;
 				// set filled line to the frame
-				memset(&hotChanges[pos], BYTE_VALUE_CONTAINING_MAX_HOTCHANGES, bytes);
+				hotChanges.fill(pos, BYTE_VALUE_CONTAINING_MAX_HOTCHANGES, bytes);
 				// exit loop when all frames in the Selection are handled
 				if (it == frameset_end) break;
 			} else
@@ -491,13 +878,13 @@ void INPUTLOG::inheritHotChanges_DeleteNum(INPUTLOG* sourceOfHotChanges, int sta
 		int dest_pos = 0, source_pos = 0;
 		if (bytes_to_copy > source_size)
 			bytes_to_copy = source_size;
-		memcpy(&hotChanges[dest_pos], &sourceOfHotChanges->hotChanges[source_pos], bytes_to_copy);
+		hotChanges.copy(dest_pos, sourceOfHotChanges->hotChanges, source_pos, bytes_to_copy);
 		dest_pos += bytes_to_copy;
 		source_pos += bytes_to_copy + bytes * frames;
 		bytes_to_copy = this_size - dest_pos;
 		if (bytes_to_copy > source_size - source_pos)
 			bytes_to_copy = source_size - source_pos;
-		memcpy(&hotChanges[dest_pos], &sourceOfHotChanges->hotChanges[source_pos], bytes_to_copy);
+		hotChanges.copy(dest_pos, sourceOfHotChanges->hotChanges, source_pos, bytes_to_copy);
 		if (fadeOld)
 			fadeHotChanges();
 	}
@@ -513,18 +900,18 @@ void INPUTLOG::inheritHotChanges_InsertNum(INPUTLOG* sourceOfHotChanges, int sta
 		int dest_pos = 0, source_pos = 0;
 		if (bytes_to_copy > source_size)
 			bytes_to_copy = source_size;
-		memcpy(&hotChanges[dest_pos], &sourceOfHotChanges->hotChanges[source_pos], bytes_to_copy);
+		hotChanges.copy(dest_pos, sourceOfHotChanges->hotChanges, source_pos, bytes_to_copy);
 		dest_pos += bytes_to_copy + bytes * frames;
 		source_pos += bytes_to_copy;
 		bytes_to_copy = this_size - dest_pos;
 		if (bytes_to_copy > source_size - source_pos)
 			bytes_to_copy = source_size - source_pos;
-		memcpy(&hotChanges[dest_pos], &sourceOfHotChanges->hotChanges[source_pos], bytes_to_copy);
+		hotChanges.copy(dest_pos, sourceOfHotChanges->hotChanges, source_pos, bytes_to_copy);
 		if (fadeOld)
 			fadeHotChanges();
 	}
 	// fill the gap with max_hot lines on frames from "start" to "start+frames"
-	memset(&hotChanges[bytes * start], BYTE_VALUE_CONTAINING_MAX_HOTCHANGES, bytes * frames);
+	hotChanges.fill(bytes * start, BYTE_VALUE_CONTAINING_MAX_HOTCHANGES, bytes * frames);
 }
 void INPUTLOG::inheritHotChanges_PasteInsert(INPUTLOG* sourceOfHotChanges, RowsSelection* insertedSet)
 {
@@ -546,11 +933,11 @@ void INPUTLOG::inheritHotChanges_PasteInsert(INPUTLOG* sourceOfHotChanges, RowsS
 				// this frame was inserted
 				it++;
 				// set filled line to the frame
-				memset(&hotChanges[pos], BYTE_VALUE_CONTAINING_MAX_HOTCHANGES, bytes);
+				hotChanges.fill(pos, BYTE_VALUE_CONTAINING_MAX_HOTCHANGES, bytes);
 			} else if (source_pos < source_size)
 			{
 				// copy hotchanges of this frame
-				memcpy(&hotChanges[pos], &sourceOfHotChanges->hotChanges[source_pos], bytes);
+				hotChanges.copy(pos, sourceOfHotChanges->hotChanges, source_pos, bytes);
 				fadeHotChanges(pos, pos + bytes);
 				source_pos += bytes;
 			}
@@ -567,7 +954,7 @@ void INPUTLOG::inheritHotChanges_PasteInsert(INPUTLOG* sourceOfHotChanges, RowsS
 				// this frame was inserted
 				it++;
 				// set filled line to the frame
-				memset(&hotChanges[pos], BYTE_VALUE_CONTAINING_MAX_HOTCHANGES, bytes);
+				hotChanges.fill(pos, BYTE_VALUE_CONTAINING_MAX_HOTCHANGES, bytes);
 				pos += bytes;
 				// exit loop when all inserted_set frames are handled
 				if (it == inserted_set_end) break;
@@ -612,26 +999,28 @@ void INPUTLOG::setMaxHotChanges(int frame, int absoluteButtonNumber)
 {
 	if (frame < 0 || frame >= size || !hasHotChanges) return;
 	// set max value to the button hotness
+	int pos = frame * (HOTCHANGE_BYTES_PER_JOY * joysticksPerFrame[inputType]) + (absoluteButtonNumber >> 1);
 	if (absoluteButtonNumber & 1)
-		hotChanges[frame * (HOTCHANGE_BYTES_PER_JOY * joysticksPerFrame[inputType]) + (absoluteButtonNumber >> 1)] |= BYTE_VALUE_CONTAINING_MAX_HOTCHANGE_HI;
+		hotChanges.set(pos, hotChanges.get(pos) | BYTE_VALUE_CONTAINING_MAX_HOTCHANGE_HI);
 	else
-		hotChanges[frame * (HOTCHANGE_BYTES_PER_JOY * joysticksPerFrame[inputType]) + (absoluteButtonNumber >> 1)] |= BYTE_VALUE_CONTAINING_MAX_HOTCHANGE_LO;
+		hotChanges.set(pos, hotChanges.get(pos) | BYTE_VALUE_CONTAINING_MAX_HOTCHANGE_LO);
 }
 
 void INPUTLOG::fadeHotChanges(int startByte, int endByte)
 {
-	uint8 hi_half, low_half;
+	uint8 val, hi_half, low_half;
 	if (endByte < 0)
 		endByte = hotChanges.size();
 	for (int i = endByte - 1; i >= startByte; i--)
 	{
-		if (hotChanges[i])
+		val = hotChanges.get(i);
+		if (val)
 		{
-			hi_half = hotChanges[i] >> HOTCHANGE_BITS_PER_VALUE;
-			low_half = hotChanges[i] & HOTCHANGE_BITMASK;
+			hi_half = val >> HOTCHANGE_BITS_PER_VALUE;
+			low_half = val & HOTCHANGE_BITMASK;
 			if (hi_half) hi_half--;
 			if (low_half) low_half--;
-			hotChanges[i] = (hi_half << HOTCHANGE_BITS_PER_VALUE) | low_half;
+			hotChanges.set(i, (hi_half << HOTCHANGE_BITS_PER_VALUE) | low_half);
 		}
 	}
 }
@@ -641,7 +1030,7 @@ int INPUTLOG::getHotChangesInfo(int frame, int absoluteButtonNumber)
 	if (!hasHotChanges || frame < 0 || frame >= size || absoluteButtonNumber < 0 || absoluteButtonNumber >= NUM_JOYPAD_BUTTONS * joysticksPerFrame[inputType])
 		return 0;
 
-	uint8 val = hotChanges[frame * (HOTCHANGE_BYTES_PER_JOY * joysticksPerFrame[inputType]) + (absoluteButtonNumber >> 1)];
+	uint8 val = hotChanges.get(frame * (HOTCHANGE_BYTES_PER_JOY * joysticksPerFrame[inputType]) + (absoluteButtonNumber >> 1));
 
 	if (absoluteButtonNumber & 1)
 		// odd buttons (B, T, D, R) take upper 4 bits of the byte 
@@ -651,3 +1040,10 @@ int INPUTLOG::getHotChangesInfo(int frame, int absoluteButtonNumber)
 		return val & HOTCHANGE_BITMASK;
 }
 
+// take chunks of theirLog wherever they hold the same data, so that similar Snapshots keep one copy of the unchanged parts
+void INPUTLOG::shareChunks(INPUTLOG& theirLog)
+{
+	joysticks.shareChunks(theirLog.joysticks);
+	commands.shareChunks(theirLog.commands);
+	hotChanges.shareChunks(theirLog.hotChanges);
+}
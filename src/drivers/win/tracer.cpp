@@ -385,6 +385,7 @@ INT_PTR CALLBACK TracerCallB(HWND hwndDlg, UINT uMsg, WPARAM wParam, LPARAM lPar
 		case WM_INITDIALOG:
 		{
 			hTracer = hwndDlg;
+			FCEUI_SetDebugHookUser(DBGHOOK_TRACER, true);
 			// calculate initial size/positions of items
 			RECT mainRect;
 			GetClientRect(hTracer, &mainRect);
@@ -519,6 +520,7 @@ INT_PTR CALLBACK TracerCallB(HWND hwndDlg, UINT uMsg, WPARAM wParam, LPARAM lPar
 				EndLoggingSequence();
 			ClearTraceLogBuf();
 			hTracer = 0;
+			FCEUI_SetDebugHookUser(DBGHOOK_TRACER, false);
 			EndDialog(hwndDlg,0);
 			break;
 		case WM_COMMAND:
@@ -82,6 +82,8 @@ extern void RefreshThrottleFPS();
 #else
 #ifdef __QT_DRIVER__
 #include "drivers/Qt/sdl.h"
+#elif defined(__HEADLESS_DRIVER__)
+#include "drivers/headless/headless.h"
 #else
 #include "drivers/sdl/sdl.h"
 #endif
@@ -296,6 +298,8 @@ static DECLFR(ANull) {
 	return(X.DB);
 }
 
+static void UpdatePageTracking(int32 start, int32 end);
+
 int AllocGenieRW(void) {
 	if (!(AReadG = (readfunc*)FCEU_malloc(0x8000 * sizeof(readfunc))))
 		return 0;
@@ -318,6 +322,7 @@ void FlushGenieRW(void) {
 		AReadG = NULL;
 		BWriteG = NULL;
 		RWWrap = 0;
+		UpdatePageTracking(0x8000, 0xFFFF);
 	}
 }
 
@@ -344,6 +349,7 @@ void SetReadHandler(int32 start, int32 end, readfunc func) {
 	else
 		for (x = end; x >= start; x--)
 			ARead[x] = func;
+	UpdatePageTracking(start, end);
 }
 
 writefunc GetWriteHandler(int32 a) {
@@ -369,6 +375,7 @@ void SetWriteHandler(int32 start, int32 end, writefunc func) {
 	else
 		for (x = end; x >= start; x--)
 			BWrite[x] = func;
+	UpdatePageTracking(start, end);
 }
 
 uint8 *RAM;
@@ -388,12 +395,27 @@ static void FreeBuffers() {
 
 uint8 PAL = 0;
 
+uint32 writeGeneration;
+uint32 pageWriteGen[0x100];
+//whether the page is plain memory whose stores are all stamped
+static uint8 pageTracked[0x100];
+
+//how each page can be read without calling its read handler (see FCEUI_MemPeekPtr)
+enum {
+	PAGEPEEK_NONE,
+	PAGEPEEK_RAM,	//read by ARAML/ARAMH, i.e. RAM[A & 0x7FF]
+	PAGEPEEK_CART	//read by CartBR/CartBROB, i.e. Page[A >> 11][A]
+};
+static uint8 pagePeek[0x100];
+
 static DECLFW(BRAML) {
 	RAM[A] = V;
+	FCEU_NoteWrite(A);
 }
 
 static DECLFW(BRAMH) {
 	RAM[A & 0x7FF] = V;
+	FCEU_NoteWrite(A & 0x7FF);
 }
 
 static DECLFR(ARAML) {
@@ -404,6 +426,93 @@ static DECLFR(ARAMH) {
 	return RAM[A & 0x7FF];
 }
 
+void FCEU_NoteWriteRange(uint32 start, uint32 end) {
+	for (uint32 p = start >> 8; p <= (end >> 8) && p < 0x100; p++)
+		pageWriteGen[p] = writeGeneration;
+}
+
+//a page is tracked when every address in it reads plain memory and stores through a
+//handler that stamps it, so its contents only change on a stamped write or bank switch
+static void UpdatePageTracking(int32 start, int32 end) {
+	FCEU_NoteWriteRange(start, end);
+	for (int32 p = start >> 8; p <= (end >> 8); p++) {
+		uint8 tracked = 1;
+		uint8 peek = (ARead[p << 8] == ARAML || ARead[p << 8] == ARAMH) ? PAGEPEEK_RAM : PAGEPEEK_CART;
+		for (int32 x = p << 8; x < ((p + 1) << 8); x++) {
+			readfunc r = ARead[x];
+			writefunc w = BWrite[x];
+			if ((r != ARAML && r != ARAMH && r != CartBR && r != CartBROB) ||
+			    (w != BRAML && w != BRAMH && w != CartBW && w != BNull))
+				tracked = 0;
+			if (peek == PAGEPEEK_RAM ? (r != ARAML && r != ARAMH) : (r != CartBR && r != CartBROB))
+				peek = PAGEPEEK_NONE;
+			if (!tracked && !peek)
+				break;
+		}
+		pageTracked[p] = tracked;
+		pagePeek[p] = peek;
+	}
+}
+
+uint8 *FCEUI_MemPeekPtr(uint16 A) {
+	switch (pagePeek[A >> 8]) {
+	case PAGEPEEK_RAM:
+		return &RAM[A & 0x7FF];
+	case PAGEPEEK_CART:
+		return Page[A >> 11] ? &Page[A >> 11][A] : NULL;
+	}
+	return NULL;
+}
+
+uint8 FCEUI_MemSafePeek(uint16 A) {
+	uint8 *p = FCEUI_MemPeekPtr(A);
+	uint8 ret;
+
+	if (p)
+		return *p;
+	//registers and mapper-handled memory: handlers skip their side effects in debugger reads
+	fceuindbg = 1;
+	ret = ARead[A](A);
+	fceuindbg = 0;
+	return ret;
+}
+
+void FCEUI_MemPeekBlock(uint16 A, uint8 *dest, uint32 len) {
+	while (len) {
+		uint32 count = 0x100 - (A & 0xFF);
+		uint8 *p = FCEUI_MemPeekPtr(A);
+
+		if (count > len)
+			count = len;
+		if (p)
+			memcpy(dest, p, count);
+		else
+			for (uint32 x = 0; x < count; x++)
+				dest[x] = FCEUI_MemSafePeek((uint16)(A + x));
+		A = (uint16)(A + count);
+		dest += count;
+		len -= count;
+	}
+}
+
+uint32 FCEUI_MemWriteGeneration(void) {
+	return writeGeneration++;
+}
+
+int FCEUI_MemChangedPages(uint32 gen, uint8 *changed) {
+	int count = 0;
+
+	for (int p = 0; p < 0x100; p++) {
+		uint32 g = pageWriteGen[p];
+		//RAM mirrors are stamped on the page they mirror
+		if (p < 0x20 && (int32)(pageWriteGen[p & 7] - g) > 0)
+			g = pageWriteGen[p & 7];
+		changed[p] = !pageTracked[p] || (int32)(g - gen) > 0;
+		count += changed[p];
+	}
+	return count;
+}
+
 
 void ResetGameLoaded(void) {
 	if (GameInfo) FCEU_CloseGame();
@@ -1610,4 +1719,6 @@ void FCEU_WriteRomByte(uint32 i, uint8 value) {
 		PRGptr[0][i - 16] = value;
 	else if (i < 16 + PRGsize[0] + CHRsize[0])
 		CHRptr[0][i - 16 - PRGsize[0]] = value;
+	//the byte may be mapped into any cartridge page
+	FCEU_NoteWriteRange(0x4000, 0xFFFF);
 }
@@ -81,6 +81,19 @@ void FCEU_WriteRomByte(uint32 i, uint8 value);
 extern readfunc ARead[0x10000];
 extern writefunc BWrite[0x10000];
 
+//CPU bus write tracking for tool windows: the write generation of the last store to
+//each 256-byte page (see FCEUI_MemChangedPages)
+extern uint32 writeGeneration;
+extern uint32 pageWriteGen[0x100];
+
+//stamps the 256-byte page of A with the current write generation; call it from
+//any handler that stores to memory so tool windows see the page as changed
+static INLINE void FCEU_NoteWrite(uint32 A) {
+	pageWriteGen[(A >> 8) & 0xFF] = writeGeneration;
+}
+//same for every page in [start,end], for bank switches and bulk loads
+void FCEU_NoteWriteRange(uint32 start, uint32 end);
+
 enum GI {
 	GI_RESETM2	=1,
 	GI_POWER =2,
@@ -25,6 +25,7 @@ enum LuaMemHookType
 	LUAMEMHOOK_COUNT
 };
 void CallRegisteredLuaMemHook(unsigned int address, int size, unsigned int value, LuaMemHookType hookType);
+int FCEU_LuaMemHooksActive();
 
 struct LuaSaveData
 {
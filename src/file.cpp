@@ -144,6 +144,7 @@ end:
 	fclose(ips);
 	EMUFILE_MEMORY* ms = new EMUFILE_MEMORY(buf,fp->size);
 	fp->SetStream(ms);
+	fp->patched = true;
 }
 
 std::string FCEU_MakeIpsFilename(FileBaseInfo fbi) {
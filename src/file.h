@@ -39,10 +39,12 @@ struct FCEUFILE {
 
 	//whether the file is contained in an archive
 	bool isArchive() { return archiveCount > 0; }
+	//whether an IPS patch was applied to the data
+	bool patched;
 
 	FCEUFILE()
 		: stream(0)
-		, archiveCount(-1), archiveIndex(0), size(0), mode(READ)
+		, archiveCount(-1), archiveIndex(0), size(0), patched(false), mode(READ)
 	{}
 
 	~FCEUFILE()
@@ -13,12 +13,254 @@
 #include <cmath>
 #include <cstdio>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FIR_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(_MSC_VER)
+#define FIR_AVX2
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+#elif defined(__ARM_NEON)
+#define FIR_NEON
+#include <arm_neon.h>
+#endif
+
+// The FIR tables are symmetric, so both dot products can walk the input forwards:
+// acc = sum((in[i]*coeffs[i])>>6) over the window, acc2 = the same over the window shifted by one.
+// Every implementation has to keep the per-term >>6 and the wrapping 32 bit sum to stay bit exact.
 static int32 sq2coeffs[SQ2NCOEFFS];
 static int32 coeffs[NCOEFFS];
 
 static uint32 mrindex;
 static uint32 mrratio;
 
+static void FIRDot_C(const int32 *in, const int32 *d, uint32 n, int32 *pacc, int32 *pacc2)
+{
+	int32 acc=0,acc2=0;
+	for(uint32 c=0;c<n;c++)
+	{
+		acc+=(in[c]*d[c])>>6;
+		acc2+=(in[c+1]*d[c])>>6;
+	}
+	*pacc=acc;
+	*pacc2=acc2;
+}
+
+#ifdef FIR_SSE2
+// SSE2 has no 32 bit mullo, the low halves of two 32x32->64 multiplies give the same bits
+static INLINE __m128i FIRMulLo_SSE2(__m128i a, __m128i b)
+{
+	__m128i even=_mm_mul_epu32(a,b);
+	__m128i odd=_mm_mul_epu32(_mm_srli_epi64(a,32),_mm_srli_epi64(b,32));
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even,_MM_SHUFFLE(0,0,2,0)),_mm_shuffle_epi32(odd,_MM_SHUFFLE(0,0,2,0)));
+}
+
+static INLINE int32 FIRHsum_SSE2(__m128i v)
+{
+	v=_mm_add_epi32(v,_mm_shuffle_epi32(v,_MM_SHUFFLE(1,0,3,2)));
+	v=_mm_add_epi32(v,_mm_shuffle_epi32(v,_MM_SHUFFLE(2,3,0,1)));
+	return _mm_cvtsi128_si32(v);
+}
+
+static void FIRDot_SSE2(const int32 *in, const int32 *d, uint32 n, int32 *pacc, int32 *pacc2)
+{
+	__m128i vacc=_mm_setzero_si128(),vacc2=_mm_setzero_si128();
+	uint32 c=0;
+	for(;c+4<=n;c+=4)
+	{
+		__m128i vd=_mm_loadu_si128((const __m128i*)(d+c));
+		__m128i v0=_mm_loadu_si128((const __m128i*)(in+c));
+		__m128i v1=_mm_loadu_si128((const __m128i*)(in+c+1));
+		vacc=_mm_add_epi32(vacc,_mm_srai_epi32(FIRMulLo_SSE2(v0,vd),6));
+		vacc2=_mm_add_epi32(vacc2,_mm_srai_epi32(FIRMulLo_SSE2(v1,vd),6));
+	}
+	int32 acc=FIRHsum_SSE2(vacc),acc2=FIRHsum_SSE2(vacc2);
+	for(;c<n;c++)
+	{
+		acc+=(in[c]*d[c])>>6;
+		acc2+=(in[c+1]*d[c])>>6;
+	}
+	*pacc=acc;
+	*pacc2=acc2;
+}
+#endif
+
+#ifdef FIR_AVX2
+#ifdef __GNUC__
+__attribute__((target("avx2")))
+#endif
+static void FIRDot_AVX2(const int32 *in, const int32 *d, uint32 n, int32 *pacc, int32 *pacc2)
+{
+	__m256i vacc=_mm256_setzero_si256(),vacc2=_mm256_setzero_si256();
+	uint32 c=0;
+	for(;c+8<=n;c+=8)
+	{
+		__m256i vd=_mm256_loadu_si256((const __m256i*)(d+c));
+		__m256i v0=_mm256_loadu_si256((const __m256i*)(in+c));
+		__m256i v1=_mm256_loadu_si256((const __m256i*)(in+c+1));
+		vacc=_mm256_add_epi32(vacc,_mm256_srai_epi32(_mm256_mullo_epi32(v0,vd),6));
+		vacc2=_mm256_add_epi32(vacc2,_mm256_srai_epi32(_mm256_mullo_epi32(v1,vd),6));
+	}
+	__m128i lo=_mm_add_epi32(_mm256_castsi256_si128(vacc),_mm256_extracti128_si256(vacc,1));
+	__m128i lo2=_mm_add_epi32(_mm256_castsi256_si128(vacc2),_mm256_extracti128_si256(vacc2,1));
+	lo=_mm_add_epi32(lo,_mm_shuffle_epi32(lo,_MM_SHUFFLE(1,0,3,2)));
+	lo=_mm_add_epi32(lo,_mm_shuffle_epi32(lo,_MM_SHUFFLE(2,3,0,1)));
+	lo2=_mm_add_epi32(lo2,_mm_shuffle_epi32(lo2,_MM_SHUFFLE(1,0,3,2)));
+	lo2=_mm_add_epi32(lo2,_mm_shuffle_epi32(lo2,_MM_SHUFFLE(2,3,0,1)));
+	int32 acc=_mm_cvtsi128_si32(lo),acc2=_mm_cvtsi128_si32(lo2);
+	for(;c<n;c++)
+	{
+		acc+=(in[c]*d[c])>>6;
+		acc2+=(in[c+1]*d[c])>>6;
+	}
+	*pacc=acc;
+	*pacc2=acc2;
+}
+
+static bool FIRHaveAVX2(void)
+{
+#ifdef _MSC_VER
+	int regs[4];
+	__cpuid(regs,0);
+	if(regs[0]<7) return false;
+	__cpuid(regs,1);
+	// OS must save the ymm registers
+	if(!(regs[2]&(1<<27)) || (_xgetbv(0)&6)!=6) return false;
+	__cpuidex(regs,7,0);
+	return (regs[1]&(1<<5))!=0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+#ifdef FIR_NEON
+static void FIRDot_NEON(const int32 *in, const int32 *d, uint32 n, int32 *pacc, int32 *pacc2)
+{
+	int32x4_t vacc=vdupq_n_s32(0),vacc2=vdupq_n_s32(0);
+	uint32 c=0;
+	for(;c+4<=n;c+=4)
+	{
+		int32x4_t vd=vld1q_s32(d+c);
+		vacc=vaddq_s32(vacc,vshrq_n_s32(vmulq_s32(vld1q_s32(in+c),vd),6));
+		vacc2=vaddq_s32(vacc2,vshrq_n_s32(vmulq_s32(vld1q_s32(in+c+1),vd),6));
+	}
+	int32 acc=vgetq_lane_s32(vacc,0)+vgetq_lane_s32(vacc,1)+vgetq_lane_s32(vacc,2)+vgetq_lane_s32(vacc,3);
+	int32 acc2=vgetq_lane_s32(vacc2,0)+vgetq_lane_s32(vacc2,1)+vgetq_lane_s32(vacc2,2)+vgetq_lane_s32(vacc2,3);
+	for(;c<n;c++)
+	{
+		acc+=(in[c]*d[c])>>6;
+		acc2+=(in[c+1]*d[c])>>6;
+	}
+	*pacc=acc;
+	*pacc2=acc2;
+}
+#endif
+
+typedef void (*FIRDotFunc)(const int32 *in, const int32 *d, uint32 n, int32 *pacc, int32 *pacc2);
+
+static FIRDotFunc FIRSelect(void)
+{
+	FIRDotFunc f;
+#if defined(FIR_SSE2)
+	f=FIRDot_SSE2;
+#ifdef FIR_AVX2
+	if(FIRHaveAVX2())
+		f=FIRDot_AVX2;
+#endif
+#elif defined(FIR_NEON)
+	f=FIRDot_NEON;
+#else
+	f=FIRDot_C;
+#endif
+	return f;
+}
+
+static FIRDotFunc FIRDot = FIRSelect();
+
+// Runs every dot product compiled into this build (and supported by this CPU)
+// against FIRDot_C over all coefficient tables at both sound qualities, with
+// random, full scale and alternating input.  Returns the number of mismatches;
+// fceux-headless --check-fir runs it as a ctest.
+int FCEU_FIRCheck(void)
+{
+	static const int32 *tabs[2][6]={
+		{C44100NTSC,C44100PAL,C48000NTSC,C48000PAL,C96000NTSC,C96000PAL},
+		{SQ2C44100NTSC,SQ2C44100PAL,SQ2C48000NTSC,SQ2C48000PAL,SQ2C96000NTSC,SQ2C96000PAL}};
+	static const char *tabnames[6]={"44100ntsc","44100pal","48000ntsc","48000pal","96000ntsc","96000pal"};
+	static int32 d[SQ2NCOEFFS];
+	static int32 in[SQ2NCOEFFS+8];
+	struct { const char *name; FIRDotFunc f; } variants[3];
+	int nvariants=0,bad=0,checks=0;
+
+#ifdef FIR_SSE2
+	variants[nvariants].name="SSE2"; variants[nvariants++].f=FIRDot_SSE2;
+#endif
+#ifdef FIR_AVX2
+	if(FIRHaveAVX2())
+	{
+		variants[nvariants].name="AVX2"; variants[nvariants++].f=FIRDot_AVX2;
+	}
+#endif
+#ifdef FIR_NEON
+	variants[nvariants].name="NEON"; variants[nvariants++].f=FIRDot_NEON;
+#endif
+
+	for(int q=0;q<2;q++)
+	{
+		uint32 n=q?SQ2NCOEFFS:NCOEFFS;
+
+		for(int t=0;t<6;t++)
+		{
+			//symmetric expansion, as MakeFilters does
+			for(uint32 x=0;x<n>>1;x++)
+				d[x]=d[n-1-x]=tabs[q][t][x];
+
+			for(int pattern=0;pattern<3;pattern++)
+			{
+				uint32 seed=0x2A5A1D3Bu+t;
+
+				for(uint32 c=0;c<n+8;c++)
+				{
+					seed=seed*1664525+1013904223;
+					if(pattern==0)
+						in[c]=(int32)(seed>>16)-32768;
+					else if(pattern==1)	//largest sums: every term has the sign of its tap
+						in[c]=(c<n && d[c]<0)?-32768:32767;
+					else
+						in[c]=(c&1)?-32768:32767;
+				}
+
+				//a few window offsets, so unaligned loads are covered too
+				for(uint32 o=0;o<8;o++)
+				{
+					int32 ref,ref2;
+					FIRDot_C(in+o,d,n-(o?1:0),&ref,&ref2);
+
+					for(int v=0;v<nvariants;v++)
+					{
+						int32 acc,acc2;
+						variants[v].f(in+o,d,n-(o?1:0),&acc,&acc2);
+						checks++;
+						if(acc!=ref || acc2!=ref2)
+						{
+							bad++;
+							fprintf(stderr,"FIR check: %s differs from C on %s %s quality, pattern %d, offset %u\n",
+								variants[v].name,tabnames[t],q?"high":"normal",pattern,o);
+						}
+					}
+				}
+			}
+		}
+	}
+	printf("FIR check: %d compiled variant(s), %d comparisons, %d mismatches\n",nvariants,checks,bad);
+	return bad;
+}
+
 void SexyFilter2(int32 *in, int32 count)
 {
  #ifdef moo
@@ -109,15 +351,9 @@ int32 NeoFilterSound(int32 *in, int32 *out, uint32 inlen, int32 *leftover)
 	if(FSettings.soundq==2)
         for(x=mrindex;x<max;x+=mrratio)
         {
-			int32 acc=0,acc2=0;
-			unsigned int c;
-			int32 *S,*D;
+			int32 acc,acc2;
 
-			for(c=SQ2NCOEFFS,S=&in[(x>>16)-SQ2NCOEFFS],D=sq2coeffs;c;c--,D++)
-			{
-				acc+=(S[c]**D)>>6;
-				acc2+=(S[1+c]**D)>>6;
-			}
+			FIRDot(&in[(x>>16)-SQ2NCOEFFS+1],sq2coeffs,SQ2NCOEFFS,&acc,&acc2);
 
 			acc=((int64)acc*(65536-(x&65535))+(int64)acc2*(x&65535))>>(16+11);
 			*out=acc;
@@ -127,15 +363,9 @@ int32 NeoFilterSound(int32 *in, int32 *out, uint32 inlen, int32 *leftover)
 	else
 		for(x=mrindex;x<max;x+=mrratio)
 		{
-			int32 acc=0,acc2=0;
-			unsigned int c;
-			const int32 *S,*D;
+			int32 acc,acc2;
 
-			for(c=NCOEFFS,S=&in[(x>>16)-NCOEFFS],D=coeffs;c;c--,D++)
-			{
-				acc+=(S[c]**D)>>6;
-				acc2+=(S[1+c]**D)>>6;
-			}
+			FIRDot(&in[(x>>16)-NCOEFFS+1],coeffs,NCOEFFS,&acc,&acc2);
 
 			acc=((int64)acc*(65536-(x&65535))+(int64)acc2*(x&65535))>>(16+11);
 			*out=acc;
@@ -39,6 +39,10 @@
 #include "driver.h"
 #include "input.h"
 
+#ifdef RETROACHIEVEMENTS
+#include "retroachievements.h"
+#endif
+
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -807,6 +811,10 @@ int iNESLoad(const char *name, FCEUFILE *fp, int OverwriteVidMode) {
 	uint64 partialmd5 = 0;
 	const char* mappername = "Not Listed";
 
+#ifdef RETROACHIEVEMENTS
+	RA_ClearNESImageHash();
+#endif
+
 	if (FCEU_fread(&head, 1, 16, fp) != 16 || memcmp(&head, "NES\x1A", 4))
 		return LOADER_INVALID_FORMAT;
 	
@@ -1059,6 +1067,11 @@ init_ok:
 	GameInfo->mappernum = MapperNo;
 	FCEU_LoadGameSave(&iNESCart);
 
+#ifdef RETROACHIEVEMENTS
+	// hash the image while it's still open, so the game can be identified without loading it again
+	RA_HashNESImage(fp);
+#endif
+
 	strcpy(LoadedRomFName, name); //bbit edited: line added
 
 	// Extract Filename only. Should account for Windows/Unix this way.
@@ -30,6 +30,7 @@
 #include "movie.h"
 #include "driver.h"
 #include "cheat.h"
+#include "cart.h"
 #include "x6502.h"
 #include "ppu.h"
 #include "utils/xstring.h"
@@ -51,7 +52,7 @@ extern char FileBase[];
 extern TASEDITOR_LUA taseditor_lua;
 #endif
 
-#ifdef __SDL__
+#if defined(__SDL__) || defined(__HEADLESS_DRIVER__)
 
 #ifdef __QT_DRIVER__
 #include "drivers/Qt/sdl.h"
@@ -1627,6 +1628,318 @@ static int ppu_readbyterange(lua_State *L) {
 	return 1;
 }
 
+// Memory views and buffers.
+//
+// memory.view(region) returns a live, read-only view of "ram", "sram", "chr" or "oam";
+// memory.buffer(size) returns a zeroed buffer that belongs to the script.
+// Both are the same userdata type and share the methods below, which work on the
+// underlying bytes directly so scripts can diff, hash and search memory every frame
+// without going through the per-address read path or building Lua strings.
+// Offsets are 0-based and relative to the start of the view or buffer.
+//   #b                                       size in bytes
+//   b[i]                                     byte at offset i (assignable in buffers)
+//   b:read([offset[, size]])                 copy of the bytes as a string
+//   b:hash([offset[, size]])                 CRC32 of the bytes
+//   b:compare(other[, offset[, size]])       offset of the first byte differing from other, or nil
+//   b:find(bytes[, offset])                  offset of the first occurrence of a string or byte, or nil
+//   buf:copy(source[, offset[, size[, dest]]])  copy source bytes into a buffer without allocating
+enum LuaMemoryRegion
+{
+	LUAMEMREGION_BUFFER,
+	LUAMEMREGION_RAM,
+	LUAMEMREGION_SRAM,
+	LUAMEMREGION_CHR,
+	LUAMEMREGION_OAM,
+};
+
+struct LuaMemoryBuffer
+{
+	int region;
+	uint32 size;
+	uint8 data[1]; // the bytes of a buffer; views read the emulator's memory instead
+};
+
+static const char *memoryBufferType = "FCEU.MemoryBuffer";
+
+// Returns the bytes at offset and, in avail, how many of them are contiguous.
+// SRAM and CHR follow the current banks, so they are walked a page at a time.
+static const uint8 *MemoryBufferSpan(const LuaMemoryBuffer *b, uint32 offset, uint32 *avail)
+{
+	static const uint8 unmapped[0x800] = {0};
+	uint32 a;
+
+	switch(b->region)
+	{
+	case LUAMEMREGION_RAM:
+		*avail = b->size - offset;
+		return RAM + offset;
+	case LUAMEMREGION_OAM:
+		*avail = b->size - offset;
+		return SPRAM + offset;
+	case LUAMEMREGION_SRAM:
+		a = 0x6000 + offset;
+		*avail = std::min<uint32>(0x800 - (a & 0x7FF), b->size - offset);
+		return Page[a >> 11] ? Page[a >> 11] + a : unmapped;
+	case LUAMEMREGION_CHR:
+		a = offset;
+		*avail = std::min<uint32>(0x400 - (a & 0x3FF), b->size - offset);
+		return VPage[a >> 10] + a;
+	default:
+		*avail = b->size - offset;
+		return b->data + offset;
+	}
+}
+
+static LuaMemoryBuffer *CheckMemoryBuffer(lua_State *L, int idx)
+{
+	return (LuaMemoryBuffer *)luaL_checkudata(L, idx, memoryBufferType);
+}
+
+// Reads the optional [offset[, size]] arguments at idx, clamping size to the end of b.
+static void CheckMemoryBufferRange(lua_State *L, int idx, const LuaMemoryBuffer *b, uint32 *offset, uint32 *size)
+{
+	int o = luaL_optinteger(L, idx, 0);
+	luaL_argcheck(L, o >= 0 && (uint32)o <= b->size, idx, "offset out of range");
+	int s = luaL_optinteger(L, idx + 1, b->size - o);
+	luaL_argcheck(L, s >= 0, idx + 1, "negative size");
+	*offset = o;
+	*size = std::min<uint32>(s, b->size - o);
+}
+
+static void MemoryBufferCopy(const LuaMemoryBuffer *b, uint32 offset, uint32 size, uint8 *dst)
+{
+	while(size)
+	{
+		uint32 n;
+		const uint8 *src = MemoryBufferSpan(b, offset, &n);
+		n = std::min(n, size);
+		memmove(dst, src, n);
+		dst += n;
+		offset += n;
+		size -= n;
+	}
+}
+
+static int memory_view(lua_State *L)
+{
+	const char *name = luaL_checkstring(L, 1);
+	int region;
+	uint32 size;
+
+	if      (!stricmp(name, "ram"))  { region = LUAMEMREGION_RAM;  size = 0x800; }
+	else if (!stricmp(name, "sram")) { region = LUAMEMREGION_SRAM; size = 0x2000; }
+	else if (!stricmp(name, "chr"))  { region = LUAMEMREGION_CHR;  size = 0x2000; }
+	else if (!stricmp(name, "oam"))  { region = LUAMEMREGION_OAM;  size = 0x100; }
+	else return luaL_argerror(L, 1, "expected \"ram\", \"sram\", \"chr\" or \"oam\"");
+
+	LuaMemoryBuffer *b = (LuaMemoryBuffer *)lua_newuserdata(L, sizeof(LuaMemoryBuffer));
+	b->region = region;
+	b->size = size;
+	luaL_getmetatable(L, memoryBufferType);
+	lua_setmetatable(L, -2);
+	return 1;
+}
+
+static int memory_buffer(lua_State *L)
+{
+	int size = luaL_checkinteger(L, 1);
+	luaL_argcheck(L, size >= 0, 1, "negative size");
+
+	LuaMemoryBuffer *b = (LuaMemoryBuffer *)lua_newuserdata(L, offsetof(LuaMemoryBuffer, data) + std::max(size, 1));
+	b->region = LUAMEMREGION_BUFFER;
+	b->size = size;
+	memset(b->data, 0, std::max(size, 1));
+	luaL_getmetatable(L, memoryBufferType);
+	lua_setmetatable(L, -2);
+	return 1;
+}
+
+static int memorybuffer_len(lua_State *L)
+{
+	lua_pushinteger(L, CheckMemoryBuffer(L, 1)->size);
+	return 1;
+}
+
+static int memorybuffer_index(lua_State *L)
+{
+	LuaMemoryBuffer *b = CheckMemoryBuffer(L, 1);
+
+	if(lua_type(L, 2) == LUA_TNUMBER)
+	{
+		int offset = lua_tointeger(L, 2);
+		if(offset < 0 || (uint32)offset >= b->size)
+			return 0;
+		uint32 n;
+		lua_pushinteger(L, *MemoryBufferSpan(b, offset, &n));
+		return 1;
+	}
+
+	// method lookup in the table held as upvalue
+	lua_pushvalue(L, 2);
+	lua_rawget(L, lua_upvalueindex(1));
+	return 1;
+}
+
+static int memorybuffer_newindex(lua_State *L)
+{
+	LuaMemoryBuffer *b = CheckMemoryBuffer(L, 1);
+	int offset = luaL_checkinteger(L, 2);
+	if(b->region != LUAMEMREGION_BUFFER)
+		return luaL_error(L, "memory views are read-only");
+	luaL_argcheck(L, offset >= 0 && (uint32)offset < b->size, 2, "offset out of range");
+	b->data[offset] = luaL_checkinteger(L, 3);
+	return 0;
+}
+
+static int memorybuffer_read(lua_State *L)
+{
+	LuaMemoryBuffer *b = CheckMemoryBuffer(L, 1);
+	uint32 offset, size;
+	CheckMemoryBufferRange(L, 2, b, &offset, &size);
+
+	uint32 n;
+	const uint8 *src = MemoryBufferSpan(b, offset, &n);
+	if(n >= size)
+	{
+		lua_pushlstring(L, (const char *)src, size);
+	}
+	else
+	{
+		std::vector<uint8> tmp(size);
+		MemoryBufferCopy(b, offset, size, &tmp[0]);
+		lua_pushlstring(L, (const char *)&tmp[0], size);
+	}
+	return 1;
+}
+
+static int memorybuffer_hash(lua_State *L)
+{
+	LuaMemoryBuffer *b = CheckMemoryBuffer(L, 1);
+	uint32 offset, size;
+	CheckMemoryBufferRange(L, 2, b, &offset, &size);
+
+	uint32 crc = 0;
+	while(size)
+	{
+		uint32 n;
+		const uint8 *src = MemoryBufferSpan(b, offset, &n);
+		n = std::min(n, size);
+		crc = CalcCRC32(crc, (uint8 *)src, n);
+		offset += n;
+		size -= n;
+	}
+	lua_pushnumber(L, crc);
+	return 1;
+}
+
+static int memorybuffer_compare(lua_State *L)
+{
+	LuaMemoryBuffer *a = CheckMemoryBuffer(L, 1);
+	LuaMemoryBuffer *b = CheckMemoryBuffer(L, 2);
+	uint32 offset, size;
+	CheckMemoryBufferRange(L, 3, a, &offset, &size);
+	size = offset < b->size ? std::min(size, b->size - offset) : 0;
+
+	while(size)
+	{
+		uint32 na, nb;
+		const uint8 *pa = MemoryBufferSpan(a, offset, &na);
+		const uint8 *pb = MemoryBufferSpan(b, offset, &nb);
+		uint32 n = std::min(std::min(na, nb), size);
+		if(memcmp(pa, pb, n))
+		{
+			while(*pa == *pb)
+				pa++, pb++, offset++;
+			lua_pushinteger(L, offset);
+			return 1;
+		}
+		offset += n;
+		size -= n;
+	}
+	lua_pushnil(L);
+	return 1;
+}
+
+static int memorybuffer_find(lua_State *L)
+{
+	LuaMemoryBuffer *b = CheckMemoryBuffer(L, 1);
+	size_t len;
+	const char *needle;
+	char c;
+
+	if(lua_type(L, 2) == LUA_TNUMBER)
+	{
+		c = (char)lua_tointeger(L, 2);
+		needle = &c;
+		len = 1;
+	}
+	else
+		needle = luaL_checklstring(L, 2, &len);
+
+	uint32 offset, size;
+	CheckMemoryBufferRange(L, 3, b, &offset, &size);
+
+	uint32 n;
+	const uint8 *data = MemoryBufferSpan(b, offset, &n);
+	std::vector<uint8> tmp;
+	if(n < size)
+	{
+		tmp.resize(size);
+		MemoryBufferCopy(b, offset, size, &tmp[0]);
+		data = &tmp[0];
+	}
+
+	const uint8 *end = data + size;
+	const uint8 *hit = std::search(data, end, (const uint8 *)needle, (const uint8 *)needle + len);
+	if(len && hit != end)
+		lua_pushinteger(L, offset + (hit - data));
+	else
+		lua_pushnil(L);
+	return 1;
+}
+
+static int memorybuffer_copy(lua_State *L)
+{
+	LuaMemoryBuffer *dst = CheckMemoryBuffer(L, 1);
+	LuaMemoryBuffer *src = CheckMemoryBuffer(L, 2);
+	if(dst->region != LUAMEMREGION_BUFFER)
+		return luaL_error(L, "memory views are read-only");
+
+	uint32 offset, size;
+	CheckMemoryBufferRange(L, 3, src, &offset, &size);
+	int dest = luaL_optinteger(L, 5, 0);
+	luaL_argcheck(L, dest >= 0 && (uint32)dest <= dst->size, 5, "offset out of range");
+	size = std::min(size, dst->size - dest);
+
+	MemoryBufferCopy(src, offset, size, dst->data + dest);
+	return 0;
+}
+
+static const struct luaL_reg memorybuffer_methods[] = {
+	{"read", memorybuffer_read},
+	{"hash", memorybuffer_hash},
+	{"compare", memorybuffer_compare},
+	{"find", memorybuffer_find},
+	{"copy", memorybuffer_copy},
+	{NULL,NULL}
+};
+
+static void RegisterMemoryBufferType(lua_State *L)
+{
+	luaL_newmetatable(L, memoryBufferType);
+	lua_newtable(L);
+	luaL_register(L, NULL, memorybuffer_methods);
+	lua_pushcclosure(L, memorybuffer_index, 1);
+	lua_setfield(L, -2, "__index");
+	lua_pushcfunction(L, memorybuffer_newindex);
+	lua_setfield(L, -2, "__newindex");
+	lua_pushcfunction(L, memorybuffer_len);
+	lua_setfield(L, -2, "__len");
+	lua_pushstring(L, memoryBufferType);
+	lua_setfield(L, -2, "__metatable");
+	lua_pop(L, 1);
+}
+
 static inline bool isalphaorunderscore(char c)
 {
 	return isalpha(c) || c == '_';
@@ -2111,178 +2424,91 @@ void HandleCallbackError(lua_State* L)
 
 
 // the purpose of this structure is to provide a way of
-// QUICKLY determining whether a memory address range has a hook associated with it,
+// QUICKLY determining whether a memory address has a hook associated with it,
 // with a bias toward fast rejection because the majority of addresses will not be hooked.
 // (it must not use any part of Lua or perform any per-script operations,
 //  otherwise it would definitely be too slow.)
-// calculating the regions when a hook is added/removed may be slow,
+// one bit per CPU address, plus one byte per 256-byte page that is nonzero if any
+// address in the page is hooked, so the common case is a single byte load.
+// the callback of each hooked address is kept as a registry reference, so a hit
+// goes straight to the function without looking up the hook table by name.
+// rebuilding this when a hook is added/removed may be slow,
 // but this is an intentional tradeoff to obtain a high speed of checking during later execution
-struct TieredRegion
+struct MemHookMap
 {
-	template<unsigned int maxGap>
-	struct Region
-	{
-		struct Island
-		{
-			unsigned int start;
-			unsigned int end;
-#ifdef NEED_MINGW_HACKS
-			bool Contains(unsigned int address, int size) const { return address < end && address+size > start; }
-#else
-			__forceinline bool Contains(unsigned int address, int size) const { return address < end && address+size > start; }
-#endif
-		};
-		std::vector<Island> islands;
-
-		void Calculate(const std::vector<unsigned int>& bytes)
-		{
-			islands.clear();
-
-			unsigned int lastEnd = ~0;
+	uint8 pages[0x100];
+	uint64 bits[0x10000 / 64];
+	std::vector<int> refs; // per address, LUA_NOREF if unhooked; empty when nothing is hooked
 
-			std::vector<unsigned int>::const_iterator iter = bytes.begin();
-			std::vector<unsigned int>::const_iterator end = bytes.end();
-			for(; iter != end; ++iter)
-			{
-				unsigned int addr = *iter;
-				if(addr < lastEnd || addr > lastEnd + (long long)maxGap)
-				{
-					islands.push_back(Island());
-					islands.back().start = addr;
-				}
-				islands.back().end = addr+1;
-				lastEnd = addr+1;
-			}
-		}
-		bool Contains(unsigned int address, int size) const
-		{
-			for (size_t i = 0; i != islands.size(); ++i)
-			{
-				if (islands[i].Contains(address, size))
-					return true;
-			}
-			return false;
-		}
-	};
-
-	Region<0xFFFFFFFF> broad;
-	Region<0x1000> mid;
-	Region<0> narrow;
-
-	void Calculate(std::vector<unsigned int>& bytes)
+	__forceinline bool Contains(unsigned int address) const
 	{
-		std::sort(bytes.begin(), bytes.end());
-
-		broad.Calculate(bytes);
-		mid.Calculate(bytes);
-		narrow.Calculate(bytes);
+		return address < 0x10000 && pages[address >> 8] && ((bits[address >> 6] >> (address & 63)) & 1);
 	}
 
-	TieredRegion()
+	void Clear()
 	{
-		std::vector <unsigned int> temp;
-		Calculate(temp);
-	}
-
-	__forceinline int NotEmpty()
-	{
-		return broad.islands.size();
-	}
-
-	// note: it is illegal to call this if NotEmpty() returns 0
-	__forceinline bool Contains(unsigned int address, int size)
-	{
-		return broad.islands[0].Contains(address,size) &&
-		       mid.Contains(address,size) &&
-			   narrow.Contains(address,size);
+		memset(pages, 0, sizeof(pages));
+		memset(bits, 0, sizeof(bits));
+		refs.clear();
 	}
 };
-TieredRegion hookedRegions [LUAMEMHOOK_COUNT];
+static MemHookMap hookedRegions [LUAMEMHOOK_COUNT];
 
 
 static void CalculateMemHookRegions(LuaMemHookType hookType)
 {
-	std::vector<unsigned int> hookedBytes;
-//	std::map<int, LuaContextInfo*>::iterator iter = luaContextInfo.begin();
-//	std::map<int, LuaContextInfo*>::iterator end = luaContextInfo.end();
-//	while(iter != end)
-//	{
-//		LuaContextInfo& info = *iter->second;
-		if(/*info.*/ numMemHooks)
+	MemHookMap& hooks = hookedRegions[hookType];
+
+	// drop the references taken by the previous pass
+	if(L)
+	{
+		for(size_t i = 0; i != hooks.refs.size(); ++i)
+			if(hooks.refs[i] != LUA_NOREF)
+				luaL_unref(L, LUA_REGISTRYINDEX, hooks.refs[i]);
+	}
+	hooks.Clear();
+
+	if(/*info.*/ numMemHooks && L)
+	{
+		lua_settop(L, 0);
+		lua_getfield(L, LUA_REGISTRYINDEX, luaMemHookTypeStrings[hookType]);
+		lua_pushnil(L);
+		while(lua_next(L, -2))
 		{
-//			lua_State* L = info.L;
-			if(L)
+			// the CPU bus is 16 bits wide, so hooks above it can never fire
+			unsigned int addr = lua_tointeger(L, -2);
+			if(lua_isfunction(L, -1) && addr < 0x10000)
 			{
-				lua_settop(L, 0);
-				lua_getfield(L, LUA_REGISTRYINDEX, luaMemHookTypeStrings[hookType]);
-				lua_pushnil(L);
-				while(lua_next(L, -2))
-				{
-					if(lua_isfunction(L, -1))
-					{
-						unsigned int addr = lua_tointeger(L, -2);
-						hookedBytes.push_back(addr);
-					}
-					lua_pop(L, 1);
-				}
-				lua_settop(L, 0);
+				if(hooks.refs.empty())
+					hooks.refs.resize(0x10000, LUA_NOREF);
+				lua_pushvalue(L, -1);
+				hooks.refs[addr] = luaL_ref(L, LUA_REGISTRYINDEX);
+				hooks.pages[addr >> 8] = 1;
+				hooks.bits[addr >> 6] |= (uint64)1 << (addr & 63);
 			}
+			lua_pop(L, 1);
 		}
-//		++iter;
-//	}
-	hookedRegions[hookType].Calculate(hookedBytes);
+		lua_settop(L, 0);
+	}
 }
 
-static void CallRegisteredLuaMemHook_LuaMatch(unsigned int address, int size, unsigned int value, LuaMemHookType hookType)
+static void CallRegisteredLuaMemHook_LuaMatch(int ref, unsigned int address, int size, unsigned int value)
 {
-//	std::map<int, LuaContextInfo*>::iterator iter = luaContextInfo.begin();
-//	std::map<int, LuaContextInfo*>::iterator end = luaContextInfo.end();
-//	while(iter != end)
-//	{
-//		LuaContextInfo& info = *iter->second;
-		if(/*info.*/ numMemHooks)
-		{
-//			lua_State* L = info.L;
-			if(L/* && !info.panic*/)
-			{
-#ifdef USE_INFO_STACK
-				infoStack.insert(infoStack.begin(), &info);
-				struct Scope { ~Scope(){ infoStack.erase(infoStack.begin()); } } scope;
-#endif
-				lua_settop(L, 0);
-				lua_getfield(L, LUA_REGISTRYINDEX, luaMemHookTypeStrings[hookType]);
-				for(unsigned int i = address; i != address+size; i++)
-				{
-					lua_rawgeti(L, -1, i);
-					if (lua_isfunction(L, -1))
-					{
-						bool wasRunning = (luaRunning!=0) /*info.running*/;
-						luaRunning /*info.running*/ = true;
-						//RefreshScriptSpeedStatus();
-						lua_pushinteger(L, address);
-						lua_pushinteger(L, size);
-						lua_pushinteger(L, value);
-						int errorcode = lua_pcall(L, 3, 0, 0);
-						luaRunning /*info.running*/ = wasRunning;
-						//RefreshScriptSpeedStatus();
-						if (errorcode)
-						{
-							HandleCallbackError(L);
-							//int uid = iter->first;
-							//HandleCallbackError(L,info,uid,true);
-						}
-						break;
-					}
-					else
-					{
-						lua_pop(L,1);
-					}
-				}
-				lua_settop(L, 0);
-			}
-		}
-//		++iter;
-//	}
+	if(/*info.*/ numMemHooks && L)
+	{
+		lua_settop(L, 0);
+		lua_rawgeti(L, LUA_REGISTRYINDEX, ref);
+		bool wasRunning = (luaRunning!=0) /*info.running*/;
+		luaRunning /*info.running*/ = true;
+		lua_pushinteger(L, address);
+		lua_pushinteger(L, size);
+		lua_pushinteger(L, value);
+		int errorcode = lua_pcall(L, 3, 0, 0);
+		luaRunning /*info.running*/ = wasRunning;
+		if (errorcode)
+			HandleCallbackError(L);
+		lua_settop(L, 0);
+	}
 }
 void CallRegisteredLuaMemHook(unsigned int address, int size, unsigned int value, LuaMemHookType hookType)
 {
@@ -2290,16 +2516,23 @@ void CallRegisteredLuaMemHook(unsigned int address, int size, unsigned int value
 	// I suggest timing a large number of calls to this function in Release if you change anything in here,
 	// before and after, because even the most innocent change can make it become 30% to 400% slower.
 	// a good amount to test is: 100000000 calls with no hook set, and another 100000000 with a hook set.
-	// (on my system that consistently took 200 ms total in the former case and 350 ms total in the latter case)
-	if(hookedRegions[hookType].NotEmpty())
+	const MemHookMap& hooks = hookedRegions[hookType];
+	for(unsigned int i = address; i != address+size; i++)
 	{
-		//if((hookType <= LUAMEMHOOK_EXEC) && (address >= 0xE00000))
-		//	address |= 0xFF0000; // account for mirroring of RAM
-		if(hookedRegions[hookType].Contains(address, size))
-			CallRegisteredLuaMemHook_LuaMatch(address, size, value, hookType); // something has hooked this specific address
+		if(hooks.Contains(i))
+		{
+			// something has hooked this specific address; the first hooked byte wins
+			CallRegisteredLuaMemHook_LuaMatch(hooks.refs[i], address, size, value);
+			break;
+		}
 	}
 }
 
+int FCEU_LuaMemHooksActive()
+{
+	return numMemHooks != 0;
+}
+
 void CallRegisteredLuaFunctions(LuaCallID calltype)
 {
 	assert((unsigned int)calltype < (unsigned int)LUACALL_COUNT);
@@ -3127,7 +3360,9 @@ static int savestate_save(lua_State *L) {
 	// Save states are very expensive. They take time.
 	numTries--;
 
-	FCEUSS_SaveMS(ss->data,Z_NO_COMPRESSION);
+	// anonymous states only live in memory and can use the raw snapshot
+	if (!ss->anonymous || !FCEUSS_SaveRaw(ss->data))
+		FCEUSS_SaveMS(ss->data,Z_NO_COMPRESSION);
 	ss->data->fseek(0,SEEK_SET);
 	return 0;
 }
@@ -3159,7 +3394,7 @@ static int savestate_load(lua_State *L) {
 		luaL_error(L, "Invalid savestate.load data");
 		return 0;
 	} */
-	if (FCEUSS_LoadFP(ss->data,SSLOADPARAM_NOBACKUP))
+	if ((ss->data && FCEUSS_LoadRaw(ss->data)) || FCEUSS_LoadFP(ss->data,SSLOADPARAM_NOBACKUP))
 		ss->data->fseek(0,SEEK_SET);
 
 	return 0;
@@ -6093,6 +6328,8 @@ static const struct luaL_reg memorylib [] = {
 	{"legacywritebyte", legacymemory_writebyte},
 	{"getregister", memory_getregister},
 	{"setregister", memory_setregister},
+	{"view", memory_view},
+	{"buffer", memory_buffer},
 
 	// memory hooks
 	{"registerwrite", memory_registerwrite},
@@ -6437,6 +6674,7 @@ int FCEU_LoadLuaCode(const char *filename, const char *arg)
 		luaL_register(L, "emu", emulib); // added for better cross-emulator compatibility
 		luaL_register(L, "FCEU", emulib); // kept for backward compatibility
 		luaL_register(L, "memory", memorylib);
+		RegisterMemoryBufferType(L);
 		luaL_register(L, "ppu", ppulib);
 		luaL_register(L, "rom", romlib);
 		luaL_register(L, "joypad", joypadlib);
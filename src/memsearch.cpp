@@ -0,0 +1,492 @@
+#include "memsearch.h"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MEMSEARCH_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+namespace FCEU
+{
+
+static INLINE int PopCount(uint64 v)
+{
+#ifdef __GNUC__
+	return __builtin_popcountll(v);
+#else
+	v = v - ((v >> 1) & 0x5555555555555555ULL);
+	v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+	v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return (int)((v * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+// v must be non-zero
+static INLINE int LowestBit(uint64 v)
+{
+#if defined(__GNUC__)
+	return __builtin_ctzll(v);
+#elif defined(_MSC_VER) && defined(_M_X64)
+	unsigned long n;
+	_BitScanForward64(&n, v);
+	return (int)n;
+#else
+	int n = 0;
+	while(!(v & 1))
+	{
+		v >>= 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
+static bool Compare(int op, int64 x, int64 y, int64 p)
+{
+	switch(op)
+	{
+	case MemSearch::OP_LT: return x < y;
+	case MemSearch::OP_GT: return x > y;
+	case MemSearch::OP_LE: return x <= y;
+	case MemSearch::OP_GE: return x >= y;
+	case MemSearch::OP_EQ: return x == y;
+	case MemSearch::OP_NE: return x != y;
+	case MemSearch::OP_DIFFBY: return x - y == p || y - x == p;
+	case MemSearch::OP_SUBBY: return x - y == p;
+	case MemSearch::OP_MODIS: return p && x % p == y;
+	}
+	return false;
+}
+
+#ifdef MEMSEARCH_SSE2
+// Values at addr..addr+15 as 1, 2 or 4 vectors of 8, 16 or 32 bit lanes.  The
+// bias flips the sign bit of unsigned values so the signed compares order them.
+static INLINE void LoadLanes(const uint8 *buf, uint32 addr, int size, __m128i bias, __m128i *v)
+{
+	__m128i b0 = _mm_loadu_si128((const __m128i*)(buf + addr));
+
+	if(size == 1)
+	{
+		v[0] = _mm_xor_si128(b0, bias);
+		return;
+	}
+
+	__m128i b1 = _mm_loadu_si128((const __m128i*)(buf + addr + 1));
+
+	if(size == 2)
+	{
+		v[0] = _mm_xor_si128(_mm_unpacklo_epi8(b0, b1), bias);
+		v[1] = _mm_xor_si128(_mm_unpackhi_epi8(b0, b1), bias);
+		return;
+	}
+
+	__m128i b2 = _mm_loadu_si128((const __m128i*)(buf + addr + 2));
+	__m128i b3 = _mm_loadu_si128((const __m128i*)(buf + addr + 3));
+	__m128i lo01 = _mm_unpacklo_epi8(b0, b1), hi01 = _mm_unpackhi_epi8(b0, b1);
+	__m128i lo23 = _mm_unpacklo_epi8(b2, b3), hi23 = _mm_unpackhi_epi8(b2, b3);
+
+	v[0] = _mm_xor_si128(_mm_unpacklo_epi16(lo01, lo23), bias);
+	v[1] = _mm_xor_si128(_mm_unpackhi_epi16(lo01, lo23), bias);
+	v[2] = _mm_xor_si128(_mm_unpacklo_epi16(hi01, hi23), bias);
+	v[3] = _mm_xor_si128(_mm_unpackhi_epi16(hi01, hi23), bias);
+}
+
+static INLINE __m128i CmpGt(int size, __m128i a, __m128i b)
+{
+	if(size == 1) return _mm_cmpgt_epi8(a, b);
+	if(size == 2) return _mm_cmpgt_epi16(a, b);
+	return _mm_cmpgt_epi32(a, b);
+}
+
+static INLINE __m128i CmpEq(int size, __m128i a, __m128i b)
+{
+	if(size == 1) return _mm_cmpeq_epi8(a, b);
+	if(size == 2) return _mm_cmpeq_epi16(a, b);
+	return _mm_cmpeq_epi32(a, b);
+}
+
+static INLINE __m128i CompareLanes(int op, int size, __m128i x, __m128i y)
+{
+	const __m128i ones = _mm_set1_epi32(-1);
+
+	switch(op)
+	{
+	case MemSearch::OP_LT: return CmpGt(size, y, x);
+	case MemSearch::OP_GT: return CmpGt(size, x, y);
+	case MemSearch::OP_LE: return _mm_xor_si128(CmpGt(size, x, y), ones);
+	case MemSearch::OP_GE: return _mm_xor_si128(CmpGt(size, y, x), ones);
+	case MemSearch::OP_EQ: return CmpEq(size, x, y);
+	default: return _mm_xor_si128(CmpEq(size, x, y), ones);
+	}
+}
+
+// One bit per address from the lane masks
+static INLINE uint32 MaskBits(int size, const __m128i *m)
+{
+	if(size == 1)
+		return _mm_movemask_epi8(m[0]);
+	if(size == 2)
+		return _mm_movemask_epi8(_mm_packs_epi16(m[0], m[1]));
+	return _mm_movemask_epi8(_mm_packs_epi16(_mm_packs_epi32(m[0], m[1]), _mm_packs_epi32(m[2], m[3])));
+}
+#endif
+
+// Bit n set if byte n of the two 64 byte blocks differs
+static INLINE uint64 ChangedBytes(const uint8 *a, const uint8 *b)
+{
+	uint64 m = 0;
+#ifdef MEMSEARCH_SSE2
+	for(int q = 0; q < 4; q++)
+	{
+		__m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(a + q * 16)), _mm_loadu_si128((const __m128i*)(b + q * 16)));
+		m |= (uint64)(~_mm_movemask_epi8(eq) & 0xFFFF) << (q * 16);
+	}
+#else
+	for(int n = 0; n < 64; n++)
+		if(a[n] != b[n])
+			m |= 1ULL << n;
+#endif
+	return m;
+}
+
+MemSearch::MemSearch(void)
+	: size(1), isSigned(false), cur(SIZE + PAD), prev(SIZE + PAD), last(SIZE + PAD), cand(WORDS)
+{
+}
+
+void MemSearch::setValueType(int size, bool isSigned)
+{
+	this->size = (size == 4 || size == 2) ? size : 1;
+	this->isSigned = isSigned;
+}
+
+uint32 MemSearch::readValue(const uint8 *buf, uint32 addr) const
+{
+	if(size == 1)
+		return buf[addr];
+	if(size == 2)
+		return buf[addr] | (buf[addr + 1] << 8);
+	return buf[addr] | (buf[addr + 1] << 8) | (buf[addr + 2] << 16) | ((uint32)buf[addr + 3] << 24);
+}
+
+int64 MemSearch::toInt(uint32 v) const
+{
+	if(!isSigned)
+		return v;
+	if(size == 1)
+		return (int8)v;
+	if(size == 2)
+		return (int16)v;
+	return (int32)v;
+}
+
+void MemSearch::clearCandidates(void)
+{
+	memset(&cand[0], 0, WORDS * sizeof(uint64));
+}
+
+void MemSearch::addCandidates(uint32 start, uint32 end, uint32 step)
+{
+	if(end > SIZE)
+		end = SIZE;
+	if(!step)
+		step = 1;
+	for(uint32 a = start; a < end; a += step)
+		cand[a >> 6] |= 1ULL << (a & 63);
+}
+
+void MemSearch::removeCandidates(uint32 start, uint32 end)
+{
+	if(end > SIZE)
+		end = SIZE;
+	for(uint32 a = start; a < end; a++)
+		cand[a >> 6] &= ~(1ULL << (a & 63));
+}
+
+uint32 MemSearch::count(uint32 start, uint32 end) const
+{
+	uint32 c = 0;
+
+	if(end > SIZE)
+		end = SIZE;
+	while(start < end)
+	{
+		uint32 w = start >> 6;
+		uint64 bits = cand[w] >> (start & 63);
+		uint32 n = 64 - (start & 63);
+
+		if(n > end - start)
+		{
+			n = end - start;
+			bits &= (1ULL << n) - 1;
+		}
+		c += PopCount(bits);
+		start += n;
+	}
+	return c;
+}
+
+int MemSearch::next(uint32 addr) const
+{
+	if(addr >= SIZE)
+		return -1;
+
+	uint32 w = addr >> 6;
+	uint64 bits = cand[w] & (~0ULL << (addr & 63));
+
+	while(!bits)
+	{
+		if(++w >= WORDS)
+			return -1;
+		bits = cand[w];
+	}
+	return (w << 6) + LowestBit(bits);
+}
+
+int MemSearch::nth(uint32 n) const
+{
+	for(uint32 w = 0; w < WORDS; w++)
+	{
+		uint64 bits = cand[w];
+		uint32 c = PopCount(bits);
+
+		if(n >= c)
+		{
+			n -= c;
+			continue;
+		}
+		while(n--)
+			bits &= bits - 1;
+		return (w << 6) + LowestBit(bits);
+	}
+	return -1;
+}
+
+void MemSearch::filterScalar(Op op, const uint8 *xb, const uint8 *yb, int64 value, int64 p)
+{
+	for(uint32 w = 0; w < WORDS; w++)
+	{
+		uint64 bits = cand[w], keep = bits;
+
+		while(bits)
+		{
+			int b = LowestBit(bits);
+			uint32 a = (w << 6) + b;
+			int64 y = yb ? toInt(readValue(yb, a)) : value;
+
+			bits &= bits - 1;
+			if(!Compare(op, toInt(readValue(xb, a)), y, p))
+				keep &= ~(1ULL << b);
+		}
+		cand[w] = keep;
+	}
+}
+
+void MemSearch::filter(Op op, Operand x, Operand y, int64 value, int64 p)
+{
+	const uint8 *xb = (x == PREVIOUS) ? &prev[0] : &cur[0];
+	const uint8 *yb = (y == VALUE) ? NULL : (y == PREVIOUS) ? &prev[0] : &cur[0];
+
+	if(op > OP_NE)
+	{
+		filterScalar(op, xb, yb, value, p);
+		return;
+	}
+
+	if(!yb)
+	{
+		int64 lo = isSigned ? -(1LL << (size * 8 - 1)) : 0;
+		int64 hi = isSigned ? (1LL << (size * 8 - 1)) - 1 : (1LL << (size * 8)) - 1;
+
+		// Every value compares the same way against a constant outside the range
+		if(value < lo || value > hi)
+		{
+			if(!Compare(op, lo, value, p))
+				clearCandidates();
+			return;
+		}
+	}
+
+#ifdef MEMSEARCH_SSE2
+	__m128i bias, yv[4];
+	int lanes = size == 1 ? 1 : size == 2 ? 2 : 4;
+
+	if(size == 1)
+		bias = _mm_set1_epi8(isSigned ? 0 : (char)0x80);
+	else if(size == 2)
+		bias = _mm_set1_epi16(isSigned ? 0 : (short)0x8000);
+	else
+		bias = _mm_set1_epi32(isSigned ? 0 : (int)0x80000000);
+
+	if(!yb)
+	{
+		__m128i v;
+
+		if(size == 1)
+			v = _mm_set1_epi8((char)value);
+		else if(size == 2)
+			v = _mm_set1_epi16((short)value);
+		else
+			v = _mm_set1_epi32((int)value);
+		for(int l = 0; l < 4; l++)
+			yv[l] = _mm_xor_si128(v, bias);
+	}
+
+	for(uint32 w = 0; w < WORDS; w++)
+	{
+		uint64 bits = cand[w];
+
+		if(!bits)
+			continue;
+
+		for(uint32 q = 0; q < 4; q++)
+		{
+			if(!((bits >> (q * 16)) & 0xFFFF))
+				continue;
+
+			uint32 a = (w << 6) + q * 16;
+			__m128i xv[4], m[4];
+
+			LoadLanes(xb, a, size, bias, xv);
+			if(yb)
+				LoadLanes(yb, a, size, bias, yv);
+			for(int l = 0; l < lanes; l++)
+				m[l] = CompareLanes(op, size, xv[l], yv[l]);
+			bits &= ~((uint64)(~MaskBits(size, m) & 0xFFFF) << (q * 16));
+		}
+		cand[w] = bits;
+	}
+#else
+	filterScalar(op, xb, yb, value, p);
+#endif
+}
+
+void MemSearch::filterAddress(Op op, int64 y, int64 p)
+{
+	for(uint32 w = 0; w < WORDS; w++)
+	{
+		uint64 bits = cand[w], keep = bits;
+
+		while(bits)
+		{
+			int b = LowestBit(bits);
+
+			bits &= bits - 1;
+			if(!Compare(op, (w << 6) + b, y, p))
+				keep &= ~(1ULL << b);
+		}
+		cand[w] = keep;
+	}
+}
+
+void MemSearch::filterChanges(Op op, int64 y, int64 p)
+{
+	for(uint32 w = 0; w < WORDS; w++)
+	{
+		uint64 bits = cand[w], keep = bits;
+
+		while(bits)
+		{
+			int b = LowestBit(bits);
+
+			bits &= bits - 1;
+			if(!Compare(op, changeCount((w << 6) + b), y, p))
+				keep &= ~(1ULL << b);
+		}
+		cand[w] = keep;
+	}
+}
+
+void MemSearch::update(void)
+{
+	if(changes.empty())
+		changes.resize(SIZE);
+
+	for(uint32 w = 0; w < WORDS; w++)
+	{
+		uint64 bits = cand[w];
+
+		if(!bits)
+			continue;
+
+		uint32 a = w << 6;
+		uint64 m = ChangedBytes(&cur[a], &last[a]), wide = m;
+
+		// A value also changes when one of its upper bytes, up to 3 past the block, does
+		if(size > 1)
+		{
+			uint64 tail = 0;
+
+			for(int k = 0; k < size - 1; k++)
+				if(cur[a + 64 + k] != last[a + 64 + k])
+					tail |= 1ULL << k;
+			for(int k = 1; k < size; k++)
+				wide |= (m >> k) | (tail << (64 - k));
+		}
+
+		bits &= wide;
+		while(bits)
+		{
+			changes[a + LowestBit(bits)]++;
+			bits &= bits - 1;
+		}
+	}
+	memcpy(&last[0], &cur[0], SIZE + PAD);
+}
+
+void MemSearch::clearChangeCounts(void)
+{
+	if(!changes.empty())
+		memset(&changes[0], 0, SIZE * sizeof(uint32));
+}
+
+void MemSearch::reset(void)
+{
+	memcpy(&prev[0], &cur[0], SIZE + PAD);
+	memcpy(&last[0], &cur[0], SIZE + PAD);
+	clearChangeCounts();
+	undoSteps.clear();
+}
+
+void MemSearch::commitPrevious(void)
+{
+	for(uint32 w = 0; w < WORDS; w++)
+	{
+		uint64 bits = cand[w];
+		uint32 a = w << 6;
+
+		if(bits == ~0ULL)
+			memcpy(&prev[a], &cur[a], 64 + size - 1);
+		else while(bits)
+		{
+			uint32 b = a + LowestBit(bits);
+
+			memcpy(&prev[b], &cur[b], size);
+			bits &= bits - 1;
+		}
+	}
+}
+
+void MemSearch::pushUndo(void)
+{
+	undoSteps.push_back(UndoStep());
+	undoSteps.back().cand = cand;
+	undoSteps.back().prev = prev;
+}
+
+bool MemSearch::undo(void)
+{
+	if(undoSteps.empty())
+		return false;
+
+	cand.swap(undoSteps.back().cand);
+	prev.swap(undoSteps.back().prev);
+	undoSteps.pop_back();
+	return true;
+}
+
+} // namespace FCEU
@@ -0,0 +1,109 @@
+#ifndef _FCEU_MEMSEARCH_H
+#define _FCEU_MEMSEARCH_H
+
+#include "types.h"
+
+#include <vector>
+
+namespace FCEU
+{
+
+// Candidate search over a snapshot of the CPU address space, shared by the
+// cheat search API and the RAM search windows.  The caller copies the regions
+// it searches into current(); the surviving addresses are kept as a bitset and
+// the relational filters compare 16 addresses at a time (SSE2 when available).
+// Each recorded step keeps the candidates and previous values so it can be undone.
+class MemSearch
+{
+public:
+	enum Op
+	{
+		OP_LT,
+		OP_GT,
+		OP_LE,
+		OP_GE,
+		OP_EQ,
+		OP_NE,
+		OP_DIFFBY,	// x - y == p || y - x == p
+		OP_SUBBY,	// x - y == p
+		OP_MODIS	// p && x % p == y
+	};
+
+	enum Operand
+	{
+		CURRENT,	// value in current()
+		PREVIOUS,	// value in previous()
+		VALUE		// the constant passed to filter()
+	};
+
+	MemSearch(void);
+
+	// 1, 2 or 4 byte little endian values
+	void setValueType(int size, bool isSigned);
+	int valueSize(void) const { return size; }
+
+	uint8 *current(void) { return &cur[0]; }
+	const uint8 *previous(void) const { return &prev[0]; }
+	uint32 currentValue(uint32 addr) const { return readValue(&cur[0], addr); }
+	uint32 previousValue(uint32 addr) const { return readValue(&prev[0], addr); }
+
+	void clearCandidates(void);
+	void addCandidates(uint32 start, uint32 end, uint32 step);	// [start, end)
+	void removeCandidates(uint32 start, uint32 end);
+	bool isCandidate(uint32 addr) const { return (cand[addr >> 6] >> (addr & 63)) & 1; }
+	uint32 count(void) const { return count(0, SIZE); }
+	uint32 count(uint32 start, uint32 end) const;
+	int next(uint32 addr) const;	// first candidate >= addr, or -1
+	int nth(uint32 n) const;		// n-th candidate in address order, or -1
+
+	// Keep the candidates for which "x op y" holds
+	void filter(Op op, Operand x, Operand y, int64 value = 0, int64 p = 0);
+	void filterAddress(Op op, int64 y, int64 p = 0);
+	void filterChanges(Op op, int64 y, int64 p = 0);
+
+	// Counts candidate value changes since the last update()
+	void update(void);
+	uint32 changeCount(uint32 addr) const { return changes.empty() ? 0 : changes[addr]; }
+	void clearChangeCounts(void);
+
+	// previous = current everywhere; drops the undo steps and change counts
+	void reset(void);
+	// previous = current for the bytes of the remaining candidates
+	void commitPrevious(void);
+
+	void pushUndo(void);
+	bool undo(void);
+	size_t undoDepth(void) const { return undoSteps.size(); }
+
+private:
+	enum
+	{
+		SIZE = 0x10000,
+		WORDS = SIZE / 64,
+		PAD = 32	// vector loads of 4 byte values run up to 19 bytes past an address
+	};
+
+	struct UndoStep
+	{
+		std::vector<uint64> cand;
+		std::vector<uint8> prev;
+	};
+
+	uint32 readValue(const uint8 *buf, uint32 addr) const;
+	int64 toInt(uint32 v) const;
+	void filterScalar(Op op, const uint8 *xb, const uint8 *yb, int64 value, int64 p);
+
+	int size;
+	bool isSigned;
+
+	std::vector<uint8> cur;
+	std::vector<uint8> prev;
+	std::vector<uint8> last;
+	std::vector<uint64> cand;
+	std::vector<uint32> changes;
+	std::vector<UndoStep> undoSteps;
+};
+
+} // namespace FCEU
+
+#endif
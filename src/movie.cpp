@@ -119,10 +119,13 @@ MovieData currMovieData;
 MovieData defaultMovieData;
 int currRerecordCount; // Keep the global value
 
+#define MOVIE_INPUT_HASH_SEED 0xCBF29CE484222325ULL
+
 char lagcounterbuf[32] = {0};
 
 void MovieData::clearRecordRange(int start, int len)
 {
+	invalidateInputHash(start);
 	for(int i=0;i<len;i++)
 	{
 		records[i+start].clear();
@@ -133,6 +136,7 @@ void MovieData::eraseRecords(int at, int frames)
 {
 	if (at < (int)records.size())
 	{
+		invalidateInputHash(at);
 		if (frames == 1)
 		{
 			// erase 1 frame
@@ -154,6 +158,7 @@ void MovieData::insertEmpty(int at, int frames)
 		records.resize(records.size() + frames);
 	} else
 	{
+		invalidateInputHash(at);
 		records.insert(records.begin() + at, frames, MovieRecord());
 	}
 }
@@ -162,6 +167,7 @@ void MovieData::cloneRegion(int at, int frames)
 {
 	if (at < 0) return;
 
+	invalidateInputHash(at);
 	records.insert(records.begin() + at, frames, MovieRecord());
 
 	for(int i = 0; i < frames; i++)
@@ -225,6 +231,31 @@ void MovieRecord::Clone(MovieRecord& sourceRec)
 	this->commands = sourceRec.commands;
 }
 
+//FNV-1a over the same fields Compare() looks at
+uint64 MovieRecord::hash(uint64 seed)
+{
+	uint8 buf[4 + 1 + 2 * 12];
+	uint8* ptr = buf;
+	memcpy(ptr, &joysticks, 4); ptr += 4;
+	*ptr++ = commands;
+	for (int i = 0; i < 2; i++)
+	{
+		*ptr++ = zappers[i].x;
+		*ptr++ = zappers[i].y;
+		*ptr++ = zappers[i].b;
+		*ptr++ = zappers[i].bogo;
+		for (int j = 0; j < 8; j++)
+			*ptr++ = (uint8)(zappers[i].zaphit >> (j * 8));
+	}
+
+	for (size_t i = 0; i < sizeof(buf); i++)
+	{
+		seed ^= buf[i];
+		seed *= 0x100000001B3ULL;
+	}
+	return seed;
+}
+
 const char MovieRecord::mnemonics[8] = {'A','B','S','T','U','D','L','R'};
 
 void MovieRecord::dumpJoy(EMUFILE* os, uint8 joystate)
@@ -245,90 +276,115 @@ void MovieRecord::dumpJoy(EMUFILE* os, uint8 joystate)
 	}
 }
 
-void MovieRecord::parseJoy(EMUFILE* is, uint8& joystate)
+//extracts a decimal uint the way templateIntegerDecFromIstream does: skips anything before the digits
+//and stops at the first non-digit after them
+template<typename T> static const uint8* parseDec(const uint8* p, const uint8* end, T& ret)
+{
+	ret = 0;
+	for (; p < end && (*p < '0' || *p > '9'); p++) ;
+	for (; p < end && *p >= '0' && *p <= '9'; p++)
+		ret = ret * 10 + (*p - '0');
+	return p;
+}
+
+//eats one separator; like fgetc, nothing is consumed at the end of the input
+static inline const uint8* parseSkip(const uint8* p, const uint8* end)
+{
+	return p < end ? p + 1 : p;
+}
+
+const uint8* MovieRecord::parseJoy(const uint8* p, const uint8* end, uint8& joystate)
 {
-	char buf[8];
-	is->fread(buf,8);
 	joystate = 0;
 	for(int i=0;i<8;i++)
 	{
 		joystate <<= 1;
-		joystate |= ((buf[i]=='.'||buf[i]==' ')?0:1);
+		if (p < end)
+		{
+			joystate |= ((*p=='.'||*p==' ')?0:1);
+			p++;
+		}
 	}
+	return p;
 }
 
-void MovieRecord::parse(MovieData* md, EMUFILE* is)
+const uint8* MovieRecord::parse(MovieData* md, const uint8* p, const uint8* end)
 {
 	//by the time we get in here, the initial pipe has already been extracted
+	unsigned int val;
 
 	//extract the commands
-	commands = uint32DecFromIstream(is);
-	//*is >> commands;
-	is->fgetc(); //eat the pipe
+	p = parseDec(p, end, val);
+	commands = val;
+	p = parseSkip(p, end); //eat the pipe
 
 	//a special case: if fourscore is enabled, parse four gamepads
 	if(md->fourscore)
 	{
-		parseJoy(is,joysticks[0]); is->fgetc(); //eat the pipe
-		parseJoy(is,joysticks[1]); is->fgetc(); //eat the pipe
-		parseJoy(is,joysticks[2]); is->fgetc(); //eat the pipe
-		parseJoy(is,joysticks[3]); is->fgetc(); //eat the pipe
+		for(int i=0;i<4;i++)
+		{
+			p = parseJoy(p, end, joysticks[i]);
+			p = parseSkip(p, end); //eat the pipe
+		}
 	}
 	else
 	{
 		for(int port=0;port<2;port++)
 		{
 			if(md->ports[port] == SI_GAMEPAD)
-				parseJoy(is, joysticks[port]);
+				p = parseJoy(p, end, joysticks[port]);
 			else if(md->ports[port] == SI_ZAPPER)
 			{
-				zappers[port].x = uint32DecFromIstream(is);
-				zappers[port].y = uint32DecFromIstream(is);
-				zappers[port].b = uint32DecFromIstream(is);
-				zappers[port].bogo = uint32DecFromIstream(is);
-				zappers[port].zaphit = uint64DecFromIstream(is);
+				p = parseDec(p, end, val); zappers[port].x = val;
+				p = parseDec(p, end, val); zappers[port].y = val;
+				p = parseDec(p, end, val); zappers[port].b = val;
+				p = parseDec(p, end, val); zappers[port].bogo = val;
+				p = parseDec(p, end, zappers[port].zaphit); //a uint64 cycle timestamp
 			}
 
-			is->fgetc(); //eat the pipe
+			p = parseSkip(p, end); //eat the pipe
 		}
 	}
 
 	//(no fcexp data is logged right now)
-	is->fgetc(); //eat the pipe
+	p = parseSkip(p, end); //eat the pipe
 
 	//should be left at a newline
+	return p;
 }
 
 
-bool MovieRecord::parseBinary(MovieData* md, EMUFILE* is)
+//the caller makes sure a whole record is there (see LoadFM2_binarychunk)
+const uint8* MovieRecord::parseBinary(MovieData* md, const uint8* p)
 {
-	commands = (uint8)is->fgetc();
-
-	//check for eof
-	if(is->eof()) return false;
+	commands = *p++;
 
 	if(md->fourscore)
 	{
-		is->fread((char*)&joysticks,4);
+		memcpy(&joysticks, p, 4);
+		p += 4;
 	}
 	else
 	{
 		for(int port=0;port<2;port++)
 		{
 			if(md->ports[port] == SI_GAMEPAD)
-				joysticks[port] = (uint8)is->fgetc();
+				joysticks[port] = *p++;
 			else if(md->ports[port] == SI_ZAPPER)
 			{
-				zappers[port].x = (uint8)is->fgetc();
-				zappers[port].y = (uint8)is->fgetc();
-				zappers[port].b = (uint8)is->fgetc();
-				zappers[port].bogo = (uint8)is->fgetc();
-				read64le(&zappers[port].zaphit,is);
+				zappers[port].x = *p++;
+				zappers[port].y = *p++;
+				zappers[port].b = *p++;
+				zappers[port].bogo = *p++;
+				zappers[port].zaphit = 0;
+				for(int i=7;i>=0;i--)
+					zappers[port].zaphit = (zappers[port].zaphit << 8) | p[i];
+				p += 8;
 			}
 		}
 	}
 
-	return true;
+	return p;
 }
 
 
@@ -419,9 +475,38 @@ MovieData::MovieData()
 
 void MovieData::truncateAt(int frame)
 {
+	invalidateInputHash(frame);
 	records.resize(frame);
 }
 
+uint64 MovieData::getInputHash(int frames)
+{
+	int checkpoint = frames / MOVIE_INPUT_HASH_INTERVAL;
+
+	//extend the checkpoints up to the requested length
+	while ((int)inputHashes.size() < checkpoint)
+	{
+		int frame = (int)inputHashes.size() * MOVIE_INPUT_HASH_INTERVAL;
+		uint64 hash = inputHashes.empty() ? MOVIE_INPUT_HASH_SEED : inputHashes.back();
+		for (int end = frame + MOVIE_INPUT_HASH_INTERVAL; frame < end; frame++)
+			hash = records[frame].hash(hash);
+		inputHashes.push_back(hash);
+	}
+
+	uint64 hash = checkpoint ? inputHashes[checkpoint - 1] : MOVIE_INPUT_HASH_SEED;
+	for (int frame = checkpoint * MOVIE_INPUT_HASH_INTERVAL; frame < frames; frame++)
+		hash = records[frame].hash(hash);
+	return hash;
+}
+
+void MovieData::invalidateInputHash(int frame)
+{
+	//checkpoints ending after the changed frame are stale
+	size_t valid = frame > 0 ? frame / MOVIE_INPUT_HASH_INTERVAL : 0;
+	if (inputHashes.size() > valid)
+		inputHashes.resize(valid);
+}
+
 void MovieData::installValue(std::string& key, std::string& val)
 {
 	//todo - use another config system, or drive this from a little data structure. because this is gross
@@ -604,7 +689,8 @@ bool FCEUMOV_Mode(int modemask)
 	return FCEUMOV_Mode((EMOVIEMODE)modemask);
 }
 
-static void LoadFM2_binarychunk(MovieData& movieData, EMUFILE* fp, int size)
+//decodes the binary records in [p, end), returns where they stopped
+static const uint8* LoadFM2_binarychunk(MovieData& movieData, const uint8* p, const uint8* end)
 {
 	int recordsize = 1; //1 for the command
 	if(movieData.fourscore)
@@ -621,15 +707,8 @@ static void LoadFM2_binarychunk(MovieData& movieData, EMUFILE* fp, int size)
 		}
 	}
 
-	//find out how much remains in the file
-	int curr = fp->ftell();
-	fp->fseek(0,SEEK_END);
-	int end = fp->ftell();
-	int flen = end-curr;
-	fp->fseek(curr,SEEK_SET);
-
-	//the amount todo is the min of the limiting size we received and the remaining contents of the file
-	int todo = std::min<int>(size, flen);
+	//the buffer already holds the min of the limiting size we received and the remaining contents of the file
+	int todo = (int)(end - p);
 
 	int numRecords = todo/recordsize;
 	if (movieData.loadFrameCount!=-1 && movieData.loadFrameCount<numRecords)
@@ -638,8 +717,17 @@ static void LoadFM2_binarychunk(MovieData& movieData, EMUFILE* fp, int size)
 	movieData.records.resize(numRecords);
 	for(int i=0;i<numRecords;i++)
 	{
-		movieData.records[i].parseBinary(&movieData,fp);
+		p = movieData.records[i].parseBinary(&movieData,p);
 	}
+	return p;
+}
+
+//reads on from fp until buffer holds len bytes (or the file ends)
+static void LoadFM2_fill(EMUFILE* fp, std::vector<uint8>& buffer, size_t len)
+{
+	size_t have = buffer.size();
+	buffer.resize(len);
+	buffer.resize(have + fp->fread(&buffer[have], len - have));
 }
 
 //yuck... another custom text parser.
@@ -649,6 +737,7 @@ bool LoadFM2(MovieData& movieData, EMUFILE* fp, int size, bool stopAfterHeader)
 	movieData.binaryFlag = false;
 	// Non-TASEditor projects consume until EOF
 	movieData.loadFrameCount = -1;
+	movieData.invalidateInputHash(0);
 
 	std::ios::pos_type curr = fp->ftell();
 
@@ -673,6 +762,21 @@ bool LoadFM2(MovieData& movieData, EMUFILE* fp, int size, bool stopAfterHeader)
 	if(memcmp(buf,"version 3",9))
 		return false;
 
+	//parse from memory: the movie (or, for stopAfterHeader, as much of it as the header needs) is read in one go.
+	//fp is left where the parser stopped, as the chunks after a savestate's movie are read from the same file.
+	int start = fp->ftell();
+	fp->fseek(0,SEEK_END);
+	int remaining = fp->ftell() - start;
+	fp->fseek(start,SEEK_SET);
+	int avail = std::max(0, std::min(size, remaining));
+	std::vector<uint8> buffer;
+	LoadFM2_fill(fp, buffer, stopAfterHeader ? std::min(avail, 4096) : avail);
+	size_t pos = 0;
+
+	//one record per line
+	if (!stopAfterHeader)
+		movieData.records.reserve(movieData.records.size() + std::count(buffer.begin(), buffer.end(), '\n'));
+
 	std::string key,value;
 	enum {
 		NEWLINE, KEY, SEPARATOR, VALUE, RECORD, COMMENT, SUBTITLE
@@ -682,20 +786,26 @@ bool LoadFM2(MovieData& movieData, EMUFILE* fp, int size, bool stopAfterHeader)
 	int c;
 	for(;;)
 	{
-		if(size--<=0) goto bail;
-		c = fp->fgetc();
-		if(c == -1)
-			goto bail;
+		if(pos == buffer.size() && (int)pos < avail)
+			//the header goes on past what has been read so far
+			LoadFM2_fill(fp, buffer, std::min<size_t>(pos * 2, avail));
+		if((int)pos >= avail || pos == buffer.size()) goto bail;
+		c = buffer[pos++];
 		iswhitespace = (c==' '||c=='\t');
 		isrecchar = (c=='|');
 		isnewline = (c==10||c==13);
 		if(isrecchar && movieData.binaryFlag && !stopAfterHeader)
 		{
-			LoadFM2_binarychunk(movieData, fp, size);
+			const uint8* data = buffer.data();
+			pos = LoadFM2_binarychunk(movieData, data + pos, data + avail) - data;
+			fp->fseek(start + (int)pos, SEEK_SET);
 			return true;
 		} else if (isnewline && static_cast<size_t>(movieData.loadFrameCount) == movieData.records.size())
+		{
 			// exit prematurely if loaded the specified amound of records
+			fp->fseek(start + (int)pos, SEEK_SET);
 			return true;
+		}
 		switch(state)
 		{
 		case NEWLINE:
@@ -711,13 +821,17 @@ bool LoadFM2(MovieData& movieData, EMUFILE* fp, int size, bool stopAfterHeader)
 		case RECORD:
 			{
 				dorecord:
-				if (stopAfterHeader) return true;
-				int currcount = movieData.records.size();
-				movieData.records.resize(currcount+1);
-				int preparse = fp->ftell();
-				movieData.records[currcount].parse(&movieData, fp);
-				int postparse = fp->ftell();
-				size -= (postparse-preparse);
+				if (stopAfterHeader)
+				{
+					fp->fseek(start + (int)pos, SEEK_SET);
+					return true;
+				}
+				//the last record may run past the limiting size, the parser only stops at the end of the file
+				if (buffer.size() - pos < 1024 && (int)buffer.size() < remaining)
+					LoadFM2_fill(fp, buffer, remaining);
+				const uint8* data = buffer.data();
+				movieData.records.push_back(MovieRecord());
+				pos = movieData.records.back().parse(&movieData, data + pos, data + buffer.size()) - data;
 				state = NEWLINE;
 				break;
 			}
@@ -757,6 +871,7 @@ bool LoadFM2(MovieData& movieData, EMUFILE* fp, int size, bool stopAfterHeader)
 		if(bail) break;
 	}
 
+	fp->fseek(start + (int)pos, SEEK_SET);
 	return true;
 }
 
@@ -1002,6 +1117,8 @@ bool MovieData::loadSaveramFrom(std::vector<uint8>* buf)
 
 		ms.fread(currCartInfo->SaveGame[i].bufptr, len);
 	}
+	//the battery RAM can be mapped anywhere in cartridge space
+	FCEU_NoteWriteRange(0x4000, 0xFFFF);
 
 	return true;
 }
@@ -1296,10 +1413,12 @@ void FCEUMOV_AddInputState()
 			switch (movieRecordMode)
 			{
 			case MOVIE_RECORD_MODE_OVERWRITE:
+				currMovieData.invalidateInputHash(currFrameCounter);
 				currMovieData.records[currFrameCounter].Clone(mr);
 				break;
 			case MOVIE_RECORD_MODE_INSERT:
 				//FIXME: this could be very insufficient
+				currMovieData.invalidateInputHash(currFrameCounter);
 				currMovieData.records.insert(currMovieData.records.begin() + currFrameCounter, mr);
 				break;
 			//case MOVIE_RECORD_MODE_TRUNCATE:
@@ -1430,10 +1549,9 @@ int CheckTimelines(MovieData& stateMovie, MovieData& currMovie)
 
 static bool load_successful = false;
 
-bool FCEUMOV_ReadState(EMUFILE* is, uint32 size)
+//savestates can't be loaded in read+write mode for some movies; switch those to read-only first
+static void CheckReadWriteStateLoad()
 {
-	load_successful = false;
-
 	if (!movie_readonly)
 	{
 		if (currMovieData.loadFrameCount >= 0)
@@ -1455,6 +1573,13 @@ bool FCEUMOV_ReadState(EMUFILE* is, uint32 size)
 			movie_readonly = true;
 		}
 	}
+}
+
+bool FCEUMOV_ReadState(EMUFILE* is, uint32 size)
+{
+	load_successful = false;
+
+	CheckReadWriteStateLoad();
 
 	MovieData tempMovieData = MovieData();
 	std::ios::pos_type curr = is->ftell();
@@ -1630,6 +1755,165 @@ bool FCEUMOV_ReadState(EMUFILE* is, uint32 size)
 	return true;
 }
 
+// Savestates kept in memory (see FCEUSS_SaveMS) reference the current movie instead of embedding its input log.
+// The reference holds the movie GUID and length, the savestate frame, and input hashes (see MovieData::getInputHash):
+// of the whole log, of the log up to the savestate frame, and at every MOVIE_INPUT_HASH_INTERVAL frames before that.
+// Loading it follows the same rules as FCEUMOV_ReadState, using the hashes in place of CheckTimelines.
+int FCEUMOV_WriteStateRef(EMUFILE* os)
+{
+	if(movieMode != MOVIEMODE_RECORD && movieMode != MOVIEMODE_PLAY && movieMode != MOVIEMODE_FINISHED)
+		return 0;
+
+	int start = os->ftell();
+	int length = currMovieData.getNumRecords();
+	int end = std::min(currFrameCounter, length);
+	uint64 fullHash = currMovieData.getInputHash(length);
+	uint64 prefixHash = currMovieData.getInputHash(end);
+	uint32 checkpoints = end / MOVIE_INPUT_HASH_INTERVAL;
+
+	os->fwrite(currMovieData.guid.data, 16);
+	write32le(length, os);
+	write32le(currFrameCounter, os);
+	write64le(fullHash, os);
+	write64le(prefixHash, os);
+	write32le(checkpoints, os);
+	for (uint32 i = 0; i < checkpoints; i++)
+		write64le(currMovieData.inputHashes[i], os);
+
+	return os->ftell() - start;
+}
+
+static void StateRefError(const char* msg)
+{
+	if (!backupSavestates)	//If backups are disabled we can just resume normally since we can't restore so stop movie and inform user
+	{
+		FCEU_PrintError("%s\nUnable to restore backup, movie playback stopped.", msg);
+		FCEUI_StopMovie();
+	} else
+		FCEU_PrintError("%s", msg);
+}
+
+bool FCEUMOV_ReadStateRef(EMUFILE* is, uint32 size)
+{
+	load_successful = false;
+
+	FCEU_Guid guid = {};
+	int32 length, frame;
+	uint64 fullHash, prefixHash;
+	uint32 checkpoints;
+	if (size < 44 || is->fread(guid.data, 16) != 16 || !read32le(&length, is) || !read32le(&frame, is)
+		|| !read64le(&fullHash, is) || !read64le(&prefixHash, is) || !read32le(&checkpoints, is))
+		return false;
+	if (length < 0 || frame < 0 || checkpoints != (uint32)(std::min(frame, length) / MOVIE_INPUT_HASH_INTERVAL) || size != 44 + checkpoints * 8)
+		return false;
+	std::vector<uint64> hashes(checkpoints);
+	for (uint32 i = 0; i < checkpoints; i++)
+		if (!read64le(&hashes[i], is))
+			return false;
+
+	if(movieMode != MOVIEMODE_PLAY && movieMode != MOVIEMODE_RECORD && movieMode != MOVIEMODE_FINISHED)
+	{
+		load_successful = true;
+		return true;
+	}
+
+	CheckReadWriteStateLoad();
+
+	//there's no movie in the savestate to fall back on, so a mismatch always cancels the load
+	if (guid != currMovieData.guid)
+	{
+		char msg[256];
+		sprintf(msg, "Mismatch between savestate's movie and current movie.\ncurrent: %s\nsavestate: %s", currMovieData.guid.toString().c_str(), guid.toString().c_str());
+		StateRefError(msg);
+		return false;
+	}
+
+	int currLength = currMovieData.getNumRecords();
+	char msg[512];
+
+	if (movie_readonly)
+	{
+		if (movieMode == MOVIEMODE_RECORD)
+		{
+			movieMode = MOVIEMODE_PLAY;
+			RedumpWholeMovieFile(true);
+			closeRecordingMovie();
+		}
+
+		//same timeline up to min(current length, savestate length, savestate frame)
+		int end = std::min(currLength, std::min(length, frame));
+		int checked = end / MOVIE_INPUT_HASH_INTERVAL;
+		for (int i = 0; i < checked; i++)
+		{
+			if (currMovieData.getInputHash((i + 1) * MOVIE_INPUT_HASH_INTERVAL) != hashes[i])
+			{
+				sprintf(msg, "Error: Savestate not in the same timeline as movie!\nIt branches from current timeline between frames %d and %d", i * MOVIE_INPUT_HASH_INTERVAL, (i + 1) * MOVIE_INPUT_HASH_INTERVAL - 1);
+				StateRefError(msg);
+				return false;
+			}
+		}
+		if (end == std::min(length, frame) ? currMovieData.getInputHash(end) != prefixHash : end % MOVIE_INPUT_HASH_INTERVAL != 0)
+		{
+			//the remainder past the last checkpoint is only hashed together with the input up to the savestate frame
+			sprintf(msg, "Error: Savestate not in the same timeline as movie!\nIt branches from current timeline between frames %d and %d", checked * MOVIE_INPUT_HASH_INTERVAL, std::min(length, frame) - 1);
+			StateRefError(msg);
+			return false;
+		}
+		if (length < frame && length < currLength)
+		{
+			// this savestate doesn't contain enough input to be checked
+			sprintf(msg, "Savestate taken from a frame (%d) after the final frame in the savestated movie (%d) cannot be verified against current movie (%d). This is not permitted.", frame, length - 1, currLength - 1);
+			StateRefError(msg);
+			return false;
+		}
+
+		currFrameCounter = frame;
+		if (currFrameCounter < currLength)
+			movieMode = MOVIEMODE_PLAY;
+		else
+			FinishPlayback();
+	} else
+	{
+		//the savestate's input has to still be in the movie, since it isn't in the savestate
+		int needed = frame > length ? length : frame;
+		if (currLength < needed || currMovieData.getInputHash(needed) != (frame > length ? fullHash : prefixHash))
+		{
+			sprintf(msg, "Error: Savestate not in the same timeline as movie!\nThe input up to frame %d has changed since it was made.", needed);
+			StateRefError(msg);
+			return false;
+		}
+
+		closeRecordingMovie();
+		currFrameCounter = frame;
+
+		if (frame > length)
+		{
+			//This is a post movie savestate: the movie goes back to the length it had, then movie finished mode
+			currMovieData.truncateAt(length);
+			movieMode = MOVIEMODE_PLAY;
+			FCEUMOV_IncrementRerecordCount();
+			RedumpWholeMovieFile();
+			FinishPlayback();
+		} else
+		{
+			//a full load restores the savestate's movie length if the input past the frame is still the same;
+			//otherwise the current input past the frame is kept
+			if (!fullSaveStateLoads)
+				currMovieData.truncateAt(frame);
+			else if (currLength >= length && currMovieData.getInputHash(length) == fullHash)
+				currMovieData.truncateAt(length);
+
+			movieMode = MOVIEMODE_RECORD;
+			FCEUMOV_IncrementRerecordCount();
+			RedumpWholeMovieFile(true);
+		}
+	}
+
+	load_successful = true;
+
+	return true;
+}
+
 void FCEUMOV_PreLoad(void)
 {
 	load_successful=0;
@@ -1802,6 +2086,7 @@ void FCEUI_MovieInsertFrame()
 	{
 		strcpy(message, "1 frame inserted");
 		strcat(message, GetMovieModeStr());
+		currMovieData.invalidateInputHash(currFrameCounter);
 		std::vector<MovieRecord>::iterator iter = currMovieData.records.begin();
 		currMovieData.records.insert(iter + currFrameCounter, MovieRecord());
 		FCEUMOV_IncrementRerecordCount();
@@ -1828,6 +2113,7 @@ void FCEUI_MovieDeleteFrame()
 	else if (movieMode == MOVIEMODE_RECORD || movieMode == MOVIEMODE_PLAY)
 	{
 		strcpy(message, "1 frame deleted");
+		currMovieData.invalidateInputHash(currFrameCounter);
 		std::vector<MovieRecord>::iterator iter = currMovieData.records.begin();
 		currMovieData.records.erase(iter + currFrameCounter);
 		FCEUMOV_IncrementRerecordCount();
@@ -102,6 +102,8 @@ void FCEUI_SetLagFlag(bool value);
 
 int FCEUMOV_WriteState(EMUFILE* os);
 bool FCEUMOV_ReadState(EMUFILE* is, uint32 size);
+int FCEUMOV_WriteStateRef(EMUFILE* os);
+bool FCEUMOV_ReadStateRef(EMUFILE* is, uint32 size);
 void FCEUMOV_PreLoad();
 bool FCEUMOV_PostLoad();
 void FCEUMOV_IncrementRerecordCount();
@@ -111,6 +113,8 @@ bool FCEUMOV_FromPoweron();
 void FCEUMOV_CreateCleanMovie();
 void FCEUMOV_ClearCommands();
 
+#define MOVIE_INPUT_HASH_INTERVAL 1024
+
 class MovieData;
 class MovieRecord
 {
@@ -164,13 +168,15 @@ public:
 
 	bool Compare(MovieRecord& compareRec);
 	void Clone(MovieRecord& sourceRec);
+	uint64 hash(uint64 seed);
 	void clear();
 
-	void parse(MovieData* md, EMUFILE* is);
-	bool parseBinary(MovieData* md, EMUFILE* is);
+	//the parsers decode one record from [p, end) and return where it stopped
+	const uint8* parse(MovieData* md, const uint8* p, const uint8* end);
+	const uint8* parseBinary(MovieData* md, const uint8* p);
 	void dump(MovieData* md, EMUFILE* os, int index);
 	void dumpBinary(MovieData* md, EMUFILE* os, int index);
-	void parseJoy(EMUFILE* is, uint8& joystate);
+	const uint8* parseJoy(const uint8* p, const uint8* end, uint8& joystate);
 	void dumpJoy(EMUFILE* os, uint8 joystate);
 
 	static const char mnemonics[8];
@@ -255,6 +261,12 @@ public:
 	void insertEmpty(int at, int frames);
 	void cloneRegion(int at, int frames);
 
+	//rolling hash of the input, which in-memory savestates keep instead of the whole log (see FCEUMOV_WriteStateRef).
+	//inputHashes[i] covers records [0, (i+1)*MOVIE_INPUT_HASH_INTERVAL); whatever changes records must call invalidateInputHash.
+	uint64 getInputHash(int frames);
+	void invalidateInputHash(int frame);
+	std::vector<uint64> inputHashes;
+
 	static bool loadSavestateFrom(std::vector<uint8>* buf);
 	static void dumpSavestateTo(std::vector<uint8>* buf, int compressionLevel);
 
@@ -442,6 +442,7 @@ static DECLFR(NSF_read)
 		if(!fceuindbg)
 		{
 			memset(RAM,0x00,0x800);
+			FCEU_NoteWriteRange(0,0x7FF);
 
 			BWrite[0x4015](0x4015,0x0);
 			for(x=0;x<0x14;x++)
@@ -288,8 +288,37 @@ struct PPUREGS {
 	}
 } ppur;
 
-int newppu_get_scanline() { return ppur.status.sl; }
-int newppu_get_dot() { return ppur.status.cycle; }
+//Lazy catch-up for stretches where the new PPU only advances its counters (vblank).
+//The CPU is handed the whole stretch in a single X6502_Run instead of one dot at a time,
+//and the scanline/dot counters are brought up to the CPU position only when something
+//looks at them (PPU register access, debugger queries).
+//Only vblank is handled this way: the rendering lines sample PPU[1] and make A12-visible
+//fetches on every dot, so they still interleave with the CPU one dot at a time.
+static struct {
+	bool active;
+	int sl, cycle;		//PPU position when the stretch began
+	int lineDot;		//dot within the scanline at which the stretch began
+	int dots;			//length of the stretch
+	int64 start;		//CPU pixel timestamp (timestamp * 48 + X.count) when the stretch began
+} ppuCatchup;
+
+static void newppu_catchup()
+{
+	if (!ppuCatchup.active)
+		return;
+
+	int64 elapsed = ((int64)timestamp * 48 - ppuCatchup.start) / (PAL ? 15 : 16) + 1;
+	if (elapsed < 0)
+		elapsed = 0;
+	else if (elapsed > ppuCatchup.dots)
+		elapsed = ppuCatchup.dots;
+
+	ppur.status.sl = ppuCatchup.sl + (ppuCatchup.lineDot + (int)elapsed) / 341;
+	ppur.status.cycle = (ppuCatchup.cycle + (int)elapsed) % ppur.status.end_cycle;
+}
+
+int newppu_get_scanline() { newppu_catchup(); return ppur.status.sl; }
+int newppu_get_dot() { newppu_catchup(); return ppur.status.cycle; }
 void newppu_hacky_emergency_reset()
 {
 	if(ppur.status.end_cycle == 0)
@@ -461,9 +490,9 @@ int GetCHRAddress(int A)
 	if (cdloggerVideoDataSize) 
 	{
 		int result = -1;
-		if ( (A >= 0) && (A < 0x2000) )
+		if ( (A >= 0) && (A < 0x2000) && (CHRPageOffset[A >> 10] >= 0) )
 		{
-			result = &VPage[A >> 10][A] - CHRptr[0];
+			result = CHRPageOffset[A >> 10] + (A & 0x3FF);
 		}
 		if ((result >= 0) && (result < (int)cdloggerVideoDataSize))
 		{
@@ -1035,7 +1064,10 @@ static uint8 sprlinebuf[256 + 8];
 
 void FCEUPPU_LineUpdate(void) {
 	if (newppu)
+	{
+		newppu_catchup();
 		return;
+	}
 
 #ifdef FCEUDEF_DEBUGGER
 	if (!fceuindbg)
@@ -1995,13 +2027,51 @@ const int kLineTime = 341;
 const int kFetchTime = 2;
 
 void runppu(int x) {
-	ppur.status.cycle = (ppur.status.cycle + x) % ppur.status.end_cycle;
+	ppur.status.cycle += x;
+	if (ppur.status.cycle >= ppur.status.end_cycle)
+		ppur.status.cycle %= ppur.status.end_cycle;
 	if (!new_ppu_reset) // if resetting, suspend CPU until the first frame
 	{
 		X6502_Run(x);
 	}
 }
 
+//runs an idle stretch of the PPU starting at dot lineDot of the current scanline.
+//the scanline counter is advanced every time the stretch crosses the end of a line.
+static void runppu_idle(int lineDot, int dots)
+{
+	//the debugger wants exact positions when it breaks, so step it the slow way there
+	if (DebugCycleRequired())
+	{
+		for (int dot = 0; dot < dots; dot++)
+		{
+			runppu(1);
+			if (++lineDot == kLineTime)
+			{
+				lineDot = 0;
+				ppur.status.sl++;
+			}
+		}
+		return;
+	}
+
+	const int sl = ppur.status.sl;
+	const int cycle = ppur.status.cycle;
+
+	ppuCatchup.sl = sl;
+	ppuCatchup.cycle = cycle;
+	ppuCatchup.lineDot = lineDot;
+	ppuCatchup.dots = dots;
+	ppuCatchup.start = (int64)timestamp * 48 + X.count;
+	ppuCatchup.active = true;
+
+	runppu(dots);
+
+	ppuCatchup.active = false;
+	ppur.status.sl = sl + (lineDot + dots) / kLineTime;
+	ppur.status.cycle = (cycle + dots) % ppur.status.end_cycle;
+}
+
 //todo - consider making this a 3 or 4 slot fifo to keep from touching so much memory
 struct BGData {
 	struct Record {
@@ -2143,19 +2213,13 @@ int FCEUX_PPU_Loop(int skip) {
 		ppur.status.sl = 241;	//for sprite reads
 
 		//formerly: runppu(delay);
-		for(int dot=0;dot<delay;dot++)
-			runppu(1);
+		runppu_idle(0, delay);
 
 		if (VBlankON) TriggerNMI();
 		int sltodo = PAL?70:20;
 		
 		//formerly: runppu(20 * (kLineTime) - delay);
-		for(int S=0;S<sltodo;S++)
-		{
-			for(int dot=(S==0?delay:0);dot<kLineTime;dot++)
-				runppu(1);
-			ppur.status.sl++;
-		}
+		runppu_idle(delay, sltodo * kLineTime - delay);
 
 		//this seems to run just before the dummy scanline begins
 		PPU_status = 0;
@@ -1,8 +1,10 @@
 #include "retroachievements.h"
 
 #include "fceu.h"
+#include "file.h"
 #include "movie.h"
 #include "cheat.h"
+#include "utils\md5.h"
 
 #include "drivers\win\cdlogger.h"
 #include "drivers\win\cheat.h"
@@ -23,6 +25,9 @@
 
 #include "RA_BuildVer.h"
 
+#include <map>
+#include <sys/stat.h>
+
 extern HWND hPPUView; // not in ppuview.h
 extern void KillPPUView(); // not in ppuview.h
 extern HWND hGGConv; // not in cheat.h
@@ -31,6 +36,19 @@ extern HWND LuaConsoleHWnd; // not in fcelua.h
 
 int FDS_GameId = 0;
 
+// hash of the iNES image being loaded, computed by iNESLoad while the file is open (empty for other formats)
+static char NES_ImageHash[33];
+
+// hashes of previously loaded images, keyed on their path and the size and modification time of the file on disk
+struct HashCacheEntry
+{
+	uint64 size;
+	int64 mtime;
+	std::string hash;
+};
+static std::map<std::string, HashCacheEntry> hashCache;
+static bool hashCacheLoaded = false;
+
 static int GameIsActive()
 {
 	return 1;
@@ -155,12 +173,25 @@ static void LoadROM(const char* sFullPath)
 
 unsigned char ByteReader(unsigned int nOffs)
 {
+	// peek, so that reading registers doesn't change emulation state
 	if (GameInfo)
-		return static_cast<unsigned char>(ARead[nOffs](nOffs));
+		return FCEUI_MemSafePeek(static_cast<uint16>(nOffs));
 
 	return 0;
 }
 
+unsigned int ByteBlockReader(unsigned int nOffs, unsigned char* pBuffer, unsigned int nCount)
+{
+	if (!GameInfo || nOffs >= 0x10000)
+		return 0;
+
+	if (nCount > 0x10000 - nOffs)
+		nCount = 0x10000 - nOffs;
+
+	FCEUI_MemPeekBlock(static_cast<uint16>(nOffs), pBuffer, nCount);
+	return nCount;
+}
+
 void ByteWriter(unsigned int nOffs, uint8 nVal)
 {
 	if (GameInfo)
@@ -179,6 +210,7 @@ void RA_Init()
 	// register the system memory
 	RA_ClearMemoryBanks();
 	RA_InstallMemoryBank(0, ByteReader, ByteWriter, 0x10000);
+	RA_InstallMemoryBankBlockReader(0, ByteBlockReader);
 
 	// add a placeholder menu item and start the login process - menu will be updated when login completes
 	RebuildMenu();
@@ -188,6 +220,122 @@ void RA_Init()
 	RA_UpdateAppTitle("");
 }
 
+static std::string GetHashCacheFilename()
+{
+	return std::string(FCEUI_GetBaseDirectory()) + "\\RACache\\NESHashes.txt";
+}
+
+static void LoadHashCache()
+{
+	hashCacheLoaded = true;
+
+	FILE* fp = FCEUD_UTF8fopen(GetHashCacheFilename().c_str(), "rb");
+	if (!fp)
+		return;
+
+	// one entry per line: hash size mtime path
+	char line[4096 + 128];
+	while (fgets(line, sizeof(line), fp))
+	{
+		char hash[33];
+		unsigned long long size;
+		long long mtime;
+		int pathStart = 0;
+		if (sscanf(line, "%32s %llu %lld %n", hash, &size, &mtime, &pathStart) != 3 || !pathStart)
+			continue;
+
+		std::string path(line + pathStart);
+		while (!path.empty() && (path.back() == '\n' || path.back() == '\r'))
+			path.pop_back();
+
+		HashCacheEntry& entry = hashCache[path];
+		entry.size = size;
+		entry.mtime = mtime;
+		entry.hash = hash;
+	}
+	fclose(fp);
+}
+
+static void AddToHashCache(const std::string& path, const HashCacheEntry& entry)
+{
+	hashCache[path] = entry;
+
+	FILE* fp = FCEUD_UTF8fopen(GetHashCacheFilename().c_str(), "ab");
+	if (fp)
+	{
+		fprintf(fp, "%s %llu %lld %s\n", entry.hash.c_str(), (unsigned long long)entry.size, (long long)entry.mtime, path.c_str());
+		fclose(fp);
+	}
+}
+
+void RA_ClearNESImageHash()
+{
+	NES_ImageHash[0] = '\0';
+}
+
+void RA_HashNESImage(FCEUFILE* fp)
+{
+	// an unpatched image is identified by the file it came from, which may be an archive
+	std::string key, diskFile;
+	struct _stat64 st;
+	bool cacheable = false;
+	if (!fp->patched)
+	{
+		diskFile = fp->archiveFilename.empty() ? fp->filename : fp->archiveFilename;
+		key = fp->archiveFilename.empty() ? fp->filename : fp->archiveFilename + "|" + fp->filename;
+		cacheable = (_stat64(diskFile.c_str(), &st) == 0);
+	}
+
+	if (cacheable)
+	{
+		if (!hashCacheLoaded)
+			LoadHashCache();
+
+		std::map<std::string, HashCacheEntry>::const_iterator it = hashCache.find(key);
+		if (it != hashCache.end() && it->second.size == (uint64)st.st_size && it->second.mtime == (int64)st.st_mtime)
+		{
+			strcpy(NES_ImageHash, it->second.hash.c_str());
+			return;
+		}
+	}
+
+	// RetroAchievements hashes everything after the 16-byte header
+	struct md5_context md5;
+	MD5DATA digest;
+	md5_starts(&md5);
+
+	EMUFILE_MEMORY* ms = dynamic_cast<EMUFILE_MEMORY*>(fp->stream);
+	if (ms)
+	{
+		// archives and patched files are already in memory
+		if (ms->size() > 16)
+			md5_update(&md5, ms->buf() + 16, ms->size() - 16);
+	}
+	else
+	{
+		// stream the rest of a plain file through the open handle
+		uint8 buffer[0x10000];
+		long pos = fp->stream->ftell();
+		fp->stream->fseek(16, SEEK_SET);
+		size_t count;
+		while ((count = fp->stream->fread(buffer, sizeof(buffer))) > 0)
+			md5_update(&md5, buffer, (uint32)count);
+		fp->stream->fseek(pos, SEEK_SET);
+	}
+
+	md5_finish(&md5, digest.data);
+	strcpy(NES_ImageHash, md5_asciistr(digest));
+
+	if (cacheable)
+	{
+		HashCacheEntry entry;
+		entry.size = st.st_size;
+		entry.mtime = st.st_mtime;
+		entry.hash = NES_ImageHash;
+		AddToHashCache(key, entry);
+	}
+}
+
 void RA_IdentifyAndActivateGame()
 {
 	if (RA_HardcoreModeIsActive())
@@ -197,6 +345,10 @@ void RA_IdentifyAndActivateGame()
 	{
 		RA_ActivateGame(FDS_GameId);
 	}
+	else if (NES_ImageHash[0])
+	{
+		RA_ActivateGame(RA_IdentifyHash(NES_ImageHash));
+	}
 	else
 	{
 		// The file has been split into several buffers. rather than try to piece
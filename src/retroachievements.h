@@ -7,6 +7,10 @@ void RA_Init();
 void RA_IdentifyAndActivateGame();
 void RA_ProcessInputs();
 
+struct FCEUFILE;
+void RA_ClearNESImageHash();
+void RA_HashNESImage(FCEUFILE* fp);
+
 extern int FDS_GameId;
 
 #endif __RETROACHIEVEMENTS_H_
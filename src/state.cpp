@@ -61,6 +61,7 @@
 
 #include <vector>
 #include <fstream>
+#include <unordered_map>
 
 using namespace std;
 
@@ -190,32 +191,106 @@ static int WriteStateChunk(EMUFILE* os, int type, SFORMAT *sf)
 	return (bsize+5);
 }
 
-static SFORMAT *CheckS(SFORMAT *sf, uint32 tsize, char *desc)
+//an entry carrying some tag, in the order CheckS used to walk the tables. next is the
+//first candidate with that tag after the table this one sits in: a size mismatch on the
+//first match in a linked table gave up on that table only and went on after the link.
+struct SFCANDIDATE
 {
+	SFORMAT *sf;
+	uint32 next;
+};
+
+//tag -> candidates lookup for one top-level SFORMAT table, including the tables it links to.
+//built on first load and dropped whenever the extra state list changes.
+struct SFINDEX
+{
+	SFORMAT *root;
+	bool valid;
+	std::unordered_map<uint32, std::vector<SFCANDIDATE> > entries;
+};
+
+static std::vector<SFINDEX> stateIndexes;
+
+static uint32 SFTag(const char *desc)
+{
+	uint32 tag;
+	memcpy(&tag,desc,4);
+	return tag;
+}
+
+static void BuildStateIndex(std::unordered_map<uint32, std::vector<SFCANDIDATE> > &entries, SFORMAT *sf)
+{
+	std::vector<std::pair<uint32, size_t> > local;	//tag and list position of this table's own entries
+
 	while(sf->v)
 	{
 		if(sf->s==~0u)		// Link to another SFORMAT structure.
+			BuildStateIndex(entries,(SFORMAT *)sf->v);
+		else if(sf->desc)
 		{
-			SFORMAT *tmp;
-			if((tmp= CheckS((SFORMAT *)sf->v, tsize, desc) ))
-				return(tmp);
-			sf++;
-			continue;
-		}
-		if(!memcmp(desc,sf->desc,4))
-		{
-			if(tsize!=(sf->s&(~FCEUSTATE_FLAGS)))
-				return(0);
-			return(sf);
+			SFCANDIDATE c = { sf, 0 };
+			std::vector<SFCANDIDATE> &list = entries[SFTag(sf->desc)];
+			local.push_back(std::make_pair(SFTag(sf->desc), list.size()));
+			list.push_back(c);
 		}
 		sf++;
 	}
+
+	for(size_t i=0;i<local.size();i++)
+	{
+		std::vector<SFCANDIDATE> &list = entries[local[i].first];
+		list[local[i].second].next=(uint32)list.size();
+	}
+}
+
+static void InvalidateStateIndex(SFORMAT *sf)
+{
+	for(size_t i=0;i<stateIndexes.size();i++)
+		if(stateIndexes[i].root==sf)
+			stateIndexes[i].valid=false;
+}
+
+static SFINDEX *GetStateIndex(SFORMAT *sf)
+{
+	SFINDEX *index = NULL;
+	for(size_t i=0;i<stateIndexes.size();i++)
+		if(stateIndexes[i].root==sf)
+			index=&stateIndexes[i];
+	if(!index)
+	{
+		stateIndexes.push_back(SFINDEX());
+		index=&stateIndexes.back();
+		index->root=sf;
+		index->valid=false;
+	}
+	if(!index->valid)
+	{
+		index->entries.clear();
+		BuildStateIndex(index->entries,sf);
+		index->valid=true;
+	}
+	return index;
+}
+
+static SFORMAT *CheckS(SFINDEX *index, uint32 tsize, char *desc)
+{
+	std::unordered_map<uint32, std::vector<SFCANDIDATE> >::const_iterator it = index->entries.find(SFTag(desc));
+	if(it==index->entries.end())
+		return(0);
+
+	const std::vector<SFCANDIDATE> &list = it->second;
+	for(size_t i=0;i<list.size();i=list[i].next)
+	{
+		if(tsize==(list[i].sf->s&(~FCEUSTATE_FLAGS)))
+			return(list[i].sf);
+	}
 	return(0);
 }
 
 static bool ReadStateChunk(EMUFILE* is, SFORMAT *sf, int size)
 {
 	SFORMAT *tmp;
+	SFINDEX *index = GetStateIndex(sf);
 	int temp = is->ftell();
 
 	while(is->ftell()<temp+size)
@@ -227,7 +302,7 @@ static bool ReadStateChunk(EMUFILE* is, SFORMAT *sf, int size)
 
 		read32le(&tsize,is);
 
-		if((tmp=CheckS(sf,tsize,toa)))
+		if((tmp=CheckS(index,tsize,toa)))
 		{
 			if(tmp->s&FCEUSTATE_INDIRECT)
 				is->fread(*(char **)tmp->v,tmp->s&(~FCEUSTATE_FLAGS));
@@ -258,6 +333,7 @@ static bool ReadStateChunks(EMUFILE* is, int32 totalsize)
 
 	read_sfcpuc=0;
 	read_snd=0;
+	FCEU_NoteWriteRange(0,0xFFFF);
 
 	//mbg 6/16/08 - wtf
 	//// int moo=X.mooPI;
@@ -284,6 +360,11 @@ static bool ReadStateChunks(EMUFILE* is, int32 totalsize)
 					ret=false;
 			}
 			break;
+		case 9:
+			//movie reference: nothing has been restored yet, so just refuse the savestate
+			if(!FCEUMOV_ReadStateRef(is,size))
+				return false;
+			break;
 		case 0x10:
 			if(!ReadStateChunk(is,SFMDATA,size)) 
 				ret=false; 
@@ -378,7 +459,7 @@ int CurrentState=0;
 extern int geniestage;
 
 
-bool FCEUSS_SaveMS(EMUFILE* outstream, int compressionLevel)
+bool FCEUSS_SaveMS(EMUFILE* outstream, int compressionLevel, bool embedMovie)
 {
 	// reinit memory_savestate
 	// memory_savestate is global variable which already has its vector of bytes, so no need to allocate memory every time we use save/loadstate
@@ -389,9 +470,22 @@ bool FCEUSS_SaveMS(EMUFILE* outstream, int compressionLevel)
 
 	uint32 totalsize = 0;
 
+	//a reference to the movie goes first, so that loading it can be refused before anything else is restored
+	if(!embedMovie && FCEUMOV_Mode(MOVIEMODE_PLAY|MOVIEMODE_RECORD|MOVIEMODE_FINISHED))
+	{
+		os->fseek(5,SEEK_CUR);
+		int size = FCEUMOV_WriteStateRef(os);
+		os->fseek(-(size+5),SEEK_CUR);
+		os->fputc(9);
+		write32le(size, os);
+		os->fseek(size,SEEK_CUR);
+
+		totalsize += 5 + size;
+	}
+
 	FCEUPPU_SaveState();
 	FCEUSND_SaveState();
-	totalsize=WriteStateChunk(os,1,SFCPU);
+	totalsize+=WriteStateChunk(os,1,SFCPU);
 	totalsize+=WriteStateChunk(os,2,SFCPUC);
 	totalsize+=WriteStateChunk(os,3,FCEUPPU_STATEINFO);
 	totalsize+=WriteStateChunk(os,31,FCEU_NEWPPU_STATEINFO);
@@ -403,7 +497,7 @@ bool FCEUSS_SaveMS(EMUFILE* outstream, int compressionLevel)
 
 		//MBG TAS Editor HACK HACK HACK!
 		//do not save the movie state if we are in Taseditor! That would be a huge waste of time and space!
-		if(!FCEUMOV_Mode(MOVIEMODE_TASEDITOR))
+		if(embedMovie && !FCEUMOV_Mode(MOVIEMODE_TASEDITOR))
 		{
 			os->fseek(5,SEEK_CUR);
 			int size = FCEUMOV_WriteState(os);
@@ -465,6 +559,137 @@ bool FCEUSS_SaveMS(EMUFILE* outstream, int compressionLevel)
 	return error == Z_OK;
 }
 
+//raw snapshots: every SFORMAT region copied back to back with no tags or sizes.
+//the layout is only meaningful within the running session, so these must never be written to disk.
+struct RAWREGION
+{
+	SFORMAT *sf;
+	uint32 size;
+};
+
+static std::vector<RAWREGION> rawLayout;
+static size_t rawLayoutSize;
+static size_t rawLayoutExStart;		//first region belonging to SFMDATA
+static bool rawLayoutValid = false;
+static uint32 rawLayoutGeneration = 0;
+
+#define RAWSTATE_HEADER_SIZE 16
+
+static void InvalidateRawLayout()
+{
+	rawLayoutValid = false;
+	rawLayoutGeneration++;
+}
+
+static void AddRawRegions(SFORMAT *sf)
+{
+	while(sf->v)
+	{
+		if(sf->s==~0u)		// Link to another SFORMAT structure.
+			AddRawRegions((SFORMAT *)sf->v);
+		else if(sf->s&(~FCEUSTATE_FLAGS))
+		{
+			RAWREGION r = { sf, sf->s&(~FCEUSTATE_FLAGS) };
+			rawLayout.push_back(r);
+			rawLayoutSize += r.size;
+		}
+		sf++;
+	}
+}
+
+static void BuildRawLayout()
+{
+	rawLayout.clear();
+	rawLayoutSize = RAWSTATE_HEADER_SIZE + 256*256;	//header and back buffer
+	AddRawRegions(SFCPU);
+	AddRawRegions(SFCPUC);
+	AddRawRegions(FCEUPPU_STATEINFO);
+	AddRawRegions(FCEU_NEWPPU_STATEINFO);
+	AddRawRegions(FCEUCTRL_STATEINFO);
+	AddRawRegions(FCEUSND_STATEINFO);
+	rawLayoutExStart = rawLayout.size();
+	AddRawRegions(SFMDATA);
+	rawLayoutValid = true;
+}
+
+static INLINE uint8 *RawRegionPtr(const RAWREGION &r)
+{
+	if(r.sf->s&FCEUSTATE_INDIRECT)
+		return *(uint8 **)r.sf->v;
+	return (uint8 *)r.sf->v;
+}
+
+bool FCEUSS_SaveRaw(EMUFILE_MEMORY* outstream)
+{
+	//the movie state and log can't be flattened, let the caller use the tagged format then
+	if(FCEUMOV_Mode(MOVIEMODE_PLAY|MOVIEMODE_RECORD|MOVIEMODE_FINISHED))
+		return false;
+
+	if(!rawLayoutValid)
+		BuildRawLayout();
+
+	std::vector<u8> *vec = outstream->get_vec();
+	if(vec->size() < rawLayoutSize)
+		vec->resize(rawLayoutSize);
+	outstream->set_len(rawLayoutSize);
+	outstream->fseek(0,SEEK_SET);
+	uint8 *dst = &(*vec)[0];
+
+	memcpy(dst,"FCSR",4);
+	FCEU_en32lsb(dst+4, rawLayoutGeneration);
+	FCEU_en32lsb(dst+8, rawLayoutSize);
+	FCEU_en32lsb(dst+12, 0);	//reserved
+	dst += RAWSTATE_HEADER_SIZE;
+
+	FCEUPPU_SaveState();
+	FCEUSND_SaveState();
+	for(size_t i=0;i<rawLayout.size();i++)
+	{
+		if(i==rawLayoutExStart && SPreSave) SPreSave();
+		memcpy(dst,RawRegionPtr(rawLayout[i]),rawLayout[i].size);
+		dst += rawLayout[i].size;
+	}
+	if(SPostSave) SPostSave();
+
+	extern uint8 *XBackBuf;
+	memcpy(dst,XBackBuf,256*256);
+	return true;
+}
+
+bool FCEUSS_LoadRaw(EMUFILE_MEMORY* is)
+{
+	if(is->size() < RAWSTATE_HEADER_SIZE)
+		return false;
+	const uint8 *src = is->buf();
+	if(memcmp(src,"FCSR",4))
+		return false;
+	//made before the extra state list changed (another game, or a mapper re-registering), the layout no longer fits
+	if(!rawLayoutValid || FCEU_de32lsb((uint8*)src+4) != rawLayoutGeneration
+		|| FCEU_de32lsb((uint8*)src+8) != rawLayoutSize || is->size() < rawLayoutSize)
+		return false;
+	if(FCEUMOV_Mode(MOVIEMODE_PLAY|MOVIEMODE_RECORD|MOVIEMODE_FINISHED))
+		return false;
+	src += RAWSTATE_HEADER_SIZE;
+
+	FCEUMOV_PreLoad();
+	for(size_t i=0;i<rawLayout.size();i++)
+	{
+		memcpy(RawRegionPtr(rawLayout[i]),src,rawLayout[i].size);
+		src += rawLayout[i].size;
+	}
+	extern uint8 *XBackBuf;
+	memcpy(XBackBuf,src,256*256);
+	FCEU_NoteWriteRange(0,0xFFFF);
+
+	if(GameStateRestore)
+		GameStateRestore(FCEU_VERSION_NUMERIC);
+	FCEUPPU_LoadState(FCEU_VERSION_NUMERIC);
+	FCEUSND_LoadState(FCEU_VERSION_NUMERIC);
+	extern int resetDMCacc;
+	resetDMCacc=0;
+	return FCEUMOV_PostLoad();
+}
+
 
 void FCEUSS_Save(const char *fname, bool display_message)
 {
@@ -662,6 +887,9 @@ bool FCEUSS_LoadFP(EMUFILE* is, ENUM_SSLOADPARAMS params)
 	uint8 header[16];
 	//read and analyze the header
 	is->fread((char*)&header,16);
+	//raw snapshots only load through FCEUSS_LoadRaw, one that got here is stale
+	if(!memcmp(header,"FCSR",4))
+		return false;
 	if(memcmp(header,"FCSX",4)) {
 		//its not an fceux save file.. perhaps it is an fceu savefile
 		is->fseek(0,SEEK_SET);
@@ -877,6 +1105,8 @@ void ResetExState(void (*PreSave)(void), void (*PostSave)(void))
 	SPreSave = PreSave;
 	SPostSave = PostSave;
 	SFEXINDEX=0;
+	InvalidateStateIndex(SFMDATA);
+	InvalidateRawLayout();
 }
 
 void AddExState(void *v, uint32 s, int type, const char *desc)
@@ -929,6 +1159,8 @@ void AddExState(void *v, uint32 s, int type, const char *desc)
 		}
 	}
 	SFMDATA[SFEXINDEX].v=0;		// End marker.
+	InvalidateStateIndex(SFMDATA);
+	InvalidateRawLayout();
 }
 
 void FCEUI_SelectStateNext(int n)
@@ -1308,7 +1540,11 @@ class StateRecorder
 
 					em->set_len(0);
 
-					FCEUSS_SaveMS( em, compressionLevel );
+					// uncompressed snapshots never leave memory, so they can skip the tagged format
+					if ( (compressionLevel != Z_NO_COMPRESSION) || !FCEUSS_SaveRaw( em ) )
+					{
+						FCEUSS_SaveMS( em, compressionLevel, false );
+					}
 
 					//printf("Frame:%u  Save:%i  Size:%zu  Total:%zukB \n", frameCounter, ringHead, em->size(), dataSize() / 1024 );
 
@@ -1351,7 +1587,10 @@ class StateRecorder
 
 			em->fseek(SEEK_SET, 0);
 
-			FCEUSS_LoadFP( em, SSLOADPARAM_NOBACKUP );
+			if ( !FCEUSS_LoadRaw( em ) )
+			{
+				FCEUSS_LoadFP( em, SSLOADPARAM_NOBACKUP );
+			}
 
 			frameCounter = lastLoadFrame = static_cast<unsigned int>(currFrameCounter);
 
@@ -30,10 +30,17 @@ void FCEUSS_Save(const char *, bool display_message=true);
 bool FCEUSS_Load(const char *, bool display_message=true);
 
  //zlib values: 0 (none) through 9 (max) or -1 (default)
-bool FCEUSS_SaveMS(EMUFILE* outstream, int compressionLevel);
+ //embedMovie=false keeps only a reference to the current movie's input (see FCEUMOV_WriteStateRef), for savestates that stay in memory
+bool FCEUSS_SaveMS(EMUFILE* outstream, int compressionLevel, bool embedMovie = true);
 
 bool FCEUSS_LoadFP(EMUFILE* is, ENUM_SSLOADPARAMS params);
 
+//in-memory snapshot without tags: a flat copy of every registered state region.
+//only valid for the current game session, never write these to disk. both return false when the caller
+//should use FCEUSS_SaveMS/FCEUSS_LoadFP instead (movie active, or the state layout changed since saving).
+bool FCEUSS_SaveRaw(EMUFILE_MEMORY* outstream);
+bool FCEUSS_LoadRaw(EMUFILE_MEMORY* is);
+
 extern int CurrentState;
 void FCEUSS_CheckStates(void);
 
@@ -45,45 +45,58 @@ void (*MapIRQHook)(int a);
 }
 
 //normal memory read
-static INLINE uint8 RdMem(unsigned int A)
+//the HOOKS template argument is false for the fast loop, which leaves out the lua memory hooks
+template<bool HOOKS>
+static INLINE uint8 RdMemT(unsigned int A)
 {
  _DB=ARead[A](A);
  #ifdef _S9XLUA_H
- CallRegisteredLuaMemHook(A, 1, _DB, LUAMEMHOOK_READ);
+ if(HOOKS) CallRegisteredLuaMemHook(A, 1, _DB, LUAMEMHOOK_READ);
  #endif
  return(_DB);
 }
 
 //normal memory write
-static INLINE void WrMem(unsigned int A, uint8 V)
+template<bool HOOKS>
+static INLINE void WrMemT(unsigned int A, uint8 V)
 {
 	BWrite[A](A,V);
 	#ifdef _S9XLUA_H
-	CallRegisteredLuaMemHook(A, 1, V, LUAMEMHOOK_WRITE);
+	if(HOOKS) CallRegisteredLuaMemHook(A, 1, V, LUAMEMHOOK_WRITE);
 	#endif
     _DB = V;
 }
 
-static INLINE uint8 RdRAM(unsigned int A)
+template<bool HOOKS>
+static INLINE uint8 RdRAMT(unsigned int A)
 {
   _DB=ARead[A](A);
   #ifdef _S9XLUA_H
-  CallRegisteredLuaMemHook(A, 1, _DB, LUAMEMHOOK_READ);
+  if(HOOKS) CallRegisteredLuaMemHook(A, 1, _DB, LUAMEMHOOK_READ);
   #endif
   //bbit edited: this was changed so cheat substituion would work
   // return(_DB=RAM[A]);
   return(_DB);
 }
 
-static INLINE void WrRAM(unsigned int A, uint8 V)
+template<bool HOOKS>
+static INLINE void WrRAMT(unsigned int A, uint8 V)
 {
 	RAM[A]=V;
+	FCEU_NoteWrite(A);
 	#ifdef _S9XLUA_H
-	CallRegisteredLuaMemHook(A, 1, V, LUAMEMHOOK_WRITE);
+	if(HOOKS) CallRegisteredLuaMemHook(A, 1, V, LUAMEMHOOK_WRITE);
 	#endif
     _DB = V;
 }
 
+//the opcode macros below (and ops.inc) expand inside X6502_RunLoop<HOOKS>,
+//so these pick up the memory access variant of whichever loop is being built
+#define RdMem(A) RdMemT<HOOKS>(A)
+#define WrMem(A,V) WrMemT<HOOKS>(A,V)
+#define RdRAM(A) RdRAMT<HOOKS>(A)
+#define WrRAM(A,V) WrRAMT<HOOKS>(A,V)
+
 uint8 X6502_DMR(uint32 A)
 {
  ADDCYC(1);
@@ -436,7 +449,7 @@ void X6502_Power(void)
  StackAddrBackup = -1;
 }
 
-void X6502_Run(int32 cycles)
+static INLINE void X6502_AddCycles(int32 cycles)
 {
   if(PAL)
    cycles*=15;    // 15*4=60
@@ -444,6 +457,11 @@ void X6502_Run(int32 cycles)
    cycles*=16;    // 16*4=64
 
   _count+=cycles;
+}
+
+template<bool HOOKS>
+static void X6502_RunLoop()
+{
 extern int test; test++;
   while(_count>0)
   {
@@ -454,7 +472,7 @@ extern int test; test++;
    {
     if(_IRQlow&FCEU_IQRESET)
     {
-	 DEBUG( if(debug_loggingCD) LogCDVectors(0xFFFC); )
+	 DEBUG( if(HOOKS && debug_loggingCD) LogCDVectors(0xFFFC); )
      _PC=RdMem(0xFFFC);
      _PC|=RdMem(0xFFFD)<<8;
      _jammed=0;
@@ -475,7 +493,7 @@ extern int test; test++;
       PUSH(_PC);
       PUSH((_P&~B_FLAG)|(U_FLAG));
       _P|=I_FLAG;
-	  DEBUG( if(debug_loggingCD) LogCDVectors(0xFFFA) );
+	  DEBUG( if(HOOKS && debug_loggingCD) LogCDVectors(0xFFFA) );
       _PC=RdMem(0xFFFA);
       _PC|=RdMem(0xFFFB)<<8;
       _IRQlow&=~FCEU_IQNMI;
@@ -490,7 +508,7 @@ extern int test; test++;
       PUSH(_PC);
       PUSH((_P&~B_FLAG)|(U_FLAG));
       _P|=I_FLAG;
-	  DEBUG( if(debug_loggingCD) LogCDVectors(0xFFFE) );
+	  DEBUG( if(HOOKS && debug_loggingCD) LogCDVectors(0xFFFE) );
       _PC=RdMem(0xFFFE);
       _PC|=RdMem(0xFFFF)<<8;
      }
@@ -505,8 +523,9 @@ extern int test; test++;
    }
 
 	//will probably cause a major speed decrease on low-end systems
-   DEBUG( DebugCycle() );
+   DEBUG( if(HOOKS) DebugCycle() );
 
+   //kept in the fast loop too: tool windows use the count to see that emulation is running
    IncrementInstructionsCounters();
 
    _PI=_P;
@@ -521,7 +540,7 @@ extern int test; test++;
    if (!overclocking)
     FCEU_SoundCPUHook(temp);
    #ifdef _S9XLUA_H
-   CallRegisteredLuaMemHook(_PC, 1, 0, LUAMEMHOOK_EXEC);
+   if(HOOKS) CallRegisteredLuaMemHook(_PC, 1, 0, LUAMEMHOOK_EXEC);
    #endif
    _PC++;
    switch(b1)
@@ -531,6 +550,33 @@ extern int test; test++;
   }
 }
 
+void X6502_RunDebug(int32 cycles)
+{
+ X6502_AddCycles(cycles);
+ X6502_RunLoop<true>();
+}
+
+void X6502_RunFast(int32 cycles)
+{
+ X6502_AddCycles(cycles);
+ X6502_RunLoop<false>();
+}
+
+void X6502_Run(int32 cycles)
+{
+ X6502_AddCycles(cycles);
+
+ //the new ppu hands out one dot at a time, most of which land in the middle of an
+ //instruction that was already executed. nothing to do until the budget covers the next one.
+ if(_count<=0)
+  return;
+
+ if(DebugCycleRequired())
+  X6502_RunLoop<true>();
+ else
+  X6502_RunLoop<false>();
+}
+
 //--------------------------
 //---Called from debuggers
 void FCEUI_NMI(void)
@@ -547,12 +593,12 @@ void FCEUI_GetIVectors(uint16 *reset, uint16 *irq, uint16 *nmi)
 {
  fceuindbg=1;
 
- *reset=RdMem(0xFFFC);
- *reset|=RdMem(0xFFFD)<<8;
- *nmi=RdMem(0xFFFA);
- *nmi|=RdMem(0xFFFB)<<8;
- *irq=RdMem(0xFFFE);
- *irq|=RdMem(0xFFFF)<<8;
+ *reset=RdMemT<true>(0xFFFC);
+ *reset|=RdMemT<true>(0xFFFD)<<8;
+ *nmi=RdMemT<true>(0xFFFA);
+ *nmi|=RdMemT<true>(0xFFFB)<<8;
+ *irq=RdMemT<true>(0xFFFE);
+ *irq|=RdMemT<true>(0xFFFF)<<8;
  fceuindbg=0;
 }
 
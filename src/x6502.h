@@ -45,8 +45,13 @@ void X6502_Debug(void (*CPUHook)(X6502 *),
 //#else
 //void X6502_Run(int32 cycles);
 //#endif
+
+//X6502_RunDebug is the fully instrumented loop (debugger, CDL, trace logger, lua memory hooks).
+//X6502_RunFast is built from the same ops.inc with all of that compiled out.
+//X6502_Run picks between them each time it is entered, see DebugCycleRequired().
 void X6502_RunDebug(int32 cycles);
-#define X6502_Run(x) X6502_RunDebug(x)
+void X6502_RunFast(int32 cycles);
+void X6502_Run(int32 cycles);
 //------------
 
 extern uint32 timestamp;